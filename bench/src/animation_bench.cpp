@@ -0,0 +1,176 @@
+#include "src/config/prototype2Config.h"
+#include "src/system/assets/model_manager.h"
+#include "src/system/assets/texture_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Headless benchmark of animation sampling. Loads an animated model,
+// gives a number of characters clips that switch and blend like those
+// of the character system and reports the cost of each
+// ModelManager::sampleAnimation call as JSON.
+//
+// usage: prototype2_animation_bench [--model <model file>]
+//                                   [--characters <n>] [--steps <m>]
+//                                   [--threads <k>] [--set-clips]
+//                                   [--output <json file>]
+//
+// --threads sets the number of threads that sample the characters.
+// --set-clips calls AnimationClip::setClip for every clip every step,
+// which forces the clip name to be resolved on every sample
+
+namespace {
+    struct Options {
+        std::string model = "flygy/flygy.fbx";
+        size_t nCharacters = 100;
+        size_t nSteps = 1000;
+        size_t nThreads = 1;
+        bool setClips = false;
+        std::string output;
+    };
+
+    // clip names used by the character system
+    char const * clipNames[] = { "idle", "walk", "run", "jump", "fall", "land" };
+    static constexpr size_t numClipNames = sizeof(clipNames) / sizeof(clipNames[0]);
+
+    bool parseOptions(int argc, char * argv[], Options & options) {
+        for (int i = 1; i < argc; ++i) {
+            bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--model") == 0 && hasValue) {
+                options.model = argv[++i];
+            } else if (strcmp(argv[i], "--characters") == 0 && hasValue) {
+                options.nCharacters = std::strtoul(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--steps") == 0 && hasValue) {
+                options.nSteps = std::strtoul(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+                options.nThreads = std::strtoul(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--set-clips") == 0) {
+                options.setClips = true;
+            } else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+                options.output = argv[++i];
+            } else {
+                return false;
+            }
+        }
+        return options.nSteps > 0 && options.nThreads > 0;
+    }
+
+    std::string escape(std::string const & str) {
+        std::string escaped;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    double percentile(prt::vector<double> & values, double p) {
+        std::sort(values.data(), values.data() + values.size());
+        size_t index = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[std::min(std::max(index, size_t(1)), values.size()) - 1];
+    }
+}
+
+int main(int argc, char * argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [--model <model file>]"
+                  << " [--characters <n>] [--steps <m>] [--threads <k>] [--set-clips]"
+                  << " [--output <json file>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TextureManager textureManager(RESOURCE_PATH "textures/");
+    ModelManager modelManager(RESOURCE_PATH "models/", textureManager);
+    ModelID modelID = modelManager.loadModel(options.model.c_str(), true);
+    if (modelID == -1) {
+        std::cerr << "failed to load model " << options.model << std::endl;
+        return EXIT_FAILURE;
+    }
+    modelManager.setSamplingThreads(options.nThreads);
+
+    prt::vector<ModelID> modelIDs;
+    prt::vector<AnimationComponent> components;
+    for (size_t i = 0; i < options.nCharacters; ++i) {
+        modelIDs.push_back(modelID);
+        components.push_back({});
+        AnimationComponent & component = components.back();
+        component.clipA.setClip(clipNames[i % numClipNames]);
+        component.clipB.setClip(clipNames[(i + 1) % numClipNames]);
+        component.clipA.m_loop = true;
+        component.clipB.m_loop = true;
+        component.clipA.m_time = 0.1f * i;
+        component.clipB.m_time = 0.1f * i;
+        component.blendFactor = 0.0f;
+    }
+
+    static constexpr float deltaTime = 1.0f / 60.0f;
+    prt::vector<BoneTransform> transforms;
+    prt::vector<double> stepTimes;
+    stepTimes.reserve(options.nSteps);
+    for (size_t step = 0; step < options.nSteps; ++step) {
+        for (size_t i = 0; i < components.size(); ++i) {
+            AnimationComponent & component = components[i];
+            // a third of the characters blend between two clips
+            component.blendFactor = i % 3 == 0 ? 0.5f + 0.5f * std::sin(step * deltaTime + i) : 0.0f;
+            component.clipA.update(deltaTime);
+            component.clipB.update(deltaTime);
+            if (options.setClips) {
+                component.clipA.setClip(clipNames[i % numClipNames]);
+                component.clipB.setClip(clipNames[(i + 1) % numClipNames]);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        modelManager.sampleAnimation(modelIDs.data(), components.data(), transforms, components.size());
+        stepTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    double mean = 0.0;
+    for (double time : stepTimes) {
+        mean += time;
+    }
+    mean /= stepTimes.size();
+    double p50 = percentile(stepTimes, 0.5);
+    double p99 = percentile(stepTimes, 0.99);
+    double maxTime = stepTimes.back();
+
+    size_t uncompressedBytes;
+    size_t compressedBytes;
+    modelManager.getModel(modelID).getAnimationMemoryUsage(uncompressedBytes, compressedBytes);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"model\": \"" << escape(options.model) << "\",\n"
+         << "  \"bones\": " << modelManager.getModel(modelID).getNumBones() << ",\n"
+         << "  \"characters\": " << components.size() << ",\n"
+         << "  \"steps\": " << options.nSteps << ",\n"
+         << "  \"threads\": " << options.nThreads << ",\n"
+         << "  \"set_clips\": " << (options.setClips ? "true" : "false") << ",\n"
+         << "  \"animation_bytes\": { \"uncompressed\": " << uncompressedBytes
+         << ", \"compressed\": " << compressedBytes << " },\n"
+         << "  \"ms_per_step\": { \"mean\": " << mean << ", \"p50\": " << p50
+         << ", \"p99\": " << p99 << ", \"max\": " << maxTime << " }\n"
+         << "}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(options.output);
+        if (!file.is_open()) {
+            std::cerr << "failed to open " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+        file << json.str();
+    }
+    return EXIT_SUCCESS;
+}
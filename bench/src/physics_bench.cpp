@@ -0,0 +1,443 @@
+#include "src/config/prototype2Config.h"
+#include "src/game/system/physics/physics_system.h"
+#include "src/game/system/physics/static_aabb_tree.h"
+#include "src/memory/container_allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Headless benchmark of character physics. Builds a PhysicsSystem
+// from a level mesh or a procedural level, spawns capsule characters
+// that follow scripted movement and reports the cost of each
+// updateCharacters step as JSON. The bounds of the level's meshes
+// are also put in a dynamic and a static aabb tree, to compare their
+// memory and the cost of queries on real level geometry.
+//
+// usage: prototype2_bench [--level <obj file> | --procedural]
+//                         [--characters <n>] [--steps <m>]
+//                         [--tree-budget <k>] [--output <json file>]
+
+namespace {
+    struct Options {
+        std::string level = RESOURCE_PATH "models/level1/level1.obj";
+        bool procedural = false;
+        size_t nCharacters = 100;
+        size_t nSteps = 1000;
+        unsigned int treeBudget = 0;
+        std::string output;
+    };
+
+    struct Level {
+        prt::vector<glm::vec3> vertices;
+        prt::vector<unsigned int> meshSizes;
+    };
+
+    // reads positions and faces of a wavefront obj file, with
+    // one mesh per object or group and faces triangulated as fans
+    bool loadObj(char const * path, Level & level) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        prt::vector<glm::vec3> positions;
+        size_t meshStart = 0;
+        auto endMesh = [&]() {
+            if (level.vertices.size() > meshStart) {
+                level.meshSizes.push_back(level.vertices.size() - meshStart);
+                meshStart = level.vertices.size();
+            }
+        };
+
+        std::string line;
+        prt::vector<int> face;
+        while (std::getline(file, line)) {
+            std::istringstream stream(line);
+            std::string type;
+            stream >> type;
+            if (type == "v") {
+                glm::vec3 position;
+                stream >> position.x >> position.y >> position.z;
+                positions.push_back(position);
+            } else if (type == "o" || type == "g") {
+                endMesh();
+            } else if (type == "f") {
+                face.resize(0);
+                std::string vertex;
+                while (stream >> vertex) {
+                    // v, v/vt, v//vn or v/vt/vn, negative indices are relative
+                    int index = std::atoi(vertex.c_str());
+                    index = index < 0 ? int(positions.size()) + index : index - 1;
+                    if (index < 0 || size_t(index) >= positions.size()) {
+                        return false;
+                    }
+                    face.push_back(index);
+                }
+                for (size_t i = 2; i < face.size(); ++i) {
+                    level.vertices.push_back(positions[face[0]]);
+                    level.vertices.push_back(positions[face[i - 1]]);
+                    level.vertices.push_back(positions[face[i]]);
+                }
+            }
+        }
+        endMesh();
+        return !level.vertices.empty();
+    }
+
+    // rolling terrain in chunks with a scattering of pillars
+    void generateLevel(Level & level) {
+        static constexpr unsigned int size = 128;
+        static constexpr unsigned int chunkSize = 16;
+        static constexpr float cellSize = 1.0f;
+        auto height = [](float x, float z) {
+            return 2.0f * std::sin(0.15f * x) * std::cos(0.1f * z);
+        };
+        auto vertex = [&](unsigned int x, unsigned int z) {
+            glm::vec3 v = { x * cellSize, 0.0f, z * cellSize };
+            v.y = height(v.x, v.z);
+            return v;
+        };
+        for (unsigned int cz = 0; cz < size; cz += chunkSize) {
+            for (unsigned int cx = 0; cx < size; cx += chunkSize) {
+                size_t start = level.vertices.size();
+                for (unsigned int z = cz; z < cz + chunkSize; ++z) {
+                    for (unsigned int x = cx; x < cx + chunkSize; ++x) {
+                        level.vertices.push_back(vertex(x, z));
+                        level.vertices.push_back(vertex(x, z + 1));
+                        level.vertices.push_back(vertex(x + 1, z + 1));
+                        level.vertices.push_back(vertex(x, z));
+                        level.vertices.push_back(vertex(x + 1, z + 1));
+                        level.vertices.push_back(vertex(x + 1, z));
+                    }
+                }
+                level.meshSizes.push_back(level.vertices.size() - start);
+            }
+        }
+
+        // pillars, as boxes without top and bottom
+        for (unsigned int z = 8; z < size; z += 16) {
+            for (unsigned int x = 8; x < size; x += 16) {
+                size_t start = level.vertices.size();
+                glm::vec3 lower = { x - 1.0f, height(x, z) - 3.0f, z - 1.0f };
+                glm::vec3 upper = { x + 1.0f, height(x, z) + 6.0f, z + 1.0f };
+                glm::vec3 corners[4] = { { lower.x, 0.0f, lower.z }, { upper.x, 0.0f, lower.z },
+                                         { upper.x, 0.0f, upper.z }, { lower.x, 0.0f, upper.z } };
+                for (int i = 0; i < 4; ++i) {
+                    glm::vec3 a = corners[i];
+                    glm::vec3 b = corners[(i + 1) % 4];
+                    glm::vec3 a0 = { a.x, lower.y, a.z };
+                    glm::vec3 a1 = { a.x, upper.y, a.z };
+                    glm::vec3 b0 = { b.x, lower.y, b.z };
+                    glm::vec3 b1 = { b.x, upper.y, b.z };
+                    level.vertices.push_back(a0);
+                    level.vertices.push_back(b0);
+                    level.vertices.push_back(b1);
+                    level.vertices.push_back(a0);
+                    level.vertices.push_back(b1);
+                    level.vertices.push_back(a1);
+                }
+                level.meshSizes.push_back(level.vertices.size() - start);
+            }
+        }
+    }
+
+    struct TreeStatistics {
+        size_t memory = 0;
+        double usPerQuery = 0.0;
+        double usPerRaycast = 0.0;
+        uint64_t queryHits = 0;
+        uint64_t raycastLeaves = 0;
+    };
+
+    // times character sized aabb queries and raycasts from the same
+    // points, the raycasts visit every leaf along the ray
+    template<typename Tree>
+    TreeStatistics benchmarkTree(Tree & tree, prt::vector<AABB> const & queries,
+                                 glm::vec3 const & rayDirection, float rayDistance) {
+        TreeStatistics statistics;
+        statistics.memory = tree.memoryUsage();
+
+        prt::vector<ColliderIndex> meshIndices;
+        prt::vector<ColliderIndex> capsuleIndices;
+        prt::vector<ColliderIndex> heightfieldIndices;
+        auto start = std::chrono::steady_clock::now();
+        for (AABB const & query : queries) {
+            meshIndices.resize(0);
+            tree.query(ColliderTag{}, query, meshIndices, capsuleIndices, heightfieldIndices, COLLIDER_TYPE_COLLIDE);
+            statistics.queryHits += meshIndices.size();
+        }
+        auto end = std::chrono::steady_clock::now();
+        statistics.usPerQuery = std::chrono::duration<double, std::micro>(end - start).count() / queries.size();
+
+        start = std::chrono::steady_clock::now();
+        for (AABB const & query : queries) {
+            tree.raycast(query.lowerBound, rayDirection, rayDistance, [&](ColliderTag, float distance) {
+                ++statistics.raycastLeaves;
+                return distance;
+            });
+        }
+        end = std::chrono::steady_clock::now();
+        statistics.usPerRaycast = std::chrono::duration<double, std::micro>(end - start).count() / queries.size();
+        return statistics;
+    }
+
+    std::string treeJson(TreeStatistics const & statistics, size_t nQueries) {
+        std::ostringstream json;
+        json << "{ \"memory_kib\": " << statistics.memory / 1024.0
+             << ", \"us_per_query\": " << statistics.usPerQuery
+             << ", \"us_per_raycast\": " << statistics.usPerRaycast
+             << ", \"hits_per_query\": " << double(statistics.queryHits) / nQueries
+             << ", \"leaves_per_raycast\": " << double(statistics.raycastLeaves) / nQueries << " }";
+        return json.str();
+    }
+
+    bool parseOptions(int argc, char * argv[], Options & options) {
+        for (int i = 1; i < argc; ++i) {
+            bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--level") == 0 && hasValue) {
+                options.level = argv[++i];
+            } else if (strcmp(argv[i], "--procedural") == 0) {
+                options.procedural = true;
+            } else if (strcmp(argv[i], "--characters") == 0 && hasValue) {
+                options.nCharacters = std::strtoul(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--steps") == 0 && hasValue) {
+                options.nSteps = std::strtoul(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--tree-budget") == 0 && hasValue) {
+                options.treeBudget = std::strtoul(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+                options.output = argv[++i];
+            } else {
+                return false;
+            }
+        }
+        return options.nSteps > 0;
+    }
+
+    std::string escape(std::string const & str) {
+        std::string escaped;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    double percentile(prt::vector<double> & values, double p) {
+        std::sort(values.data(), values.data() + values.size());
+        size_t index = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[std::min(std::max(index, size_t(1)), values.size()) - 1];
+    }
+}
+
+int main(int argc, char * argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [--level <obj file> | --procedural]"
+                  << " [--characters <n>] [--steps <m>] [--tree-budget <k>] [--output <json file>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Level level;
+    if (options.procedural) {
+        generateLevel(level);
+    } else if (!loadObj(options.level.c_str(), level)) {
+        std::cerr << "failed to load level " << options.level << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    PhysicsSystem physicsSystem;
+    physicsSystem.setTreeOptimizationBudget(options.treeBudget);
+    physicsSystem.addModelCollider(level.vertices.data(), level.meshSizes.data(),
+                                   level.meshSizes.size(), Transform{});
+
+    AABB bounds = { level.vertices[0], level.vertices[0] };
+    for (glm::vec3 const & v : level.vertices) {
+        bounds.lowerBound = glm::min(bounds.lowerBound, v);
+        bounds.upperBound = glm::max(bounds.upperBound, v);
+    }
+
+    // dynamic and static trees over the bounds of the level's meshes
+    prt::vector<ColliderTag> meshTags;
+    prt::vector<AABB> meshAABBs;
+    {
+        size_t start = 0;
+        for (size_t i = 0; i < level.meshSizes.size(); ++i) {
+            AABB aabb = { level.vertices[start], level.vertices[start] };
+            for (size_t j = start; j < start + level.meshSizes[i]; ++j) {
+                aabb.lowerBound = glm::min(aabb.lowerBound, level.vertices[j]);
+                aabb.upperBound = glm::max(aabb.upperBound, level.vertices[j]);
+            }
+            meshTags.push_back({ ColliderIndex(i), COLLIDER_SHAPE_MESH, COLLIDER_TYPE_COLLIDE });
+            meshAABBs.push_back(aabb);
+            start += level.meshSizes[i];
+        }
+    }
+    DynamicAABBTree dynamicTree;
+    prt::vector<int32_t> treeIndices;
+    treeIndices.resize(meshTags.size());
+    // level geometry does not move, so the leaves are not padded
+    dynamicTree.insert(meshTags.data(), meshAABBs.data(), meshTags.size(), treeIndices.data(), 0.0f);
+
+    auto buildStart = std::chrono::steady_clock::now();
+    StaticAABBTree staticTree;
+    staticTree.build(meshTags.data(), meshAABBs.data(), meshTags.size());
+    double staticBuildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    static constexpr size_t nTreeQueries = 100000;
+    prt::vector<AABB> treeQueries;
+    {
+        std::mt19937 generator(3);
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        glm::vec3 size = bounds.upperBound - bounds.lowerBound;
+        for (size_t i = 0; i < nTreeQueries; ++i) {
+            glm::vec3 position = bounds.lowerBound + glm::vec3{u(generator), u(generator), u(generator)} * size;
+            treeQueries.push_back(AABB{position, position + glm::vec3{1.0f, 2.0f, 1.0f}});
+        }
+    }
+    glm::vec3 const rayDirection = glm::normalize(glm::vec3{0.6f, -0.64f, 0.48f});
+    static constexpr float rayDistance = 10.0f;
+    TreeStatistics dynamicTreeStatistics = benchmarkTree(dynamicTree, treeQueries, rayDirection, rayDistance);
+    TreeStatistics staticTreeStatistics = benchmarkTree(staticTree, treeQueries, rayDirection, rayDistance);
+
+    // spawn characters on the ground of a grid across the level
+    prt::vector<CharacterPhysics> physics;
+    prt::vector<Transform> transforms;
+    prt::vector<EntityID> entityIDs;
+    prt::vector<glm::vec3> spawnPoints;
+    size_t gridSize = static_cast<size_t>(std::ceil(std::sqrt(double(options.nCharacters)))) * 2;
+    glm::vec3 extent = bounds.upperBound - bounds.lowerBound;
+    for (size_t i = 0; i < gridSize * gridSize && physics.size() < options.nCharacters; ++i) {
+        glm::vec3 origin = { bounds.lowerBound.x + extent.x * (0.5f + i % gridSize) / gridSize,
+                             bounds.upperBound.y + 1.0f,
+                             bounds.lowerBound.z + extent.z * (0.5f + i / gridSize) / gridSize };
+        glm::vec3 hit;
+        if (!physicsSystem.raycast(origin, glm::vec3{0.0f, -1.0f, 0.0f}, extent.y + 2.0f, hit)) {
+            continue;
+        }
+        physics.push_back({});
+        physics.back().colliderTag = physicsSystem.addCapsuleCollider(1.0f, 0.5f, glm::vec3{0.0f, 0.5f, 0.0f});
+        transforms.push_back({});
+        transforms.back().position = hit + glm::vec3{0.0f, 0.1f, 0.0f};
+        spawnPoints.push_back(transforms.back().position);
+        entityIDs.push_back(entityIDs.size());
+    }
+
+    // scripted movement, every character walks in a slowly turning
+    // direction and stops for a while now and then
+    static constexpr float deltaTime = 1.0f / PHYSICS_TICK_RATE;
+    static constexpr float speed = 0.1f;
+    prt::ContainerAllocator & allocator = prt::ContainerAllocator::getDefaultContainerAllocator();
+
+    prt::vector<double> stepTimes;
+    stepTimes.reserve(options.nSteps);
+    uint64_t characterQueries = 0;
+    uint64_t sweepIterations = 0;
+    uint64_t triangleTests = 0;
+    uint64_t treeNodesVisited = 0;
+    uint64_t treeReinsertions = 0;
+    uint64_t allocations = 0;
+    // sample tree cost over the session to spot decay in tree quality
+    size_t costInterval = std::max(options.nSteps / 100, size_t(1));
+    float startCost = physicsSystem.getTreeCost();
+    float minCost = startCost;
+    float maxCost = startCost;
+    for (size_t step = 0; step < options.nSteps; ++step) {
+        for (size_t i = 0; i < physics.size(); ++i) {
+            // respawn characters that walked off the level
+            if (transforms[i].position.y < bounds.lowerBound.y - 10.0f) {
+                transforms[i].position = spawnPoints[i];
+                physics[i].velocity = glm::vec3{0.0f};
+            }
+
+            float t = step * deltaTime;
+            float angle = 0.5f * t * (1.0f + 0.1f * (i % 7)) + float(i);
+            bool walking = std::fmod(t + 0.37f * i, 8.0f) < 6.0f;
+            physics[i].movementVector = walking ? speed * glm::vec3{std::cos(angle), 0.0f, std::sin(angle)} :
+                                                  glm::vec3{0.0f};
+        }
+
+        size_t allocationsBefore = allocator.getNumberOfAllocations();
+        auto start = std::chrono::steady_clock::now();
+        physicsSystem.newFrame();
+        physicsSystem.updateCharacters(deltaTime, physics.data(), transforms.data(),
+                                       entityIDs.data(), physics.size());
+        auto end = std::chrono::steady_clock::now();
+        allocations += allocator.getNumberOfAllocations() - allocationsBefore;
+        stepTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        PhysicsStatistics const & statistics = physicsSystem.getStatistics();
+        characterQueries += statistics.characterQueries;
+        sweepIterations += statistics.sweepIterations;
+        triangleTests += statistics.triangleTests;
+        treeNodesVisited += statistics.treeNodesVisited;
+        treeReinsertions += statistics.treeReinsertions;
+
+        if ((step + 1) % costInterval == 0) {
+            float cost = physicsSystem.getTreeCost();
+            minCost = std::min(minCost, cost);
+            maxCost = std::max(maxCost, cost);
+        }
+    }
+    float endCost = physicsSystem.getTreeCost();
+
+    double mean = 0.0;
+    for (double time : stepTimes) {
+        mean += time;
+    }
+    mean /= stepTimes.size();
+    double p50 = percentile(stepTimes, 0.5);
+    double p99 = percentile(stepTimes, 0.99);
+    double maxTime = stepTimes.back();
+    double steps = double(options.nSteps);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"level\": \"" << (options.procedural ? std::string("procedural") : escape(options.level)) << "\",\n"
+         << "  \"triangles\": " << level.vertices.size() / 3 << ",\n"
+         << "  \"meshes\": " << level.meshSizes.size() << ",\n"
+         << "  \"characters\": " << physics.size() << ",\n"
+         << "  \"steps\": " << options.nSteps << ",\n"
+         << "  \"tree_budget\": " << options.treeBudget << ",\n"
+         << "  \"ms_per_step\": { \"mean\": " << mean << ", \"p50\": " << p50
+         << ", \"p99\": " << p99 << ", \"max\": " << maxTime << " },\n"
+         << "  \"tree_cost\": { \"start\": " << startCost << ", \"end\": " << endCost
+         << ", \"min\": " << minCost << ", \"max\": " << maxCost << " },\n"
+         << "  \"mesh_trees\": {\n"
+         << "    \"leaves\": " << meshTags.size() << ",\n"
+         << "    \"queries\": " << nTreeQueries << ",\n"
+         << "    \"static_build_ms\": " << staticBuildTime << ",\n"
+         << "    \"dynamic\": " << treeJson(dynamicTreeStatistics, nTreeQueries) << ",\n"
+         << "    \"static\": " << treeJson(staticTreeStatistics, nTreeQueries) << "\n"
+         << "  },\n"
+         << "  \"per_step\": {\n"
+         << "    \"character_queries\": " << characterQueries / steps << ",\n"
+         << "    \"sweep_iterations\": " << sweepIterations / steps << ",\n"
+         << "    \"triangle_tests\": " << triangleTests / steps << ",\n"
+         << "    \"tree_nodes_visited\": " << treeNodesVisited / steps << ",\n"
+         << "    \"tree_reinsertions\": " << treeReinsertions / steps << ",\n"
+         << "    \"allocations\": " << allocations / steps << "\n"
+         << "  }\n"
+         << "}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(options.output);
+        if (!file.is_open()) {
+            std::cerr << "failed to open " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+        file << json.str();
+    }
+    return EXIT_SUCCESS;
+}
@@ -6,7 +6,7 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 model[200];
     mat4 depthVP[5];
     /*Bones*/
-    mat4 bones[500];
+    mat3x4 bones[666];
 } ubo;
 
 layout(push_constant) uniform PER_OBJECT
@@ -25,11 +25,12 @@ layout(location = 5) in uvec4 inBoneIDs;
 layout(location = 6) in vec4 inBoneWeights;
 
 void main() {
-    mat4 boneTransform = ubo.bones[inBoneIDs[0] + pc.boneOffset] * inBoneWeights[0];
+    mat3x4 boneTransform = ubo.bones[inBoneIDs[0] + pc.boneOffset] * inBoneWeights[0];
     boneTransform += ubo.bones[inBoneIDs[1] + pc.boneOffset] * inBoneWeights[1];
     boneTransform += ubo.bones[inBoneIDs[2] + pc.boneOffset] * inBoneWeights[2];
     boneTransform += ubo.bones[inBoneIDs[3] + pc.boneOffset] * inBoneWeights[3];
-    vec4 bonedPos = boneTransform * vec4(inPosition, 1.0);
+    // bone transforms hold the rows of affine matrices
+    vec4 bonedPos = vec4(vec4(inPosition, 1.0) * boneTransform, 1.0);
 
     gl_Position = ubo.depthVP[pc.cascadeIndex] * ubo.model[pc.modelMatrixIdx] * bonedPos;
 }
@@ -31,7 +31,7 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 cascadeSpace[5];
     PointLight pointLights[8];
     /*Bones*/
-    mat4 bones[500];
+    mat3x4 bones[666];
 } ubo;
 
 layout(push_constant) uniform PER_OBJECT {
@@ -59,7 +59,7 @@ layout(location = 0) out VS_OUT {
 } vs_out;
 
 void main() {
-    mat4 boneTransform = mat4(1.0);
+    mat3x4 boneTransform = mat3x4(1.0);
     float weightSum = inBoneWeights[0] + inBoneWeights[1] + inBoneWeights[2] + inBoneWeights[3];
     if (weightSum > 0.0) { 
         boneTransform  = ubo.bones[inBoneIDs[0] + pc.boneOffset] * inBoneWeights[0];
@@ -68,7 +68,8 @@ void main() {
         boneTransform += ubo.bones[inBoneIDs[3] + pc.boneOffset] * inBoneWeights[3];
     }
 
-    vec4 bonedPos = boneTransform * vec4(inPosition, 1.0);
+    // bone transforms hold the rows of affine matrices
+    vec4 bonedPos = vec4(vec4(inPosition, 1.0) * boneTransform, 1.0);
 
     vs_out.fragPos = vec3(ubo.model[pc.modelMatrixIdx] * bonedPos);
 
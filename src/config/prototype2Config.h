@@ -29,5 +29,7 @@
 
 /* GAME */
 #define FRAME_RATE 60
+#define PHYSICS_TICK_RATE 30
+#define PHYSICS_MAX_TICKS_PER_FRAME 4
 
 #endif
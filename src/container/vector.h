@@ -83,7 +83,7 @@ namespace prt
 
             other.m_data = nullptr;
             other.m_size = 0;
-            m_capacity = 0;
+            other.m_capacity = 0;
         }
 
         vector& operator=(vector const & other) {
@@ -113,7 +113,7 @@ namespace prt
 
                 other.m_data = nullptr;
                 other.m_size = 0;
-                m_capacity = 0;
+                other.m_capacity = 0;
             } 
             return *this;
         }
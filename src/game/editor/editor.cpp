@@ -67,6 +67,7 @@ void Editor::updateInput(float deltaTime) {
         glm::vec3 dPos = glm::vec3(newWorldPos - selectedWorldPos);
 
         m_scene.m_entities.transforms[m_selectedEntityID].position = m_selectedEntityPosition + dPos;
+        m_scene.resetInterpolation(m_selectedEntityID);
     } else {
         m_selectedEntityID = -1;
     }
@@ -404,7 +404,7 @@ void EditorGui::showAddComponent(Scene & scene) {
 void EditorGui::showAddEntity(Scene & scene) {
     ImGui::NewLine();
     if (ImGui::Button("Add Entity")) {
-        scene.getEntities().addEntity();
+        scene.addEntity();
     }
 }
 
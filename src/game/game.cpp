@@ -18,7 +18,8 @@ Game::Game()
   m_frameRate(FRAME_RATE),
   m_microsecondsPerFrame(1000000 / m_frameRate),
   m_currentFrame(0),
-  m_time(0.0f) {
+  m_time(0.0f),
+  m_tickAccumulator(0.0f) {
     m_input.init(m_gameRenderer.getWindow());
     loadScene();
 }
@@ -68,10 +69,24 @@ void Game::update(float deltaTime) {
     m_input.update(m_mode == Mode::GAME);
     updateMode();
     switch (m_mode) {
-        case Mode::GAME:
+        case Mode::GAME: {
             m_renderMask = GameRenderer::GAME_RENDER_MASK;
-            m_scene.update(deltaTime);
+            // run the simulation in fixed ticks, carrying 
+            // the remainder over to the next frame
+            float const tickLength = 1.0f / float(PHYSICS_TICK_RATE);
+            m_scene.updateInput();
+            m_tickAccumulator += deltaTime;
+            uint32_t ticks = 0;
+            while (m_tickAccumulator >= tickLength && ticks < PHYSICS_MAX_TICKS_PER_FRAME) {
+                m_scene.fixedUpdate(tickLength);
+                m_tickAccumulator -= tickLength;
+                ++ticks;
+            }
+            // drop the time that can not be caught up with
+            m_tickAccumulator = glm::min(m_tickAccumulator, tickLength);
+            m_scene.update(deltaTime, m_tickAccumulator / tickLength);
             break;
+        }
         case Mode::EDITOR:
             int w,h;
             m_gameRenderer.getWindowSize(w,h);
@@ -84,5 +99,8 @@ void Game::update(float deltaTime) {
 void Game::updateMode() {
     if (m_input.getKeyDown(INPUT_KEY::KEY_TAB)) {
         m_mode = m_mode == Mode::GAME ? Mode::EDITOR : Mode::GAME; 
+        // entities may have been moved in the editor
+        m_scene.resetInterpolation();
+        m_tickAccumulator = 0.0f;
     }
 }
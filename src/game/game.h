@@ -42,6 +42,8 @@ private:
 
     uint64_t m_currentFrame;
     float m_time;
+    // simulation time not yet consumed by fixed ticks
+    float m_tickAccumulator;
 
     static constexpr int DEFAULT_WIDTH = 800;
     static constexpr int DEFAULT_HEIGHT = 600;
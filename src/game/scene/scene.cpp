@@ -14,6 +14,20 @@ Scene::Scene(GameRenderer & gameRenderer, AssetManager & assetManager, PhysicsSy
     SceneSerialization::loadScene((m_assetManager.getDirectory() + "scenes/cavern.prt").c_str(), *this);
     loadColliderModels();
     initSky();
+
+    resetInterpolation();
+}
+
+EntityID Scene::addEntity() {
+    EntityID id = m_entities.addEntity();
+    resetInterpolation(id);
+    return id;
+}
+
+void Scene::resetInterpolation() {
+    for (EntityID i = 0; i < m_entities.size(); ++i) {
+        m_previousTransforms[i] = m_entities.transforms[i];
+    }
 }
 
 void Scene::bindToRenderer() {
@@ -111,10 +125,10 @@ void Scene::bindRenderData() {
     }
 }
 
-void Scene::renderScene(Camera & camera) {
-    updateRenderData();
+void Scene::renderScene(Camera & camera, float interpolation) {
+    updateRenderData(interpolation);
 
-    prt::vector<glm::mat4> const & bones = m_animationSystem.getBoneTransforms();
+    prt::vector<BoneTransform> const & bones = m_animationSystem.getBoneTransforms();
 
     prt::vector<glm::vec4> billboardPositions = { m_moon.position };
     prt::vector<glm::vec4> billboardColors = { m_moon.billboard.color };
@@ -144,15 +158,24 @@ prt::vector<UBOPointLight> Scene::getPointLights() {
     return m_lightingSystem.getNearestPointLights(m_camera, m_entities.transforms);
 }
 
-void Scene::update(float deltaTime) {
+void Scene::fixedUpdate(float timeStep) {
+    resetInterpolation();
+    m_characterSystem.updateCharacters(timeStep);
+    updatePhysics(timeStep);
+}
+
+void Scene::update(float deltaTime, float interpolation) {
+    m_interpolation = interpolation;
     updateModels();
     time+=deltaTime;
     updateSun(time);
-    m_characterSystem.updateCharacters(deltaTime);
+    m_animationSystem.updateLODs(m_camera, m_entities.transforms,
+                                 m_renderData.animatedEntityIDs.data(),
+                                 m_renderData.animatedModelIDs.data(),
+                                 m_renderData.animatedModelIDs.size());
     m_animationSystem.updateAnimation(deltaTime, m_renderData.animatedModelIDs.data(), m_renderData.animatedModelIDs.size());
-    updatePhysics(deltaTime);
     updateCamera(deltaTime);
-    renderScene(m_camera);
+    renderScene(m_camera, m_interpolation);
 }
 
 void Scene::updateSun(float /*time*/) {
@@ -183,6 +206,7 @@ void Scene::updateSun(float /*time*/) {
 
 
 void Scene::updatePhysics(float deltaTime) {
+    m_physicsSystem.newFrame();
     updateColliders();
     m_characterSystem.updatePhysics(deltaTime);
 }
@@ -190,6 +214,8 @@ void Scene::updatePhysics(float deltaTime) {
 void Scene::updateColliders() {
     prt::vector<ColliderTag> modelTags;
     prt::vector<Transform> modelTransforms;
+    prt::vector<ColliderTag> capsuleTags;
+    prt::vector<Transform> capsuleTransforms;
 
     for (auto it = m_colliderUpdateSet.begin(); it != m_colliderUpdateSet.end(); it++) {
         ColliderTag tag =  m_entities.colliderTags[it->value()];
@@ -199,6 +225,8 @@ void Scene::updateColliders() {
                 modelTransforms.push_back(m_entities.transforms[it->value()]);
                 break;
             case COLLIDER_SHAPE_CAPSULE:
+                capsuleTags.push_back(tag);
+                capsuleTransforms.push_back(m_entities.transforms[it->value()]);
                 break;
             default:
                 break;
@@ -206,13 +234,15 @@ void Scene::updateColliders() {
     }
 
     m_physicsSystem.updateModelColliders(modelTags.data(), modelTransforms.data(), modelTags.size());
+    m_physicsSystem.updateCapsuleColliders(capsuleTags.data(), capsuleTransforms.data(), capsuleTags.size());
 
     m_colliderUpdateSet = prt::hash_set<EntityID>();
 }
 
 void Scene::addModelCollider(EntityID id) {
     assert(hasModel(id));
-    m_entities.colliderTags[id] = m_physicsSystem.addModelCollider(getModel(id), m_entities.transforms[id]);
+    m_entities.colliderTags[id] = m_physicsSystem.addModelCollider(m_entities.modelIDs[id], getModel(id), 
+                                                                   m_entities.transforms[id]);
 }
 
 void Scene::addCapsuleCollider(EntityID id, float height, float radius, glm::vec3 const & offset) {
@@ -235,7 +265,6 @@ void Scene::updateCamera(float deltaTime) {
     m_camera.update(deltaTime);
     
     // Make sure player is visible
-    glm::vec3 hit;
     glm::vec3 corners[4];
     float maxDist = 8.0f;
     float dist = maxDist;
@@ -243,21 +272,34 @@ void Scene::updateCamera(float deltaTime) {
 
     EntityID playerID = m_characterSystem.getPlayer();
 
-    auto const & transform = m_entities.transforms[playerID];
+    // follow the rendered, interpolated player
+    Transform const transform = getInterpolatedTransform(playerID, m_interpolation);
     glm::vec3 offset = glm::vec3{0.0f, 2.0f, 0.0f};
-    for (size_t i = 0; i < 4; ++i) {
-        glm::vec3 dir = glm::normalize(corners[i] - (transform.position + offset));
-        if (m_physicsSystem.raycast(transform.position + offset, dir, 
-                                    maxDist, hit)) {
-            dist = std::min(dist, glm::distance(transform.position + offset, hit));
-
-        }
+    // sweep a sphere enclosing the near plane along the camera boom
+    glm::vec3 nearCenter = 0.25f * (corners[0] + corners[1] + corners[2] + corners[3]);
+    float radius = 0.5f * glm::distance(corners[0], corners[3]);
+    glm::vec3 dir = glm::normalize(nearCenter - (transform.position + offset));
+    ShapeCastResult result;
+    if (m_physicsSystem.sphereCast(transform.position + offset, radius, dir, 
+                                   maxDist, result)) {
+        dist = result.distance;
     }
     m_camera.setTargetDistance(dist);
     m_camera.setTarget(transform.position + offset);
 }
 
-void Scene::updateRenderData() {
+Transform Scene::getInterpolatedTransform(EntityID id, float interpolation) const {
+    Transform const & previous = m_previousTransforms[id];
+    Transform const & current = m_entities.transforms[id];
+
+    Transform transform;
+    transform.position = glm::mix(previous.position, current.position, interpolation);
+    transform.rotation = glm::slerp(previous.rotation, current.rotation, interpolation);
+    transform.scale = glm::mix(previous.scale, current.scale, interpolation);
+    return transform;
+}
+
+void Scene::updateRenderData(float interpolation) {
     Model const * models = m_renderData.models;
 
     size_t staticCount = 0;
@@ -267,7 +309,7 @@ void Scene::updateRenderData() {
         ModelID mid = m_entities.modelIDs[i];
 
         if (mid != -1) {
-            glm::mat4 transform = m_entities.transforms[i].transformMatrix();
+            glm::mat4 transform = getInterpolatedTransform(i, interpolation).transformMatrix();
             if (models[mid].isAnimated()) {
                 m_renderData.animatedTransforms[animatedCount] = transform;
                 ++animatedCount;
@@ -282,7 +324,7 @@ void Scene::updateRenderData() {
     for (EntityID i = 0; i < m_entities.size(); ++i) {
         ColliderTag tag = m_entities.colliderTags[i];
 
-        Transform & transform = m_entities.transforms[i];
+        Transform const transform = getInterpolatedTransform(i, interpolation);
         
         switch (tag.shape) {
             case COLLIDER_SHAPE_CAPSULE: {
@@ -353,7 +395,8 @@ bool Scene::loadModel(EntityID entityID, char const * path, bool loadAnimation,
 
         if (m_entities.colliderTags[entityID].shape == COLLIDER_SHAPE_MODEL) {
             m_physicsSystem.removeCollider(m_entities.colliderTags[entityID]);
-            m_entities.colliderTags[entityID] = m_physicsSystem.addModelCollider(m_assetManager.getModelManager().getModel(id), 
+            m_entities.colliderTags[entityID] = m_physicsSystem.addModelCollider(id,
+                                                                                 m_assetManager.getModelManager().getModel(id), 
                                                                                  m_entities.transforms[entityID]);
             addToColliderUpdateSet(entityID);
         }
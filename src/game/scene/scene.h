@@ -51,7 +51,27 @@ public:
 
     void bindToRenderer();
 
-    void update(float deltaTime);
+    /**
+     * Reads the input of the frame, before its ticks
+     */
+    void updateInput() { m_characterSystem.updateInput(); }
+
+    /**
+     * Advances the simulation by one fixed tick
+     * 
+     * @param timeStep length of the tick
+     */
+    void fixedUpdate(float timeStep);
+
+    /**
+     * Updates and renders the scene once per frame
+     * 
+     * @param deltaTime frame time
+     * @param interpolation fraction of a tick elapsed since 
+     *                      the latest fixed update, used to 
+     *                      interpolate rendered transforms
+     */
+    void update(float deltaTime, float interpolation);
 
     AnimationSystem & getAnimationSystem() { return m_animationSystem; }
     CharacterSystem & getCharacterSystem() { return m_characterSystem; }
@@ -60,7 +80,7 @@ public:
 
     void getSkybox(prt::array<Texture, 6>& cubeMap) const;
 
-    void renderScene(Camera & camera);
+    void renderScene(Camera & camera, float interpolation = 1.0f);
 
     void addToColliderUpdateSet(EntityID id) { m_colliderUpdateSet.insert(id); }
 
@@ -70,6 +90,15 @@ public:
     Camera & getCamera() { return m_camera; }
 
     Entities & getEntities() { return m_entities; }
+    EntityID addEntity();
+
+    /**
+     * Renders an entity at its current transform until the
+     * next tick, for entities moved outside of the ticks
+     * @param id entity to reset
+     */
+    void resetInterpolation(EntityID id) { m_previousTransforms[id] = m_entities.transforms[id]; }
+    void resetInterpolation();
 
     bool hasModel(EntityID id) const { return m_entities.modelIDs[id] != -1; }
     ModelID getModelID(EntityID id) const { return m_entities.modelIDs[id]; }
@@ -102,6 +131,9 @@ private:
     } m_colliderModelIDs;
 
     Entities m_entities;
+    // transforms at the start of the latest fixed update
+    Transform m_previousTransforms[Entities::N];
+    float m_interpolation = 1.0f;
 
     prt::hash_set<EntityID> m_colliderUpdateSet;
     bool m_updateModels = false;
@@ -138,7 +170,9 @@ private:
     void updateColliders();
     void updateModels();
     void updateCamera(float deltaTime);
-    void updateRenderData();
+    void updateRenderData(float interpolation);
+
+    Transform getInterpolatedTransform(EntityID id, float interpolation) const;
 
     friend class SceneSerialization;
     friend class Editor;
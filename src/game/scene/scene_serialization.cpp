@@ -150,7 +150,9 @@ void SceneSerialization::parseEntity(char const *& buf, Scene & scene) {
                     size_t nModels;
                     scene.m_assetManager.getModelManager().getModels(models, nModels);
 
-                    scene.m_entities.colliderTags[id] = scene.m_physicsSystem.addModelCollider(models[scene.m_entities.modelIDs[id]], 
+                    ModelID modelID = scene.m_entities.modelIDs[id];
+                    scene.m_entities.colliderTags[id] = scene.m_physicsSystem.addModelCollider(modelID,
+                                                                                               models[modelID], 
                                                                                                scene.m_entities.transforms[id]);
                 } else if (strcmp(cType, "CAPSULE") == 0) {
                     float height = parseFloat(buf);
@@ -7,11 +7,14 @@ AnimationClip::AnimationClip() {
 
 void AnimationClip::setClip(const char * clipName) {
     strcpy(m_clipName, clipName);
+    m_modelStamp = 0;
+    ++m_version;
 }
 
 void AnimationClip::resetClip() {
     m_completed = false;
     m_time = 0.0f;
+    ++m_version;
 }
 
 void AnimationClip::update(float deltaTime) {
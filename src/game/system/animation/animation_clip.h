@@ -1,6 +1,10 @@
 #ifndef ANIMATION_CLIP_H
 #define ANIMATION_CLIP_H
 
+#include "src/container/vector.h"
+
+#include <cstdint>
+
 class AnimationClip {
 public:
     AnimationClip();
@@ -10,6 +14,8 @@ public:
     void update(float deltaTime);
 
     float isCompleted() const { return m_completed; }
+    // changes whenever the clip is set or reset
+    uint32_t getVersion() const { return m_version; }
 
     float m_time = 0.0f;
     float m_playBackSpeed = 1.0f;
@@ -18,6 +24,17 @@ public:
 private:
     char m_clipName[64] = {0};
     bool m_completed = false;
+    uint32_t m_version = 0;
+
+    // animation index of the clip name, resolved by the
+    // model on first sample and valid while the stamp
+    // matches that of the sampled model
+    int32_t m_animationIndex = 0;
+    uint32_t m_modelStamp = 0;
+
+    // key of the previous sample per channel,
+    // the starting point of the next search
+    prt::vector<uint32_t> m_keyCursors;
 
     friend class Model;
 };
@@ -0,0 +1,262 @@
+#include "animation_compression.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    static constexpr float sqrt2 = 1.41421356f;
+    static constexpr uint32_t maxQuantized15 = (1 << 15) - 1;
+    static constexpr uint32_t maxQuantized16 = (1 << 16) - 1;
+
+    // angle between two rotations, computed from the chord
+    // between the quaternions since acos is imprecise near 1
+    float angle(glm::quat const & a, glm::quat const & b) {
+        glm::quat d = glm::dot(a, b) < 0.0f ? a + b : a - b;
+        float chord = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z + d.w * d.w);
+        return 4.0f * std::asin(std::min(0.5f * chord, 1.0f));
+    }
+
+    /**
+     * Greedily removes keys that are within the tolerance of the
+     * interpolation between the previous kept key and a later key.
+     * The first and last key are always kept
+     * @param times key times
+     * @param decoded quantized keys
+     * @param original keys before quantization
+     * @param n number of keys
+     * @param tolerance maximum error of removed keys
+     * @param interpolate interpolates two keys
+     * @param error error between two keys
+     * @param kept receives the indices of the kept keys
+     */
+    template<typename T, typename Interpolate, typename Error>
+    void reduceKeys(float const * times, T const * decoded, T const * original, size_t n,
+                    float tolerance, Interpolate interpolate, Error error,
+                    prt::vector<uint32_t> & kept) {
+        kept.resize(0);
+        kept.push_back(0);
+        size_t start = 0;
+        for (size_t end = 2; end < n; ++end) {
+            bool fits = true;
+            for (size_t i = start + 1; i < end && fits; ++i) {
+                float t = (times[i] - times[start]) / (times[end] - times[start]);
+                fits = error(interpolate(decoded[start], decoded[end], t), original[i]) <= tolerance;
+            }
+            if (!fits) {
+                start = end - 1;
+                kept.push_back(start);
+            }
+        }
+        if (n > 1) {
+            kept.push_back(n - 1);
+        }
+    }
+}
+
+float AnimationKeyTimes::find(float time, float duration, bool loop, uint32_t & cursor,
+                              size_t & prevKey, size_t & nextKey) const {
+    size_t numKeys = times.size();
+    if (cursor >= numKeys || times[cursor] > time) {
+        cursor = 0;
+    }
+    while (cursor + 1 < numKeys && times[cursor + 1] <= time) {
+        ++cursor;
+    }
+
+    prevKey = cursor;
+    float frac;
+    if (cursor + 1 < numKeys) {
+        nextKey = cursor + 1;
+        frac = (time - times[prevKey]) / (times[nextKey] - times[prevKey]);
+    } else if (loop) {
+        // interpolate towards the first key over the rest of the clip
+        nextKey = 0;
+        float span = duration - times[prevKey] + times[0];
+        frac = span > 0.0f ? (time - times[prevKey]) / span : 0.0f;
+    } else {
+        nextKey = prevKey;
+        frac = 0.0f;
+    }
+    // hold the first key before it is reached
+    return glm::clamp(frac, 0.0f, 1.0f);
+}
+
+void Vec3Track::compress(float const * times, glm::vec3 const * values, size_t n,
+                         float tolerance) {
+    m_keyTimes.times.resize(0);
+    m_values.resize(0);
+    if (n == 0) {
+        return;
+    }
+
+    glm::vec3 max = values[0];
+    m_min = values[0];
+    bool constant = true;
+    for (size_t i = 0; i < n; ++i) {
+        m_min = glm::min(m_min, values[i]);
+        max = glm::max(max, values[i]);
+        constant = constant && glm::length(values[i] - values[0]) <= tolerance;
+    }
+
+    if (constant) {
+        m_min = values[0];
+        m_extent = glm::vec3{0.0f};
+        m_keyTimes.times.push_back(times[0]);
+        m_values.push_back(0);
+        m_values.push_back(0);
+        m_values.push_back(0);
+        return;
+    }
+    m_extent = max - m_min;
+
+    prt::vector<uint16_t> quantized;
+    prt::vector<glm::vec3> decoded;
+    quantized.resize(3 * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            float normalized = m_extent[j] > 0.0f ? (values[i][j] - m_min[j]) / m_extent[j] : 0.0f;
+            quantized[3 * i + j] = static_cast<uint16_t>(std::round(glm::clamp(normalized, 0.0f, 1.0f) * maxQuantized16));
+        }
+        decoded.push_back(decode(&quantized[3 * i]));
+    }
+
+    prt::vector<uint32_t> kept;
+    reduceKeys(times, decoded.data(), values, n, tolerance,
+               [](glm::vec3 const & a, glm::vec3 const & b, float t) { return glm::mix(a, b, t); },
+               [](glm::vec3 const & a, glm::vec3 const & b) { return glm::length(a - b); },
+               kept);
+
+    m_values.resize(3 * kept.size());
+    m_keyTimes.times.resize(kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) {
+        m_keyTimes.times[i] = times[kept[i]];
+        for (int j = 0; j < 3; ++j) {
+            m_values[3 * i + j] = quantized[3 * kept[i] + j];
+        }
+    }
+}
+
+glm::vec3 Vec3Track::sample(float time, float duration, bool loop, uint32_t & cursor) const {
+    if (size() == 1) {
+        return decodeKey(0);
+    }
+    size_t prevKey;
+    size_t nextKey;
+    float frac = m_keyTimes.find(time, duration, loop, cursor, prevKey, nextKey);
+    return glm::mix(decodeKey(prevKey), decodeKey(nextKey), frac);
+}
+
+glm::vec3 Vec3Track::decode(uint16_t const * packed) const {
+    glm::vec3 normalized = { float(packed[0]), float(packed[1]), float(packed[2]) };
+    return m_min + m_extent * (normalized / float(maxQuantized16));
+}
+
+size_t Vec3Track::memoryUsage() const {
+    return sizeof(*this) + m_keyTimes.times.capacity() * sizeof(float) +
+           m_values.capacity() * sizeof(uint16_t);
+}
+
+void RotationTrack::compress(float const * times, glm::quat const * values, size_t n,
+                             float tolerance) {
+    m_keyTimes.times.resize(0);
+    m_values.resize(0);
+    if (n == 0) {
+        return;
+    }
+
+    bool constant = true;
+    for (size_t i = 0; i < n && constant; ++i) {
+        constant = angle(values[i], values[0]) <= tolerance;
+    }
+
+    size_t numQuantized = constant ? 1 : n;
+    prt::vector<uint16_t> quantized;
+    prt::vector<glm::quat> decoded;
+    quantized.resize(3 * numQuantized);
+    for (size_t i = 0; i < numQuantized; ++i) {
+        encode(values[i], &quantized[3 * i]);
+        decoded.push_back(decode(&quantized[3 * i]));
+    }
+
+    prt::vector<uint32_t> kept;
+    if (constant) {
+        kept.push_back(0);
+    } else {
+        reduceKeys(times, decoded.data(), values, n, tolerance,
+                   [](glm::quat const & a, glm::quat const & b, float t) { return glm::slerp(a, b, t); },
+                   angle,
+                   kept);
+    }
+
+    m_values.resize(3 * kept.size());
+    m_keyTimes.times.resize(kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) {
+        m_keyTimes.times[i] = times[kept[i]];
+        for (int j = 0; j < 3; ++j) {
+            m_values[3 * i + j] = quantized[3 * kept[i] + j];
+        }
+    }
+}
+
+glm::quat RotationTrack::sample(float time, float duration, bool loop, uint32_t & cursor) const {
+    if (size() == 1) {
+        return decodeKey(0);
+    }
+    size_t prevKey;
+    size_t nextKey;
+    float frac = m_keyTimes.find(time, duration, loop, cursor, prevKey, nextKey);
+    return glm::slerp(decodeKey(prevKey), decodeKey(nextKey), frac);
+}
+
+size_t RotationTrack::memoryUsage() const {
+    return sizeof(*this) + m_keyTimes.times.capacity() * sizeof(float) +
+           m_values.capacity() * sizeof(uint16_t);
+}
+
+void RotationTrack::encode(glm::quat const & q, uint16_t * packed) {
+    float components[4] = { q.x, q.y, q.z, q.w };
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i) {
+        if (std::abs(components[i]) > std::abs(components[largest])) {
+            largest = i;
+        }
+    }
+    // q and -q are the same rotation, make the dropped component positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    // the other components lie within [-1/sqrt(2), 1/sqrt(2)]
+    uint64_t bits = largest;
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        float normalized = 0.5f * (sign * components[i] * sqrt2 + 1.0f);
+        uint64_t value = static_cast<uint64_t>(std::round(glm::clamp(normalized, 0.0f, 1.0f) * maxQuantized15));
+        bits = (bits << 15) | value;
+    }
+
+    packed[0] = static_cast<uint16_t>(bits >> 32);
+    packed[1] = static_cast<uint16_t>(bits >> 16);
+    packed[2] = static_cast<uint16_t>(bits);
+}
+
+glm::quat RotationTrack::decode(uint16_t const * packed) {
+    uint64_t bits = (uint64_t(packed[0]) << 32) | (uint64_t(packed[1]) << 16) | uint64_t(packed[2]);
+    uint32_t largest = static_cast<uint32_t>(bits >> 45);
+
+    float components[4];
+    float sum = 0.0f;
+    for (int i = 3; i >= 0; --i) {
+        if (uint32_t(i) == largest) {
+            continue;
+        }
+        float normalized = float(bits & maxQuantized15) / float(maxQuantized15);
+        components[i] = (2.0f * normalized - 1.0f) / sqrt2;
+        sum += components[i] * components[i];
+        bits >>= 15;
+    }
+    components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+
+    // the reconstructed component keeps the quaternion unit length
+    return glm::quat{ components[3], components[0], components[1], components[2] };
+}
@@ -0,0 +1,137 @@
+#ifndef PRT_ANIMATION_COMPRESSION_H
+#define PRT_ANIMATION_COMPRESSION_H
+
+#include "src/container/vector.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+/**
+ * Maximum errors allowed when removing keys
+ * from a track. Quantization adds an error of
+ * at most half a step on top of these
+ */
+struct AnimationTolerance {
+    float position = 0.0001f;
+    float rotation = 0.0005f; // radians
+    float scale = 0.0001f;
+};
+
+/**
+ * Key times of a track along with the search for the
+ * keys around a sample time. The cursor is the key
+ * of the previous sample, from which the search moves
+ * forward, so that sequential playback is O(1)
+ */
+struct AnimationKeyTimes {
+    /**
+     * Finds the keys around a time and the interpolation
+     * factor between them
+     * @param time sample time in ticks
+     * @param duration duration of the clip in ticks
+     * @param loop whether the last key interpolates
+     *             towards the first
+     * @param cursor key of the previous sample, updated
+     * @param prevKey receives the key before the time
+     * @param nextKey receives the key after the time
+     * @return interpolation factor between the keys
+     */
+    float find(float time, float duration, bool loop, uint32_t & cursor,
+               size_t & prevKey, size_t & nextKey) const;
+
+    prt::vector<float> times;
+};
+
+/**
+ * Track of vec3 keys, e.g. positions or scales. Every
+ * component is quantized to 16 bits relative to the
+ * bounds of the track. Constant tracks hold a single key
+ */
+class Vec3Track {
+public:
+    /**
+     * Quantizes the keys and removes those that
+     * can be interpolated from their neighbours
+     * @param times key times in increasing order
+     * @param values key values
+     * @param n number of keys
+     * @param tolerance maximum error of removed keys
+     */
+    void compress(float const * times, glm::vec3 const * values, size_t n,
+                  float tolerance);
+
+    /**
+     * @param time sample time in ticks
+     * @param duration duration of the clip in ticks
+     * @param loop whether the clip loops
+     * @param cursor key of the previous sample, updated
+     * @return interpolated value
+     */
+    glm::vec3 sample(float time, float duration, bool loop, uint32_t & cursor) const;
+
+    glm::vec3 decodeKey(size_t key) const { return decode(&m_values[3 * key]); }
+
+    size_t size() const { return m_keyTimes.times.size(); }
+    size_t memoryUsage() const;
+
+private:
+    glm::vec3 decode(uint16_t const * packed) const;
+
+    AnimationKeyTimes m_keyTimes;
+    prt::vector<uint16_t> m_values;
+    glm::vec3 m_min = glm::vec3{0.0f};
+    glm::vec3 m_extent = glm::vec3{0.0f};
+};
+
+/**
+ * Track of rotation keys, every key is quantized to
+ * 48 bits using the smallest three components of the
+ * quaternion. Constant tracks hold a single key
+ */
+class RotationTrack {
+public:
+    /**
+     * Quantizes the keys and removes those that
+     * can be interpolated from their neighbours
+     * @param times key times in increasing order
+     * @param values key values
+     * @param n number of keys
+     * @param tolerance maximum angle of removed keys in radians
+     */
+    void compress(float const * times, glm::quat const * values, size_t n,
+                  float tolerance);
+
+    /**
+     * @param time sample time in ticks
+     * @param duration duration of the clip in ticks
+     * @param loop whether the clip loops
+     * @param cursor key of the previous sample, updated
+     * @return interpolated rotation
+     */
+    glm::quat sample(float time, float duration, bool loop, uint32_t & cursor) const;
+
+    glm::quat decodeKey(size_t key) const { return decode(&m_values[3 * key]); }
+
+    size_t size() const { return m_keyTimes.times.size(); }
+    size_t memoryUsage() const;
+
+    /**
+     * Packs a quaternion into 48 bits, 2 bits for the index of
+     * the largest component and 15 bits for each of the others
+     * @param q quaternion to pack
+     * @param packed receives three 16 bit words
+     */
+    static void encode(glm::quat const & q, uint16_t * packed);
+    static glm::quat decode(uint16_t const * packed);
+
+private:
+    AnimationKeyTimes m_keyTimes;
+    prt::vector<uint16_t> m_values;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "animation_pose.h"
+
+#include <cmath>
+
+void blendPoses(AnimationPose & poseA, AnimationPose const & poseB,
+                float weight, float const * mask) {
+    size_t numNodes = poseA.size();
+
+    // positions and scales are blended as arrays of floats
+    float * aVectors[2] = { &poseA.positions[0].x, &poseA.scales[0].x };
+    float const * bVectors[2] = { &poseB.positions[0].x, &poseB.scales[0].x };
+    for (size_t v = 0; v < 2; ++v) {
+        float * a = aVectors[v];
+        float const * b = bVectors[v];
+        if (mask == nullptr) {
+            for (size_t i = 0; i < 3 * numNodes; ++i) {
+                a[i] += weight * (b[i] - a[i]);
+            }
+            continue;
+        }
+        for (size_t i = 0; i < numNodes; ++i) {
+            float w = weight * mask[i];
+            for (size_t j = 3 * i; j < 3 * i + 3; ++j) {
+                a[j] += w * (b[j] - a[j]);
+            }
+        }
+    }
+
+    // rotations are blended with a normalized lerp whose weight is
+    // corrected towards that of slerp by a polynomial fit, which
+    // unlike slerp has no trigonometry and so vectorizes across nodes
+    float * a = &poseA.rotations[0].x;
+    float const * b = &poseB.rotations[0].x;
+    for (size_t i = 0; i < numNodes; ++i) {
+        float w = mask == nullptr ? weight : weight * mask[i];
+        if (w <= 0.0f) {
+            continue;
+        }
+        float * qa = &a[4 * i];
+        float const * qb = &b[4 * i];
+        float dot = qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3];
+        float absDot = std::abs(dot);
+        float k0 = 1.0904f + absDot * (-3.2452f + absDot * (3.55645f - absDot * 1.43519f));
+        float k1 = 0.848013f + absDot * (-1.06021f + absDot * 0.215638f);
+        float k = k0 * (w - 0.5f) * (w - 0.5f) + k1;
+        float t = w + w * (w - 0.5f) * (w - 1.0f) * k;
+        // take the shortest path
+        float weightB = dot < 0.0f ? -t : t;
+        float q[4];
+        float lengthSquared = 0.0f;
+        for (size_t j = 0; j < 4; ++j) {
+            q[j] = (1.0f - t) * qa[j] + weightB * qb[j];
+            lengthSquared += q[j] * q[j];
+        }
+        float invLength = 1.0f / std::sqrt(lengthSquared);
+        for (size_t j = 0; j < 4; ++j) {
+            qa[j] = q[j] * invLength;
+        }
+    }
+}
+
+void addPose(AnimationPose & pose, AnimationPose const & additive,
+             AnimationPose const & reference, float weight, float const * mask) {
+    size_t numNodes = pose.size();
+    for (size_t i = 0; i < numNodes; ++i) {
+        float w = mask == nullptr ? weight : weight * mask[i];
+        if (w <= 0.0f) {
+            continue;
+        }
+
+        pose.positions[i] += w * (additive.positions[i] - reference.positions[i]);
+
+        // rotation from the reference to the additive pose, scaled
+        // by a normalized lerp from the identity along the shortest path
+        glm::quat delta = additive.rotations[i] * glm::conjugate(reference.rotations[i]);
+        if (delta.w < 0.0f) {
+            delta = -delta;
+        }
+        glm::quat identity = glm::quat{1.0f, 0.0f, 0.0f, 0.0f};
+        delta = glm::normalize(identity * (1.0f - w) + delta * w);
+        pose.rotations[i] = glm::normalize(delta * pose.rotations[i]);
+
+        for (int j = 0; j < 3; ++j) {
+            float base = reference.scales[i][j];
+            float ratio = base != 0.0f ? additive.scales[i][j] / base : 1.0f;
+            pose.scales[i][j] *= 1.0f + w * (ratio - 1.0f);
+        }
+    }
+}
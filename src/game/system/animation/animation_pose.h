@@ -0,0 +1,80 @@
+#ifndef PRT_ANIMATION_POSE_H
+#define PRT_ANIMATION_POSE_H
+
+#include "src/container/vector.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+// local transforms of the nodes of a skeleton, one array
+// per component, and their global transforms
+struct AnimationPose {
+    void reserve(size_t numNodes) {
+        positions.reserve(numNodes);
+        rotations.reserve(numNodes);
+        scales.reserve(numNodes);
+        transforms.reserve(numNodes);
+    }
+
+    void resize(size_t numNodes) {
+        positions.resize(numNodes);
+        rotations.resize(numNodes);
+        scales.resize(numNodes);
+    }
+
+    size_t size() const { return positions.size(); }
+
+    prt::vector<glm::vec3> positions;
+    prt::vector<glm::quat> rotations;
+    prt::vector<glm::vec3> scales;
+    prt::vector<glm::mat4> transforms;
+};
+
+// poses that the layers of an animation are combined in,
+// reused between samples to avoid allocations
+struct AnimationPoseBuffers {
+    void reserve(size_t numNodes) {
+        result.reserve(numNodes);
+        layer.reserve(numNodes);
+        reference.reserve(numNodes);
+    }
+
+    // receives the combination of the layers
+    AnimationPose result;
+    // sampled pose of the layer being applied
+    AnimationPose layer;
+    // pose that an additive layer is relative to
+    AnimationPose reference;
+};
+
+/**
+ * Blends pose B into pose A, node by node
+ * @param poseA first pose, receives the blend
+ * @param poseB second pose, of the same skeleton
+ * @param weight weight of pose B
+ * @param mask weight of every node, multiplied with
+ *             the weight, nullptr for all nodes
+ */
+void blendPoses(AnimationPose & poseA, AnimationPose const & poseB,
+                float weight, float const * mask);
+
+/**
+ * Adds the difference between an additive pose and
+ * its reference pose on top of a pose, node by node
+ * @param pose pose to add to
+ * @param additive pose of the additive layer
+ * @param reference pose that the additive pose
+ *                  is relative to
+ * @param weight weight of the difference
+ * @param mask weight of every node, multiplied with
+ *             the weight, nullptr for all nodes
+ */
+void addPose(AnimationPose & pose, AnimationPose const & additive,
+             AnimationPose const & reference, float weight, float const * mask);
+
+#endif
@@ -2,15 +2,25 @@
 
 #include "src/game/scene/scene.h"
 #include "src/system/assets/model_manager.h"
+#include "src/graphics/camera/camera.h"
+
+#include <algorithm>
+#include <thread>
 
 AnimationSystem::AnimationSystem(ModelManager & modelManager, Scene & scene)
  : m_modelManager{modelManager}, m_scene{scene} {
     m_boneOffsets.push_back(0);
+    // few entities are still sampled on the calling thread alone
+    m_modelManager.setSamplingThreads(std::thread::hardware_concurrency());
 }
 
 AnimationID AnimationSystem::addAnimation(EntityID entityID) { 
     AnimationID id = m_animationComponents.size();
     m_animationComponents.push_back({}); 
+    m_lods.push_back(ANIMATION_LOD_FULL);
+    m_framesSinceSample.push_back(neverSampled);
+    m_interpolating.push_back(false);
+    m_sampleStates.push_back({});
 
     m_entityToAnimation.insert(entityID, id);
     m_boneOffsets.push_back(m_modelManager.getModel(m_scene.getModelID(entityID)).getNumBones());
@@ -18,22 +28,269 @@ AnimationID AnimationSystem::addAnimation(EntityID entityID) {
 
     return id;
 };
+void AnimationSystem::updateLODs(Camera const & camera, Transform const * transforms,
+                                 EntityID const * entityIDs, ModelID const * modelIDs, size_t n) {
+    glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getViewMatrix();
+    glm::vec3 const & cameraPosition = camera.getPosition();
+    // scales a radius in view space to clip space
+    float radiusScale = std::max(std::abs(viewProjection[0][0]), std::abs(viewProjection[1][1]));
+
+    for (size_t i = 0; i < n; ++i) {
+        AnimationLODTiers const & tiers = getLODTiers(modelIDs[i]);
+        Transform const & transform = transforms[entityIDs[i]];
+        glm::vec3 const & position = transform.position;
+
+        // a sphere around the skinned bounds of the latest
+        // update, or around the origin until they are known
+        glm::vec3 center = position;
+        float radius = tiers.boundingRadius;
+        bool hasBounds = i < m_skinnedBounds.size() && m_framesSinceSample[i] != neverSampled &&
+                         m_skinnedBounds[i].lowerBound.x <= m_skinnedBounds[i].upperBound.x;
+        if (hasBounds) {
+            AABB bounds = SkinnedBounds::transformBounds(m_skinnedBounds[i], transform.transformMatrix());
+            center = 0.5f * (bounds.lowerBound + bounds.upperBound);
+            radius = 0.5f * glm::length(bounds.upperBound - bounds.lowerBound);
+        }
+
+        glm::vec4 clip = viewProjection * glm::vec4{center, 1.0f};
+        float extent = clip.w + radius * radiusScale;
+        bool visible = clip.w > -radius &&
+                       std::abs(clip.x) <= extent && std::abs(clip.y) <= extent;
+
+        float distance = glm::length(position - cameraPosition);
+        if (!visible || distance >= tiers.freezeDistance) {
+            m_lods[i] = ANIMATION_LOD_FROZEN;
+        } else if (distance >= tiers.throttleDistance) {
+            m_lods[i] = ANIMATION_LOD_THROTTLED;
+        } else {
+            m_lods[i] = ANIMATION_LOD_FULL;
+        }
+    }
+}
+
 void AnimationSystem::updateAnimation(float deltaTime, ModelID const * modelIDs, size_t n) {
     for (AnimationComponent & component : m_animationComponents) {
         component.clipA.update(deltaTime);
         component.clipB.update(deltaTime);
+        for (uint32_t i = 0; i < component.numLayers; ++i) {
+            component.layers[i].clip.update(deltaTime);
+        }
+    }
+
+    m_paletteOffsets.resize(n + 1);
+    m_modelManager.getBoneOffsets(modelIDs, m_paletteOffsets.data(), n);
+    m_paletteOffsets[n] = n == 0 ? 0 : m_paletteOffsets[n - 1] + m_modelManager.getModel(modelIDs[n - 1]).getNumBones();
+    m_boneTransforms.resize(m_paletteOffsets[n]);
+    m_previousTransforms.resize(m_paletteOffsets[n]);
+    m_skinnedBounds.resize(n);
+
+    // a changed layout invalidates the whole palette
+    bool layoutChanged = m_previousPaletteOffsets.size() != m_paletteOffsets.size();
+    for (size_t i = 0; i <= n && !layoutChanged; ++i) {
+        layoutChanged = m_previousPaletteOffsets[i] != m_paletteOffsets[i];
     }
+    m_previousPaletteOffsets = m_paletteOffsets;
+
+    m_statistics = {};
+    m_fullIndices.resize(0);
+    m_throttledIndices.resize(0);
+    for (size_t i = 0; i < n; ++i) {
+        AnimationLOD lod = m_lods[i];
+        uint32_t interval = getLODTiers(modelIDs[i]).throttleInterval;
+        bool never = m_framesSinceSample[i] == neverSampled;
+        // the palette on display is that of the latest sample
+        // unless an interpolation towards it is in progress
+        bool unchanged = !never && isUnchanged(m_sampleStates[i], getSampleState(m_animationComponents[i]));
+        bool sampled = false;
+        if (never || lod == ANIMATION_LOD_FULL) {
+            // a never sampled animation has nothing to hold
+            // or interpolate from, so it is sampled in full
+            sampled = !unchanged || m_interpolating[i];
+            if (sampled) {
+                m_fullIndices.push_back(i);
+            }
+            m_interpolating[i] = false;
+        } else if (lod == ANIMATION_LOD_THROTTLED) {
+            // entering the tier starts a new interpolation,
+            // which has reached the latest sample once due
+            bool due = !m_interpolating[i] || m_framesSinceSample[i] + 1 >= interval;
+            if (due && unchanged) {
+                m_interpolating[i] = false;
+            } else if (due) {
+                sampled = true;
+                m_throttledIndices.push_back(i);
+                m_interpolating[i] = true;
+            }
+        } else if (m_interpolating[i]) {
+            // the held palette is between two samples
+            m_sampleStates[i].valid = false;
+            m_interpolating[i] = false;
+        }
+        m_framesSinceSample[i] = sampled ? 0 : std::min(m_framesSinceSample[i] + 1, neverSampled - 1);
+
+        if (!sampled) {
+            // gameplay waits on clips to complete
+            Model const & model = m_modelManager.getModel(modelIDs[i]);
+            AnimationComponent & component = m_animationComponents[i];
+            model.updateCompletion(component.clipA);
+            model.updateCompletion(component.clipB);
+            for (uint32_t j = 0; j < component.numLayers; ++j) {
+                model.updateCompletion(component.layers[j].clip);
+            }
+        }
+
+        m_statistics.fullEntities += lod == ANIMATION_LOD_FULL;
+        m_statistics.throttledEntities += lod == ANIMATION_LOD_THROTTLED;
+        m_statistics.frozenEntities += lod == ANIMATION_LOD_FROZEN;
+        m_statistics.staticEntities += unchanged && !sampled && !m_interpolating[i];
+    }
+    m_statistics.sampledEntities = m_fullIndices.size() + m_throttledIndices.size();
 
     m_modelManager.sampleAnimation(modelIDs,
                                    m_animationComponents.data(),
+                                   m_fullIndices.data(),
+                                   m_fullIndices.size(),
                                    m_boneTransforms,
                                    n);
+
+    // throttled animations interpolate from the palette
+    // on display towards the new sample
+    for (uint32_t i : m_throttledIndices) {
+        for (uint32_t j = m_paletteOffsets[i]; j < m_paletteOffsets[i + 1]; ++j) {
+            m_previousTransforms[j] = m_boneTransforms[j];
+        }
+    }
+    if (!m_throttledIndices.empty()) {
+        m_modelManager.sampleAnimation(modelIDs,
+                                       m_animationComponents.data(),
+                                       m_throttledIndices.data(),
+                                       m_throttledIndices.size(),
+                                       m_sampledTransforms,
+                                       n);
+    }
+
+    // sampling updates the completion of the clips,
+    // so their state is taken afterwards
+    for (uint32_t i : m_fullIndices) {
+        m_sampleStates[i] = getSampleState(m_animationComponents[i]);
+    }
+    for (uint32_t i : m_throttledIndices) {
+        m_sampleStates[i] = getSampleState(m_animationComponents[i]);
+    }
+
+    m_changedBoneRanges.resize(0);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t offset = m_paletteOffsets[i];
+        size_t numFloats = (sizeof(BoneTransform) / sizeof(float)) * (m_paletteOffsets[i + 1] - offset);
+        bool changed = layoutChanged || m_interpolating[i] || m_framesSinceSample[i] == 0;
+        if (changed) {
+            addChangedBoneRange(i);
+        }
+        if (!changed || numFloats == 0) {
+            continue;
+        }
+
+        if (m_interpolating[i]) {
+            uint32_t interval = getLODTiers(modelIDs[i]).throttleInterval;
+            float t = std::min(float(m_framesSinceSample[i] + 1) / float(std::max(interval, 1u)), 1.0f);
+
+            // blended as flat arrays of floats
+            float * current = &m_boneTransforms[offset][0][0];
+            float const * previous = &m_previousTransforms[offset][0][0];
+            float const * sampled = &m_sampledTransforms[offset][0][0];
+            for (size_t j = 0; j < numFloats; ++j) {
+                current[j] = previous[j] + t * (sampled[j] - previous[j]);
+            }
+        }
+
+        // a box per bone, so the cost is independent of the vertices
+        SkinnedBounds const & skinnedBounds = m_modelManager.getModel(modelIDs[i]).getSkinnedBounds();
+        m_skinnedBounds[i] = skinnedBounds.transform(&m_boneTransforms[offset]);
+    }
 }
 
-prt::vector<glm::mat4> const &  AnimationSystem::getBoneTransforms() {
+AnimationSystem::SampleState AnimationSystem::getSampleState(AnimationComponent const & component) {
+    SampleState state;
+    state.numClips = 2 + component.numLayers;
+    for (uint32_t i = 0; i < state.numClips; ++i) {
+        AnimationClip const * clip;
+        if (i < 2) {
+            clip = i == 0 ? &component.clipA : &component.clipB;
+            state.weights[i] = i == 0 ? 1.0f - component.blendFactor : component.blendFactor;
+            state.modes[i] = ANIMATION_BLEND_OVERRIDE;
+            state.maskIndices[i] = -1;
+        } else {
+            AnimationLayer const & layer = component.layers[i - 2];
+            clip = &layer.clip;
+            state.weights[i] = layer.weight;
+            state.modes[i] = layer.mode;
+            state.maskIndices[i] = layer.maskIndex;
+        }
+        state.times[i] = clip->m_time;
+        state.versions[i] = clip->getVersion();
+        state.loops[i] = clip->m_loop;
+        state.completed[i] = clip->isCompleted();
+    }
+    state.valid = true;
+    return state;
+}
+
+bool AnimationSystem::isUnchanged(SampleState const & previous, SampleState const & current) {
+    if (!previous.valid || previous.numClips != current.numClips) {
+        return false;
+    }
+    for (uint32_t i = 0; i < current.numClips; ++i) {
+        if (previous.weights[i] != current.weights[i]) {
+            return false;
+        }
+        // a clip without weight does not affect the pose
+        if (current.weights[i] <= 0.0f) {
+            continue;
+        }
+        // completed clips that do not loop hold their last key
+        bool held = !current.loops[i] && previous.completed[i] && current.completed[i];
+        if (previous.versions[i] != current.versions[i] ||
+            previous.loops[i] != current.loops[i] ||
+            previous.modes[i] != current.modes[i] ||
+            previous.maskIndices[i] != current.maskIndices[i] ||
+            (previous.times[i] != current.times[i] && !held)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AnimationSystem::addChangedBoneRange(uint32_t animationIndex) {
+    uint32_t begin = m_paletteOffsets[animationIndex];
+    uint32_t end = m_paletteOffsets[animationIndex + 1];
+    if (begin == end) {
+        return;
+    }
+    // merge with the previous range if adjacent
+    if (!m_changedBoneRanges.empty() && m_changedBoneRanges.back().end == begin) {
+        m_changedBoneRanges.back().end = end;
+    } else {
+        m_changedBoneRanges.push_back({ begin, end });
+    }
+}
+
+prt::vector<BoneTransform> const &  AnimationSystem::getBoneTransforms() {
     return m_boneTransforms;
 }
     
+AnimationLODTiers const & AnimationSystem::getLODTiers(ModelID modelID) const {
+    auto it = m_modelLODTiers.find(modelID);
+    return it != m_modelLODTiers.end() ? it->value() : m_defaultLODTiers;
+}
+
+AABB AnimationSystem::getSkinnedBounds(EntityID entityID, Transform const & transform) const {
+    AABB const & bounds = m_skinnedBounds[m_entityToAnimation[entityID]];
+    if (bounds.lowerBound.x > bounds.upperBound.x) {
+        return bounds;
+    }
+    return SkinnedBounds::transformBounds(bounds, transform.transformMatrix());
+}
+
 glm::mat4 AnimationSystem::getCachedTransformation(EntityID entityID, char const * boneName) const {
     int boneIndex = m_scene.getModel(entityID).getBoneIndex(boneName);
     if (boneIndex == -1) {
@@ -45,5 +302,5 @@ glm::mat4 AnimationSystem::getCachedTransformation(EntityID entityID, char const
 
 glm::mat4 AnimationSystem::getCachedTransformation(EntityID entityID, int boneIndex) const {
     AnimationID id = m_entityToAnimation[entityID];
-    return m_boneTransforms[m_boneOffsets[id] + boneIndex];
+    return toMat4(m_boneTransforms[m_boneOffsets[id] + boneIndex]);
 }
@@ -5,7 +5,8 @@
 
 #include "src/container/hash_map.h"
 #include "src/container/vector.h"
-
+#include "src/game/system/physics/aabb.h"
+#include "src/graphics/geometry/bone_transform.h"
 
 #include "animation_clip.h"
 
@@ -14,11 +15,78 @@
 struct RenderData;
 class ModelManager;
 class Scene;
+class Camera;
+struct Transform;
+
+enum AnimationBlendMode : uint8_t {
+    // blends from the pose below towards that of the layer
+    ANIMATION_BLEND_OVERRIDE,
+    // adds the difference between the pose of the layer
+    // and the first key of its clip to the pose below
+    ANIMATION_BLEND_ADDITIVE,
+    TOTAL_NUM_ANIMATION_BLEND_MODES
+};
+
+struct AnimationLayer {
+    AnimationClip clip;
+    float weight = 0.0f;
+    AnimationBlendMode mode = ANIMATION_BLEND_OVERRIDE;
+    // bone mask of the entity's model,
+    // -1 for a layer that affects all nodes
+    int32_t maskIndex = -1;
+};
 
 struct AnimationComponent {
+    static constexpr uint32_t maxLayers = 4;
+
     AnimationClip clipA;
     AnimationClip clipB;
     float blendFactor;
+    // applied in order on top of the blend of clip A and B
+    AnimationLayer layers[maxLayers];
+    uint32_t numLayers = 0;
+};
+
+enum AnimationLOD : uint8_t {
+    // sampled every frame
+    ANIMATION_LOD_FULL,
+    // sampled every few frames, the palette
+    // is interpolated in between
+    ANIMATION_LOD_THROTTLED,
+    // far or off-screen, the palette is held
+    ANIMATION_LOD_FROZEN,
+    TOTAL_NUM_ANIMATION_LODS
+};
+
+// distances from the camera at which
+// the animation of a model is reduced
+struct AnimationLODTiers {
+    float throttleDistance = 20.0f;
+    float freezeDistance = 60.0f;
+    // frames between samples of throttled entities
+    uint32_t throttleInterval = 3;
+    // radius around the entity origin that has to be
+    // off-screen for it to freeze, used until the
+    // bounds of its skinned mesh are known
+    float boundingRadius = 2.0f;
+};
+
+struct AnimationStatistics {
+    // entities in every lod tier this frame
+    uint32_t fullEntities = 0;
+    uint32_t throttledEntities = 0;
+    uint32_t frozenEntities = 0;
+    // entities sampled this frame
+    uint32_t sampledEntities = 0;
+    // entities not sampled since their clips are
+    // unchanged since their latest sample
+    uint32_t staticEntities = 0;
+};
+
+// range of the bone palette, from begin up to end
+struct BoneRange {
+    uint32_t begin;
+    uint32_t end;
 };
 
 class AnimationSystem {
@@ -27,20 +95,111 @@ public:
 
     AnimationID addAnimation(EntityID entityID);
 
+    /**
+     * Assigns the animated entities their lod tiers
+     * by their distance to the camera and visibility
+     * @param camera camera the scene is rendered from
+     * @param transforms transforms of all entities
+     * @param entityIDs animated entities, in the
+     *                  order of their animations
+     * @param modelIDs model of every animated entity
+     * @param n number of animated entities
+     */
+    void updateLODs(Camera const & camera, Transform const * transforms,
+                    EntityID const * entityIDs, ModelID const * modelIDs, size_t n);
+
     void updateAnimation(float deltaTime, ModelID const * modelIDs, size_t n);
-    prt::vector<glm::mat4> const & getBoneTransforms();
+    prt::vector<BoneTransform> const & getBoneTransforms();
+    /**
+     * @return ranges of the bone palette that changed in the
+     *         latest update, the rest of the palette holds
+     *         the transforms of the update before
+     */
+    prt::vector<BoneRange> const & getChangedBoneRanges() const { return m_changedBoneRanges; }
+
+    /**
+     * @return bounds of the skinned mesh of every animation
+     *         in model space, as of the latest update
+     */
+    prt::vector<AABB> const & getSkinnedBounds() const { return m_skinnedBounds; }
+    /**
+     * @param entityID animated entity
+     * @param transform transform of the entity
+     * @return bounds of the skinned mesh of
+     *         the entity in world space
+     */
+    AABB getSkinnedBounds(EntityID entityID, Transform const & transform) const;
 
     glm::mat4 getCachedTransformation(EntityID entityID, int boneIndex) const;
     glm::mat4 getCachedTransformation(EntityID entityID, char const * boneName) const;
 
     inline AnimationComponent & getAnimationComponent(EntityID entityID) { return  m_animationComponents[m_entityToAnimation[entityID]]; }
 
+    void setLODTiers(ModelID modelID, AnimationLODTiers const & tiers) { m_modelLODTiers.insert(modelID, tiers); }
+    void setDefaultLODTiers(AnimationLODTiers const & tiers) { m_defaultLODTiers = tiers; }
+
+    AnimationStatistics const & getStatistics() const { return m_statistics; }
+
 private:
+    static constexpr uint32_t neverSampled = UINT32_MAX;
+    // clip A and B followed by the clips of the layers
+    static constexpr uint32_t maxClips = 2 + AnimationComponent::maxLayers;
+
+    // the clip state that an animation was sampled with
+    struct SampleState {
+        float times[maxClips];
+        uint32_t versions[maxClips];
+        bool loops[maxClips];
+        bool completed[maxClips];
+        // clips without weight do not affect the pose
+        float weights[maxClips];
+        AnimationBlendMode modes[maxClips];
+        int32_t maskIndices[maxClips];
+        uint32_t numClips = 0;
+        bool valid = false;
+    };
+
+    AnimationLODTiers const & getLODTiers(ModelID modelID) const;
+
+    static SampleState getSampleState(AnimationComponent const & component);
+    /**
+     * @return whether sampling a component in its current
+     *         state gives the palette of a previous state
+     */
+    static bool isUnchanged(SampleState const & previous, SampleState const & current);
+    void addChangedBoneRange(uint32_t animationIndex);
+
     prt::vector<AnimationComponent> m_animationComponents;
     prt::hash_map<EntityID, AnimationID> m_entityToAnimation;
-    prt::vector<glm::mat4> m_boneTransforms;
+    prt::vector<BoneTransform> m_boneTransforms;
     prt::vector<uint32_t> m_boneOffsets;
 
+    prt::vector<AnimationLOD> m_lods;
+    // frames since the latest sample of every animation
+    prt::vector<uint32_t> m_framesSinceSample;
+    // whether the palette of an animation is interpolated
+    // between its previous and sampled palettes
+    prt::vector<bool> m_interpolating;
+    prt::vector<SampleState> m_sampleStates;
+    prt::hash_map<ModelID, AnimationLODTiers> m_modelLODTiers;
+    AnimationLODTiers m_defaultLODTiers;
+
+    // palette offset of every animation
+    prt::vector<uint32_t> m_paletteOffsets;
+    prt::vector<uint32_t> m_previousPaletteOffsets;
+    prt::vector<BoneRange> m_changedBoneRanges;
+    // animations sampled this frame, by tier
+    prt::vector<uint32_t> m_fullIndices;
+    prt::vector<uint32_t> m_throttledIndices;
+    // palettes that throttled animations
+    // are interpolated between
+    prt::vector<BoneTransform> m_previousTransforms;
+    prt::vector<BoneTransform> m_sampledTransforms;
+    // model space bounds of the skinned mesh of every animation
+    prt::vector<AABB> m_skinnedBounds;
+
+    AnimationStatistics m_statistics;
+
     ModelManager & m_modelManager;
     Scene        & m_scene;
 };
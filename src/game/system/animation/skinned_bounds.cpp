@@ -0,0 +1,68 @@
+#include "skinned_bounds.h"
+
+#include <cmath>
+#include <limits>
+
+AABB SkinnedBounds::emptyBounds() {
+    static constexpr float max = std::numeric_limits<float>::max();
+    return AABB{ glm::vec3{max}, glm::vec3{-max} };
+}
+
+void SkinnedBounds::reset(size_t numBones) {
+    m_boneBounds.resize(numBones);
+    for (AABB & bounds : m_boneBounds) {
+        bounds = emptyBounds();
+    }
+    m_unskinnedBounds = emptyBounds();
+}
+
+void SkinnedBounds::addVertex(glm::vec3 const & position, glm::uvec4 const & boneIDs,
+                              glm::vec4 const & boneWeights) {
+    AABB point = AABB{ position, position };
+    bool skinned = false;
+    for (int i = 0; i < 4; ++i) {
+        if (boneWeights[i] > 0.0f) {
+            m_boneBounds[boneIDs[i]] += point;
+            skinned = true;
+        }
+    }
+    // unweighted vertices are not transformed
+    if (!skinned) {
+        m_unskinnedBounds += point;
+    }
+}
+
+AABB SkinnedBounds::transformBounds(AABB const & bounds, glm::mat4 const & transform) {
+    glm::vec3 center = 0.5f * (bounds.lowerBound + bounds.upperBound);
+    glm::vec3 extent = 0.5f * (bounds.upperBound - bounds.lowerBound);
+    glm::vec3 transformedCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+    glm::vec3 transformedExtent = glm::vec3(0.0f);
+    for (int c = 0; c < 3; ++c) {
+        transformedExtent += glm::abs(glm::vec3(transform[c])) * extent[c];
+    }
+    return AABB{ transformedCenter - transformedExtent, transformedCenter + transformedExtent };
+}
+
+AABB SkinnedBounds::transform(BoneTransform const * transforms) const {
+    AABB result = m_unskinnedBounds;
+    for (size_t i = 0; i < m_boneBounds.size(); ++i) {
+        AABB const & bounds = m_boneBounds[i];
+        if (bounds.lowerBound.x > bounds.upperBound.x) {
+            continue;
+        }
+        glm::vec3 center = 0.5f * (bounds.lowerBound + bounds.upperBound);
+        glm::vec3 extent = 0.5f * (bounds.upperBound - bounds.lowerBound);
+
+        // every column of the transform is a row of the affine
+        // matrix, the extent is scaled by its absolute values
+        glm::vec3 transformedCenter;
+        glm::vec3 transformedExtent;
+        for (int r = 0; r < 3; ++r) {
+            glm::vec4 const & row = transforms[i][r];
+            transformedCenter[r] = row.x * center.x + row.y * center.y + row.z * center.z + row.w;
+            transformedExtent[r] = std::abs(row.x) * extent.x + std::abs(row.y) * extent.y + std::abs(row.z) * extent.z;
+        }
+        result += AABB{ transformedCenter - transformedExtent, transformedCenter + transformedExtent };
+    }
+    return result;
+}
@@ -0,0 +1,58 @@
+#ifndef PRT_SKINNED_BOUNDS_H
+#define PRT_SKINNED_BOUNDS_H
+
+#include "src/container/vector.h"
+#include "src/game/system/physics/aabb.h"
+#include "src/graphics/geometry/bone_transform.h"
+
+#include <cstdint>
+
+/**
+ * Bounds of a skinned mesh, kept as a box per bone around
+ * the vertices that the bone influences. A skinned vertex
+ * is a weighted average of the vertex transformed by its
+ * bones, so it lies within the union of its transformed
+ * bone boxes, which is computed in O(bones)
+ */
+class SkinnedBounds {
+public:
+    /**
+     * Clears the bounds
+     * @param numBones number of bones of the mesh
+     */
+    void reset(size_t numBones);
+
+    /**
+     * Expands the boxes of the bones that influence a vertex,
+     * vertices without weights expand the unskinned box
+     * @param position vertex position in bind space
+     * @param boneIDs bones of the vertex
+     * @param boneWeights weight of every bone
+     */
+    void addVertex(glm::vec3 const & position, glm::uvec4 const & boneIDs,
+                   glm::vec4 const & boneWeights);
+
+    /**
+     * @param transforms bone palette of the mesh
+     * @return bounds of the skinned vertices
+     */
+    AABB transform(BoneTransform const * transforms) const;
+
+    /**
+     * @param bounds non-empty bounds
+     * @param transform affine transform
+     * @return bounds of the transformed box
+     */
+    static AABB transformBounds(AABB const & bounds, glm::mat4 const & transform);
+
+    size_t getNumBones() const { return m_boneBounds.size(); }
+
+private:
+    static AABB emptyBounds();
+
+    // bones without vertices have empty boxes
+    prt::vector<AABB> m_boneBounds;
+    AABB m_unskinnedBounds = emptyBounds();
+};
+
+#endif
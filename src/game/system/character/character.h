@@ -1,6 +1,7 @@
 #ifndef PRT_CHARACTER_H
 #define PRT_CHARACTER_H
 
+#include "src/game/system/character/character_physics.h"
 #include "src/game/system/physics/collider_tag.h"
 #include "src/game/system/animation/animation_system.h"
 
@@ -16,16 +17,6 @@ enum CharacterType : int {
     CHARACTER_TYPE_NPC
 };
 
-struct CharacterPhysics {
-    glm::vec3   forward = {1.0f, 0.0f, 0.0f};
-    glm::vec3   velocity = {0.0f, 0.0f, 0.0f};
-    float       mass = 1.0f;
-    glm::vec3   movementVector = {0.0f, 0.0f, 0.0f};
-    glm::vec3   groundNormal;
-    ColliderTag colliderTag;
-    bool        isGrounded = false;
-};
-
 struct CharacterInput {
     glm::vec2 move = {0.0f, 0.0f};
     bool      run = false;
@@ -0,0 +1,24 @@
+#ifndef PRT_CHARACTER_PHYSICS_H
+#define PRT_CHARACTER_PHYSICS_H
+
+#include "src/game/system/physics/collider_tag.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+struct CharacterPhysics {
+    glm::vec3   forward = {1.0f, 0.0f, 0.0f};
+    glm::vec3   velocity = {0.0f, 0.0f, 0.0f};
+    float       mass = 1.0f;
+    glm::vec3   movementVector = {0.0f, 0.0f, 0.0f};
+    glm::vec3   groundNormal;
+    ColliderTag colliderTag;
+    bool        isGrounded = false;
+    // sleeping characters are skipped by the physics system
+    bool        isAsleep = false;
+    // number of consecutive frames spent at rest
+    uint32_t    idleFrames = 0;
+};
+
+#endif
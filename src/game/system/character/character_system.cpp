@@ -17,10 +17,11 @@ CharacterSystem::CharacterSystem(Scene * scene,
       m_playerController{scene->getInput(), scene->getCamera()} {
 }
 
-void CharacterSystem::updateCharacters(float deltaTime) {
-    // player input
+void CharacterSystem::updateInput() {
     m_playerController.updateInput(m_characters[PLAYER_ID].input);
+}
 
+void CharacterSystem::updateCharacters(float deltaTime) {
     // JUST FOR FUN, WILL REMOVE LATER
     for (size_t i = 1; i < m_characters.size(); ++i) {
         Character & character = m_characters[i];
@@ -31,6 +32,9 @@ void CharacterSystem::updateCharacters(float deltaTime) {
 
     for (Character & character : m_characters) {
         updateCharacter(character, deltaTime);
+        // later ticks of the frame do not see the presses again
+        character.input.jump = false;
+        character.input.attack = false;
     }
 }
 
@@ -53,23 +57,32 @@ void CharacterSystem::addEquipment(CharacterID characterID, int boneIndex, Entit
 }
            
 void CharacterSystem::updatePhysics(float deltaTime) {
+    prt::vector<CharacterPhysics> physics;
     prt::vector<Transform> transforms;
+    prt::vector<EntityID> entityIDs;
+    physics.resize(m_characters.size());
     transforms.resize(m_characters.size());
+    entityIDs.resize(m_characters.size());
  
     {
         int i = 0;
         for (Character & character : m_characters) {
+            physics[i] = character.physics;
             transforms[i] = m_scene->getTransform(character.id);
+            entityIDs[i] = character.id;
             ++i;
         }
     }
 
     m_physicsSystem.updateCharacters(deltaTime,
-                                     *m_scene,
-                                     transforms.data());
+                                     physics.data(),
+                                     transforms.data(),
+                                     entityIDs.data(),
+                                     m_characters.size());
     {
         int i = 0;
         for (Character & character : m_characters) {
+            character.physics = physics[i];
             m_scene->getTransform(character.id) = transforms[i];
             character.attributeInfo.updateEquipment(character.id, *m_scene);
             ++i;
@@ -23,6 +23,16 @@ public:
 
     void addEquipment(CharacterID characterID, int boneIndex, EntityID equipment, Transform offset);
              
+    /**
+     * Reads the player input, once per frame
+     */
+    void updateInput();
+
+    /**
+     * Advances the characters by one tick, presses
+     * are consumed by the first tick after them
+     * @param deltaTime length of the tick
+     */
     void updateCharacters(float deltaTime);
 
     void updatePhysics(float deltaTime);
@@ -32,10 +32,12 @@ void PlayerController::updateInput(CharacterInput & input) {
         input.move = {0.0f, 0.0f};
     }
 
-    input.jump = m_input.getKeyDown(INPUT_KEY::KEY_SPACE);
+    // a frame may run no tick, so presses are kept
+    // until the character system clears them
+    input.jump = input.jump || m_input.getKeyDown(INPUT_KEY::KEY_SPACE);
     input.holdjump = m_input.getKeyPress(INPUT_KEY::KEY_SPACE);
 
     input.run = !m_input.getKeyPress(INPUT_KEY::KEY_LEFT_SHIFT);
 
-    input.attack = m_input.getKeyDown(INPUT_KEY::KEY_ENTER);
+    input.attack = input.attack || m_input.getKeyDown(INPUT_KEY::KEY_ENTER);
 }
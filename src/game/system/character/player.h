@@ -5,6 +5,7 @@
 
 #include "src/game/component/component.h"
 #include "src/game/system/physics/physics_system.h"
+#include "src/game/system/character/character.h"
 #include "src/graphics/camera/camera.h"
 #include "src/system/input/input.h"
 
@@ -12,6 +13,11 @@ class PlayerController {
 public:
     PlayerController(Input & input, Camera & camera);
 
+    /**
+     * Reads the input of the current frame, presses
+     * are kept until they are consumed by a tick
+     * @param input input of the player character
+     */
     void updateInput(CharacterInput & input);
 private:
     Input & m_input;
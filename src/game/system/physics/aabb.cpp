@@ -9,11 +9,20 @@ bool AABB::intersect(AABB const & a, AABB const & b) {
              a.upperBound.z < b.lowerBound.z);
 }
 
-// From "Realtime Collision Detection" by Christer Ericson
 bool AABB::intersectRay(AABB const & a, 
                         glm::vec3 const & origin,
                         glm::vec3 const & direction,
                         float maxDistance) {
+    float tEntry;
+    return intersectRay(a, origin, direction, maxDistance, tEntry);
+}
+
+// From "Realtime Collision Detection" by Christer Ericson
+bool AABB::intersectRay(AABB const & a, 
+                        glm::vec3 const & origin,
+                        glm::vec3 const & direction,
+                        float maxDistance,
+                        float & tEntry) {
     float tmin = 0.0f; // set to -FLT_MAX to get first hit on line
     float tmax = maxDistance; // set to max distance ray can travel (for segment)
     // For all three slabs
@@ -43,7 +52,7 @@ bool AABB::intersectRay(AABB const & a,
     }
     // Ray intersects all 3 slabs. Return point (q) and intersection t value (tmin)
     //q = p + d * tmin;
-
+    tEntry = tmin;
     return true;
 }
 
@@ -36,6 +36,22 @@ struct AABB {
                              glm::vec3 const & direction,
                              float maxDistance);
 
+    /**
+     * @param a aabb
+     * @param origin origin of ray
+     * @param direction direction of ray
+     * @param maxDistance maximum distance ray may travel from origin
+     * @param tEntry distance along the ray at which it
+     *               enters the aabb, return by reference
+     * @return  true if a intersects with line segment,
+     *          false otherwise
+     */
+    static bool intersectRay(AABB const & a, 
+                             glm::vec3 const & origin,
+                             glm::vec3 const & direction,
+                             float maxDistance,
+                             float & tEntry);
+
     /**
      * @param other
      * @return true if aabb encloses other, 
@@ -17,6 +17,7 @@ void DynamicAABBTree::query(ColliderTag caller, AABB const & aabb, prt::vector<C
     while (!nodeStack.empty()) {
         int32_t index = nodeStack.back();
         nodeStack.pop_back();
+        ++m_nodesVisited;
         Node const & node = m_nodes[index];
         if (AABB::intersect(node.aabb, aabb)) {
             if (node.isLeaf()) {
@@ -32,8 +33,9 @@ void DynamicAABBTree::query(ColliderTag caller, AABB const & aabb, prt::vector<C
 }
 
 void DynamicAABBTree::query(ColliderTag caller, AABB const & aabb, 
-                            prt::vector<uint16_t> & meshIndices,
-                            prt::vector<uint16_t> & capsuleIndices,
+                            prt::vector<ColliderIndex> & meshIndices,
+                            prt::vector<ColliderIndex> & capsuleIndices,
+                            prt::vector<ColliderIndex> & heightfieldIndices,
                             ColliderType type) {
     if (m_size == 0) {
         return;
@@ -44,6 +46,7 @@ void DynamicAABBTree::query(ColliderTag caller, AABB const & aabb,
     while (!nodeStack.empty()) {
         int32_t index = nodeStack.back();
         nodeStack.pop_back();
+        ++m_nodesVisited;
         Node const & node = m_nodes[index];
         if (AABB::intersect(node.aabb, aabb)) {
             if (node.isLeaf()) {
@@ -55,6 +58,9 @@ void DynamicAABBTree::query(ColliderTag caller, AABB const & aabb,
                         case ColliderShape::COLLIDER_SHAPE_CAPSULE:
                             capsuleIndices.push_back(node.colliderTag.index);
                             break;
+                        case ColliderShape::COLLIDER_SHAPE_HEIGHTFIELD:
+                            heightfieldIndices.push_back(node.colliderTag.index);
+                            break;
                         default:
                             break;
                     }
@@ -80,10 +86,13 @@ void DynamicAABBTree::queryRaycast(glm::vec3 const& origin,
     while (!nodeStack.empty()) {
         int32_t index = nodeStack.back();
         nodeStack.pop_back();
+        ++m_nodesVisited;
         Node const & node = m_nodes[index];
         if (AABB::intersectRay(node.aabb, origin, direction, maxDistance)) {
-            if (node.isLeaf() && node.colliderTag.type == COLLIDER_TYPE_COLLIDE) {
-                tags.push_back(node.colliderTag);
+            if (node.isLeaf()) {
+                if (node.colliderTag.type == COLLIDER_TYPE_COLLIDE) {
+                    tags.push_back(node.colliderTag);
+                }
             } else {
                 nodeStack.push_back(node.left);
                 nodeStack.push_back(node.right);
@@ -93,20 +102,39 @@ void DynamicAABBTree::queryRaycast(glm::vec3 const& origin,
 }
 
 void DynamicAABBTree::insert(ColliderTag const * tags, AABB const * aabbs, size_t n,
-                             int32_t * treeIndices) {
+                             int32_t * treeIndices, float margin) {
     for (size_t i = 0; i < n; ++i) {
-        treeIndices[i] = insertLeaf(tags[i], aabbs[i]);
+        treeIndices[i] = insertLeaf(tags[i], aabbs[i], margin);
     }
 }
 
 void DynamicAABBTree::update(int32_t * treeIndices, AABB const * aabbs, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        glm::vec3 displacement{0.0f};
+        update(&treeIndices[i], &aabbs[i], &displacement, 1);
+    }
+}
+
+void DynamicAABBTree::update(int32_t * treeIndices, AABB const * aabbs,
+                             glm::vec3 const * displacements, size_t n) {
     for (size_t i = 0; i < n; ++i) {
         Node & node = m_nodes[treeIndices[i]];
-        if (!node.aabb.contains(aabbs[i])) {
-            ColliderTag tag = node.colliderTag;
-            remove(treeIndices[i]);
-            treeIndices[i] = insertLeaf(tag, aabbs[i]);
+        if (node.aabb.contains(aabbs[i])) {
+            // keep the leaf unless it is far larger than
+            // needed, e.g. after a fast collider has stopped,
+            // turning colliders may lag behind their prediction
+            glm::vec3 slack = shrinkMultiplier * node.margin +
+                              displacementMultiplier * glm::abs(displacements[i]);
+            AABB largeAABB = { aabbs[i].lowerBound - slack, aabbs[i].upperBound + slack };
+            if (largeAABB.contains(node.aabb)) {
+                continue;
+            }
         }
+        // the leaf keeps its index, only its position in the hierarchy changes
+        detachLeaf(treeIndices[i]);
+        node.aabb = fatten(aabbs[i], node.margin, displacements[i]);
+        attachLeaf(treeIndices[i]);
+        ++m_reinsertions;
     }
 }
 
@@ -123,26 +151,76 @@ void DynamicAABBTree::remove(int32_t * treeIndices, size_t n) {
     }
 }
 
+void DynamicAABBTree::optimize(unsigned int budget) {
+    if (budget == 0 || rootIndex == Node::NULL_INDEX) {
+        return;
+    }
+
+    struct LeafCost {
+        int32_t index;
+        float cost;
+    };
+    prt::vector<LeafCost> leaves;
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        Node const & node = m_nodes[i];
+        if (node.height != 0 || node.parent == Node::NULL_INDEX) {
+            continue;
+        }
+        // area the leaf adds to its parent
+        Node const & parent = m_nodes[node.parent];
+        int32_t sibling = parent.left == int32_t(i) ? parent.right : parent.left;
+        leaves.push_back({ int32_t(i), parent.aabb.area() - m_nodes[sibling].aabb.area() });
+    }
+
+    size_t n = std::min(size_t(budget), leaves.size());
+    std::partial_sort(leaves.data(), leaves.data() + n, leaves.data() + leaves.size(),
+                      [](LeafCost const & a, LeafCost const & b) { return a.cost > b.cost; });
+    for (size_t i = 0; i < n; ++i) {
+        detachLeaf(leaves[i].index);
+        attachLeaf(leaves[i].index);
+    }
+}
+
 float DynamicAABBTree::cost() const {
     float cost = 0.0f;
     for (auto const & node : m_nodes) {
-        cost += node.aabb.area();
+        // skip leaves and free nodes
+        if (node.height > 0) {
+            cost += node.aabb.area();
+        }
     }
     return cost;
 }
 
-int32_t DynamicAABBTree::insertLeaf(ColliderTag tag, AABB const & aabb) {
+size_t DynamicAABBTree::memoryUsage() const {
+    return m_nodes.capacity() * sizeof(Node);
+}
+
+int32_t DynamicAABBTree::insertLeaf(ColliderTag tag, AABB const & aabb, float margin) {
     // insert new node into vector
     int32_t leafIndex = allocateNode();
 
     m_nodes[leafIndex].colliderTag = tag;
-    // add buffer to aabb 
-    m_nodes[leafIndex].aabb.lowerBound = aabb.lowerBound - buffer;
-    m_nodes[leafIndex].aabb.upperBound = aabb.upperBound + buffer;
-    
+    m_nodes[leafIndex].margin = margin;
+    m_nodes[leafIndex].aabb = fatten(aabb, margin, glm::vec3{0.0f});
+
+    attachLeaf(leafIndex);
+
+    return leafIndex;
+}
+
+AABB DynamicAABBTree::fatten(AABB const & aabb, float margin, glm::vec3 const & displacement) {
+    // pad by the margin and extend along the predicted displacement
+    glm::vec3 d = displacementMultiplier * displacement;
+    return { aabb.lowerBound - margin + glm::min(d, glm::vec3{0.0f}),
+             aabb.upperBound + margin + glm::max(d, glm::vec3{0.0f}) };
+}
+
+void DynamicAABBTree::attachLeaf(int32_t leafIndex) {
     if (rootIndex == Node::NULL_INDEX) {
         rootIndex = leafIndex;
-        return leafIndex;
+        m_nodes[leafIndex].parent = Node::NULL_INDEX;
+        return;
     }
     // traverse tree to find suitable place of insertion
     // stage 1: find the best sibling for the new leaf
@@ -175,17 +253,19 @@ int32_t DynamicAABBTree::insertLeaf(ColliderTag tag, AABB const & aabb) {
 
     // stage 3: walk back up the tree refitting AABBs and applying rotations
     synchHierarchy(m_nodes[leafIndex].parent);
-
-    return leafIndex;
 }
 
 void DynamicAABBTree::remove(int32_t index) {
+    detachLeaf(index);
+    freeNode(index);
+}
+
+void DynamicAABBTree::detachLeaf(int32_t index) {
     Node & n = m_nodes[index];
     assert(n.isLeaf());
 
     if (index == rootIndex) {
         rootIndex = Node::NULL_INDEX;
-        freeNode(index);
         return;
     }
 
@@ -200,23 +280,21 @@ void DynamicAABBTree::remove(int32_t index) {
 
     if (m_nodes[parent].parent != Node::NULL_INDEX)  {
         int32_t grandParent = m_nodes[parent].parent;
-        if (m_nodes[grandParent].left == n.parent) {
+        if (m_nodes[grandParent].left == parent) {
             m_nodes[grandParent].left = siblingIndex;
         } else {
             m_nodes[grandParent].right = siblingIndex;
         }
 
         m_nodes[siblingIndex].parent = grandParent;
-        freeNode(n.parent);
+        freeNode(parent);
 
         synchHierarchy(grandParent);
     } else {
         rootIndex = siblingIndex;
         m_nodes[siblingIndex].parent = Node::NULL_INDEX;
-        freeNode(n.parent);
+        freeNode(parent);
     }
-
-    freeNode(index);
 }
 
 void DynamicAABBTree::freeNode(int32_t index) {
@@ -242,7 +320,7 @@ int32_t DynamicAABBTree::allocateNode() {
 
 void DynamicAABBTree::synchHierarchy(int32_t index) {
     while (index != Node::NULL_INDEX) {
-        balance(index);
+        rotate(index);
         
         int32_t left = m_nodes[index].left;
         int32_t right = m_nodes[index].right;
@@ -250,49 +328,95 @@ void DynamicAABBTree::synchHierarchy(int32_t index) {
         m_nodes[index].height = 1 + std::max(m_nodes[left].height, m_nodes[right].height);
         m_nodes[index].aabb = m_nodes[left].aabb + m_nodes[right].aabb;
 
-        // balance(index);
         index = m_nodes[index].parent;
     }
 }
 
-void DynamicAABBTree::balance(int32_t index) {
-    Node & node = m_nodes[index];
-    if (node.height < 2) {
+void DynamicAABBTree::rotate(int32_t index) {
+    // tree rotations by surface area, "Fast, Effective BVH Updates
+    // for Animated Scenes" by Kopta et al., after Kensler.
+    // Swaps a child of the node with a grandchild, or two
+    // grandchildren, if that shrinks the children's total area
+    Node & a = m_nodes[index];
+    int32_t ib = a.left;
+    int32_t ic = a.right;
+    Node & b = m_nodes[ib];
+    Node & c = m_nodes[ic];
+    if (b.isLeaf() && c.isLeaf()) {
         return;
     }
 
-    int32_t ileft = node.left;
-    int32_t iright = node.right;
-    Node & left = m_nodes[ileft];
-    Node & right = m_nodes[iright];
-
-    int32_t difference = left.height - right.height;
-    if (difference > 1) {
-        // left is higher than right, rotate left up
-        int32_t * ia = m_nodes[left.left].height > m_nodes[left.right].height ? &left.left : &left.right;
-        Node & a = m_nodes[*ia];
-        right.parent = ileft;
-        a.parent = index;
-
-        node.right = *ia;
-        *ia = iright;
-
-        left.aabb = m_nodes[left.left].aabb + m_nodes[left.right].aabb;
-        left.height = std::max(m_nodes[left.left].height, m_nodes[left.right].height) + 1;
-    } else if (difference < -1) {
-        // right is higher than left, rotate right up
-        int32_t * ia = m_nodes[right.left].height > m_nodes[right.right].height ? &right.left : &right.right;
-        Node & a = m_nodes[*ia];
-        left.parent = iright;
-        a.parent = index;
-
-        node.left = *ia;
-        *ia = ileft;
-
-        right.aabb = m_nodes[right.left].aabb + m_nodes[right.right].aabb;
-        right.height = std::max(m_nodes[right.left].height, m_nodes[right.right].height) + 1;
+    enum Rotation { NONE, B_F, B_G, C_D, C_E, D_F, D_G };
+    Rotation best = NONE;
+    float areaB = b.aabb.area();
+    float areaC = c.aabb.area();
+    // total area of b and c before rotating, which rotations have to beat
+    float bestCost = areaB + areaC;
+    if (!c.isLeaf()) {
+        AABB const & f = m_nodes[c.left].aabb;
+        AABB const & g = m_nodes[c.right].aabb;
+        // b and f swap places, c holds b and g
+        float cost = areaB + (b.aabb + g).area();
+        if (cost < bestCost) { bestCost = cost; best = B_F; }
+        cost = areaB + (b.aabb + f).area();
+        if (cost < bestCost) { bestCost = cost; best = B_G; }
+    }
+    if (!b.isLeaf()) {
+        AABB const & d = m_nodes[b.left].aabb;
+        AABB const & e = m_nodes[b.right].aabb;
+        float cost = areaC + (c.aabb + e).area();
+        if (cost < bestCost) { bestCost = cost; best = C_D; }
+        cost = areaC + (c.aabb + d).area();
+        if (cost < bestCost) { bestCost = cost; best = C_E; }
+
+        if (!c.isLeaf()) {
+            AABB const & f = m_nodes[c.left].aabb;
+            AABB const & g = m_nodes[c.right].aabb;
+            cost = (f + e).area() + (d + g).area();
+            if (cost < bestCost) { bestCost = cost; best = D_F; }
+            cost = (g + e).area() + (f + d).area();
+            if (cost < bestCost) { bestCost = cost; best = D_G; }
+        }
+    }
+
+    switch (best) {
+        case NONE:
+            return;
+        case B_F:
+            swapChildren(index, ib, ic, c.left);
+            break;
+        case B_G:
+            swapChildren(index, ib, ic, c.right);
+            break;
+        case C_D:
+            swapChildren(index, ic, ib, b.left);
+            break;
+        case C_E:
+            swapChildren(index, ic, ib, b.right);
+            break;
+        case D_F:
+            swapChildren(ib, b.left, ic, c.left);
+            break;
+        case D_G:
+            swapChildren(ib, b.left, ic, c.right);
+            break;
+    }
+}
+
+void DynamicAABBTree::swapChildren(int32_t parentA, int32_t childA, int32_t parentB, int32_t childB) {
+    Node & pa = m_nodes[parentA];
+    Node & pb = m_nodes[parentB];
+    (pa.left == childA ? pa.left : pa.right) = childB;
+    (pb.left == childB ? pb.left : pb.right) = childA;
+    m_nodes[childA].parent = parentB;
+    m_nodes[childB].parent = parentA;
+
+    // refit the lower of the two parents first
+    for (int32_t index : { parentB, parentA }) {
+        Node & node = m_nodes[index];
+        node.aabb = m_nodes[node.left].aabb + m_nodes[node.right].aabb;
+        node.height = 1 + std::max(m_nodes[node.left].height, m_nodes[node.right].height);
     }
-    node.height = std::max(m_nodes[node.left].height, m_nodes[node.right].height) + 1;
 }
 
 int32_t DynamicAABBTree::findBestSibling(int32_t leafIndex) const {
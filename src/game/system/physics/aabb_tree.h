@@ -22,10 +22,12 @@ public:
      * @param aabb aabb of query object
      * @param meshIndices vector to store mesh indices
      * @param capsuleIndices vector to store capsule indices
+     * @param heightfieldIndices vector to store heightfield indices
      */
     void query(ColliderTag caller, AABB const & aabb, 
-               prt::vector<uint16_t> & meshIndices,
-               prt::vector<uint16_t> & capsuleIndices,
+               prt::vector<ColliderIndex> & meshIndices,
+               prt::vector<ColliderIndex> & capsuleIndices,
+               prt::vector<ColliderIndex> & heightfieldIndices,
                ColliderType type);
 
     /**
@@ -39,6 +41,38 @@ public:
                       glm::vec3 const& direction,
                       float maxDistance,
                       prt::vector<ColliderTag> & tags);
+
+    /**
+     * Traverses the leaves intersected by a ray in front-to-back order.
+     * The callback is invoked as callback(tag, maxDistance) for every
+     * leaf and returns the new maximum distance of the ray, e.g. the
+     * distance of the closest hit so far. Nodes entered beyond the
+     * maximum distance are pruned and returning zero stops the traversal
+     * @param origin origin of the ray
+     * @param direction direction of the ray
+     * @param maxDistance maximum length of the ray
+     * @param callback callback invoked for every intersected leaf
+     */
+    template<typename Callback>
+    void raycast(glm::vec3 const & origin,
+                 glm::vec3 const & direction,
+                 float maxDistance,
+                 Callback && callback) const;
+
+    /**
+     * Traverses the leaves intersected by an aabb swept along a
+     * direction in front-to-back order. The callback follows the
+     * same protocol as for raycast
+     * @param aabb aabb at the start of the sweep
+     * @param direction direction of the sweep
+     * @param maxDistance maximum length of the sweep
+     * @param callback callback invoked for every intersected leaf
+     */
+    template<typename Callback>
+    void sweep(AABB const & aabb,
+               glm::vec3 const & direction,
+               float maxDistance,
+               Callback && callback) const;
     
     /**
      * Inserts aabbs along with their collider tags into the tree
@@ -47,9 +81,11 @@ public:
      * @param n number of aabbs to be inserted
      * @param treeIndices address to the start of the range that will 
      *                    recieve the resulting indices in the tree
+     * @param margin padding added to the leaves, zero for
+     *               colliders that are not expected to move
      */
     void insert(ColliderTag const * tags, AABB const * aabbs, size_t n,
-                int32_t * treeIndices);
+                int32_t * treeIndices, float margin = defaultMargin);
                 
     /**
      * Updates the nodes given by a range of tree indices which is then
@@ -61,6 +97,21 @@ public:
      */
     void update(int32_t * treeIndices, AABB const * aabbs, size_t n);
 
+    /**
+     * Updates the nodes given by a range of tree indices. Leaves
+     * that need to be reinserted are extended along their
+     * displacement so that they are likely to contain the aabb
+     * in the frames to come
+     * @param treeIndices address of the start of the range of tree indices
+     *                    that will be updated
+     * @param aabbs address of the start of the range of aabbs
+     * @param displacements address of the start of the range of
+     *                      displacements per frame
+     * @param n number of aabbs to be inserted
+     */
+    void update(int32_t * treeIndices, AABB const * aabbs,
+                glm::vec3 const * displacements, size_t n);
+
     /**
      * Updates the tags of nodes given by a range of tree indices
      * @param treeIndices address of the start of the range of tree indices
@@ -77,6 +128,14 @@ public:
      */
     void remove(int32_t * treeIndices, size_t n);
 
+    /**
+     * Reinserts the leaves that add the most area to their
+     * parents, which undoes the decay in tree quality as
+     * leaves move about. Tree indices of leaves are preserved
+     * @param budget maximum number of leaves to reinsert
+     */
+    void optimize(unsigned int budget);
+
     /**
      * The cost heuristic is defined as
      * the total surface area of all nodes
@@ -85,24 +144,57 @@ public:
      */
     float cost() const;
 
+    /**
+     * @return memory held by nodes in bytes
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @return number of nodes visited by queries
+     *         since the last reset, for profiling
+     */
+    uint32_t getNodesVisited() const { return m_nodesVisited; }
+    void resetNodesVisited() { m_nodesVisited = 0; }
+
+    /**
+     * @return number of leaves reinserted by update
+     *         since the last reset, for profiling
+     */
+    uint32_t getReinsertions() const { return m_reinsertions; }
+    void resetReinsertions() { m_reinsertions = 0; }
+
+    static constexpr float defaultMargin = 0.05f;
+
 private:
     struct Node;
-    static constexpr float buffer = 0.05f; 
+    // how many frames of displacement a leaf is extended by
+    static constexpr float displacementMultiplier = 4.0f;
+    // leaves reaching further than this many margins
+    // beyond their predicted aabb are shrunk
+    static constexpr float shrinkMultiplier = 4.0f;
     int32_t rootIndex = Node::NULL_INDEX;
 
     int32_t freeHead = Node::NULL_INDEX; // free list
     int32_t m_size = 0;
     prt::vector<Node> m_nodes;
 
-    int32_t insertLeaf(ColliderTag tag, AABB const & aabb);
+    mutable uint32_t m_nodesVisited = 0;
+    uint32_t m_reinsertions = 0;
+
+    int32_t insertLeaf(ColliderTag tag, AABB const & aabb, float margin);
+    static AABB fatten(AABB const & aabb, float margin, glm::vec3 const & displacement);
     void remove(int32_t index);
 
     void freeNode(int32_t index);
 
     int32_t allocateNode();
 
+    void attachLeaf(int32_t leafIndex);
+    void detachLeaf(int32_t index);
+
     void synchHierarchy(int32_t index);
-    void balance(int32_t index);
+    void rotate(int32_t index);
+    void swapChildren(int32_t parentA, int32_t childA, int32_t parentB, int32_t childB);
 
     int32_t findBestSibling(int32_t leafIndex) const;
 
@@ -115,6 +207,9 @@ private:
         // leaf = 0, free nodes = -1
         int32_t height = 0;
 
+        // padding of leaves
+        float margin = 0.0f;
+
         static constexpr int32_t NULL_INDEX = -1;
 
         bool isLeaf() const { return right == NULL_INDEX; }
@@ -147,4 +242,80 @@ private:
     };
 };
 
+template<typename Callback>
+void DynamicAABBTree::raycast(glm::vec3 const & origin,
+                              glm::vec3 const & direction,
+                              float maxDistance,
+                              Callback && callback) const {
+    sweep(AABB{origin, origin}, direction, maxDistance, callback);
+}
+
+template<typename Callback>
+void DynamicAABBTree::sweep(AABB const & aabb,
+                            glm::vec3 const & direction,
+                            float maxDistance,
+                            Callback && callback) const {
+    if (m_size == 0) {
+        return;
+    }
+
+    // sweeping an aabb against a node is equivalent to casting
+    // a ray from its center against the node grown by its extent
+    glm::vec3 origin = 0.5f * (aabb.lowerBound + aabb.upperBound);
+    glm::vec3 extent = 0.5f * (aabb.upperBound - aabb.lowerBound);
+
+    float tEntry;
+    AABB rootAABB = { m_nodes[rootIndex].aabb.lowerBound - extent, m_nodes[rootIndex].aabb.upperBound + extent };
+    if (!AABB::intersectRay(rootAABB, origin, direction, maxDistance, tEntry)) {
+        return;
+    }
+
+    struct StackEntry {
+        int32_t index;
+        float tEntry;
+    };
+
+    prt::vector<StackEntry> nodeStack;
+    nodeStack.push_back({rootIndex, tEntry});
+    while (!nodeStack.empty()) {
+        StackEntry entry = nodeStack.back();
+        nodeStack.pop_back();
+        ++m_nodesVisited;
+        // the sweep may have been clipped since the node was pushed
+        if (entry.tEntry > maxDistance) {
+            continue;
+        }
+
+        Node const & node = m_nodes[entry.index];
+        if (node.isLeaf()) {
+            maxDistance = callback(node.colliderTag, maxDistance);
+            if (maxDistance <= 0.0f) {
+                return;
+            }
+            continue;
+        }
+
+        AABB leftAABB = { m_nodes[node.left].aabb.lowerBound - extent, m_nodes[node.left].aabb.upperBound + extent };
+        AABB rightAABB = { m_nodes[node.right].aabb.lowerBound - extent, m_nodes[node.right].aabb.upperBound + extent };
+        float tLeft;
+        float tRight;
+        bool hitLeft = AABB::intersectRay(leftAABB, origin, direction, maxDistance, tLeft);
+        bool hitRight = AABB::intersectRay(rightAABB, origin, direction, maxDistance, tRight);
+        // push the farther child first so that the nearer child is visited first
+        if (hitLeft && hitRight) {
+            if (tLeft <= tRight) {
+                nodeStack.push_back({node.right, tRight});
+                nodeStack.push_back({node.left, tLeft});
+            } else {
+                nodeStack.push_back({node.left, tLeft});
+                nodeStack.push_back({node.right, tRight});
+            }
+        } else if (hitLeft) {
+            nodeStack.push_back({node.left, tLeft});
+        } else if (hitRight) {
+            nodeStack.push_back({node.right, tRight});
+        }
+    }
+}
+
 #endif
@@ -3,27 +3,44 @@
 
 #include <cstdint>
 
-enum ColliderShape : uint8_t {
+enum ColliderShape : uint32_t {
     COLLIDER_SHAPE_NONE,
     COLLIDER_SHAPE_MODEL,
     COLLIDER_SHAPE_MESH,
     COLLIDER_SHAPE_CAPSULE,
+    COLLIDER_SHAPE_BOX,
+    COLLIDER_SHAPE_SPHERE,
+    COLLIDER_SHAPE_HEIGHTFIELD,
     TOTAL_NUM_COLLIDER_SHAPES
 };
 
-enum ColliderType : uint8_t {
+enum ColliderType : uint32_t {
     COLLIDER_TYPE_ERROR,
     COLLIDER_TYPE_TRIGGER,
     COLLIDER_TYPE_COLLIDE,
     TOTAL_NUM_COLLIDER_TYPES
 };
 
-typedef uint16_t ColliderIndex;
+typedef uint32_t ColliderIndex;
 
+// index, shape and type packed into a single word,
+// so that tags stay small inside aabb tree nodes
 struct ColliderTag {
-    ColliderIndex index;
-    ColliderShape shape = ColliderShape::COLLIDER_SHAPE_NONE;
-    ColliderType type = ColliderType::COLLIDER_TYPE_ERROR;
+    static constexpr uint32_t indexBits = 24;
+    static constexpr ColliderIndex maxIndex = (ColliderIndex(1) << indexBits) - 1;
+
+    ColliderIndex index : indexBits;
+    ColliderShape shape : 4;
+    ColliderType type : 4;
+
+    ColliderTag()
+        : index(0), 
+          shape(ColliderShape::COLLIDER_SHAPE_NONE), 
+          type(ColliderType::COLLIDER_TYPE_ERROR) {}
+
+    ColliderTag(ColliderIndex index, ColliderShape shape, ColliderType type)
+        : index(index), shape(shape), type(type) {}
+
     friend bool operator== (ColliderTag const & c1, ColliderTag const & c2) {
         return (c1.index == c2.index &&
                 c1.shape == c2.shape &&
@@ -34,4 +51,8 @@ struct ColliderTag {
     }
 };
 
+static_assert(sizeof(ColliderTag) <= 4, "ColliderTag should fit in a single word!");
+static_assert(TOTAL_NUM_COLLIDER_SHAPES <= 16 && TOTAL_NUM_COLLIDER_TYPES <= 16, 
+              "Collider shapes and types should fit in four bits!");
+
 #endif
\ No newline at end of file
@@ -2,7 +2,6 @@
 #define COLLIDERS_H
 
 #include "src/game/component/component.h"
-#include "src/graphics/geometry/model.h"
 #include "src/game/system/physics/aabb.h"
 #include "src/game/system/physics/collider_tag.h"
 
@@ -11,6 +10,9 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <limits>
+
 struct CapsuleCollider {
     float height;
     float radius;
@@ -36,21 +38,114 @@ struct Polygon {
 };
 
 struct MeshCollider {
+    static constexpr unsigned int NULL_INDEX = std::numeric_limits<unsigned int>::max();
+
     Transform transform;
 
     unsigned int startIndex;
     unsigned int numIndices;
 
-    unsigned int modelIndex;
+    unsigned int modelIndex = NULL_INDEX;
+    // next mesh collider of the same model,
+    // or next free mesh collider
+    unsigned int next = NULL_INDEX;
 
-    bool hasMoved;
+    bool hasMoved = false;
+};
+
+// overlap-only volume, shape given by its collider tag.
+// Box, sphere and capsule triggers ignore transform scale
+struct TriggerCollider {
+    Transform transform;
+    glm::vec3 offset;
+
+    // box triggers
+    glm::vec3 halfExtents;
+    // sphere and capsule triggers
+    float radius;
+    // capsule triggers
+    float height;
+
+    // mesh triggers, three consecutive vertices per triangle
+    prt::vector<glm::vec3> raw;
+    // mesh vertices after applying transform
+    prt::vector<glm::vec3> cache;
+};
+
+// regular grid of quantized heights over the xz-plane.
+// Cell (x, z) spans samples (x, z) to (x + 1, z + 1)
+// and is split into two triangles along its diagonal
+struct HeightfieldCollider {
+    static constexpr uint16_t HOLE = std::numeric_limits<uint16_t>::max();
+
+    // position of sample (0, 0) at quantized height zero
+    glm::vec3 origin;
+    // distance between neighbouring samples
+    float cellSize;
+    // height of one quantization step
+    float heightScale;
+    // number of samples along x and z
+    unsigned int width = 0;
+    unsigned int depth = 0;
+    // samples row by row along x, HOLE marks samples without ground
+    prt::vector<uint16_t> heights;
+
+    glm::vec3 getVertex(unsigned int x, unsigned int z) const {
+        return origin + glm::vec3{ x * cellSize, heights[z * width + x] * heightScale, z * cellSize };
+    }
+
+    /**
+     * @param x cell x-coordinate, x + 1 < width
+     * @param z cell z-coordinate, z + 1 < depth
+     * @param first first triangle of cell, return by reference
+     * @param second second triangle of cell, return by reference
+     * @return false if the cell has a hole,
+     *         true otherwise
+     */
+    bool getCellTriangles(unsigned int x, unsigned int z, Polygon & first, Polygon & second) const {
+        size_t index = z * width + x;
+        if (heights[index] == HOLE || heights[index + 1] == HOLE ||
+            heights[index + width] == HOLE || heights[index + width + 1] == HOLE) {
+            return false;
+        }
+        glm::vec3 p00 = getVertex(x, z);
+        glm::vec3 p10 = getVertex(x + 1, z);
+        glm::vec3 p01 = getVertex(x, z + 1);
+        glm::vec3 p11 = getVertex(x + 1, z + 1);
+        // counter-clockwise seen from above
+        first = { p00, p01, p11 };
+        second = { p00, p11, p10 };
+        return true;
+    }
+
+    /**
+     * Finds the cells whose xz-extent overlaps aabb
+     * @return false if no cell overlaps aabb,
+     *         true otherwise
+     */
+    bool getCellRange(AABB const & aabb, 
+                      unsigned int & minX, unsigned int & minZ, 
+                      unsigned int & maxX, unsigned int & maxZ) const {
+        float lowX = (aabb.lowerBound.x - origin.x) / cellSize;
+        float lowZ = (aabb.lowerBound.z - origin.z) / cellSize;
+        float highX = (aabb.upperBound.x - origin.x) / cellSize;
+        float highZ = (aabb.upperBound.z - origin.z) / cellSize;
+        if (highX < 0.0f || highZ < 0.0f || lowX >= width - 1 || lowZ >= depth - 1) {
+            return false;
+        }
+        minX = static_cast<unsigned int>(std::max(lowX, 0.0f));
+        minZ = static_cast<unsigned int>(std::max(lowZ, 0.0f));
+        maxX = static_cast<unsigned int>(std::min(highX, float(width - 2)));
+        maxZ = static_cast<unsigned int>(std::min(highZ, float(depth - 2)));
+        return true;
+    }
 };
 
 struct ModelCollider {
     // index of the first mesh collider
-    unsigned int startIndex;
-    // // number of mesh colliders
-    unsigned int numIndices;
+    unsigned int startIndex = MeshCollider::NULL_INDEX;
+    // number of mesh colliders
+    unsigned int numIndices = 0;
 };
 
 #endif
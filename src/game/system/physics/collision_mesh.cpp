@@ -0,0 +1,455 @@
+#include "collision_mesh.h"
+
+#include "src/container/priority_queue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    // sum of squared distances to a set of planes,
+    // "Surface Simplification Using Quadric Error Metrics"
+    // by Garland and Heckbert
+    struct Quadric {
+        // upper triangle of the symmetric 4x4 matrix
+        double aa = 0, ab = 0, ac = 0, ad = 0;
+        double bb = 0, bc = 0, bd = 0;
+        double cc = 0, cd = 0;
+        double dd = 0;
+
+        static Quadric plane(glm::vec3 const & normal, glm::vec3 const & point, double weight) {
+            double a = normal.x;
+            double b = normal.y;
+            double c = normal.z;
+            double d = -glm::dot(normal, point);
+            Quadric q;
+            q.aa = weight * a * a; q.ab = weight * a * b; q.ac = weight * a * c; q.ad = weight * a * d;
+            q.bb = weight * b * b; q.bc = weight * b * c; q.bd = weight * b * d;
+            q.cc = weight * c * c; q.cd = weight * c * d;
+            q.dd = weight * d * d;
+            return q;
+        }
+
+        Quadric & operator+=(Quadric const & other) {
+            aa += other.aa; ab += other.ab; ac += other.ac; ad += other.ad;
+            bb += other.bb; bc += other.bc; bd += other.bd;
+            cc += other.cc; cd += other.cd;
+            dd += other.dd;
+            return *this;
+        }
+
+        double error(glm::vec3 const & p) const {
+            double x = p.x;
+            double y = p.y;
+            double z = p.z;
+            return aa * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+                   bb * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+                   cc * z * z + 2.0 * cd * z +
+                   dd;
+        }
+    };
+
+    struct EdgeCollapse {
+        double cost;
+        glm::vec3 position;
+        uint32_t from;
+        uint32_t to;
+        // vertex versions when the collapse was computed
+        uint32_t fromVersion;
+        uint32_t toVersion;
+        friend bool operator<(EdgeCollapse const & lhs, EdgeCollapse const & rhs) { return lhs.cost < rhs.cost; }
+    };
+
+    struct Triangle {
+        uint32_t v[3];
+        bool removed = false;
+        bool contains(uint32_t vertex) const { return v[0] == vertex || v[1] == vertex || v[2] == vertex; }
+    };
+
+    class MeshSimplifier {
+    public:
+        MeshSimplifier(CollisionMeshSettings const & settings, float extent)
+            : m_settings(settings),
+              m_weldDistance(std::max(settings.weldTolerance * extent, std::numeric_limits<float>::min())),
+              m_maxMergeError(double(settings.coplanarTolerance * extent) * double(settings.coplanarTolerance * extent)) {}
+
+        void simplify(glm::vec3 const * vertices, size_t nVertices,
+                      unsigned int targetTriangles,
+                      prt::vector<glm::vec3> & result) {
+            weld(vertices, nVertices);
+            dropDegenerates();
+            buildAdjacency();
+            buildQuadrics();
+            collapseEdges(targetTriangles);
+
+            for (Triangle const & tri : m_triangles) {
+                if (!tri.removed) {
+                    result.push_back(m_positions[tri.v[0]]);
+                    result.push_back(m_positions[tri.v[1]]);
+                    result.push_back(m_positions[tri.v[2]]);
+                }
+            }
+        }
+
+    private:
+        // weight of border planes relative to triangle planes
+        static constexpr double borderWeight = 10.0;
+
+        CollisionMeshSettings const & m_settings;
+        float m_weldDistance;
+        double m_maxMergeError;
+
+        prt::vector<glm::vec3> m_positions;
+        prt::vector<Quadric> m_quadrics;
+        prt::vector<uint32_t> m_versions;
+        prt::vector<bool> m_alive;
+        prt::vector<bool> m_boundary;
+        prt::vector<Triangle> m_triangles;
+        // triangles adjacent to each vertex
+        prt::vector<prt::vector<uint32_t> > m_vertexTriangles;
+        size_t m_nTriangles = 0;
+
+        prt::priority_queue<EdgeCollapse> m_queue;
+
+        void weld(glm::vec3 const * vertices, size_t nVertices) {
+            struct Key {
+                int64_t x, y, z;
+                uint32_t index;
+                bool operator<(Key const & other) const {
+                    return x < other.x || (x == other.x && (y < other.y || (y == other.y && z < other.z)));
+                }
+                bool operator==(Key const & other) const { return x == other.x && y == other.y && z == other.z; }
+            };
+            prt::vector<Key> keys;
+            keys.resize(nVertices);
+            for (size_t i = 0; i < nVertices; ++i) {
+                keys[i] = { int64_t(std::llround(vertices[i].x / m_weldDistance)),
+                            int64_t(std::llround(vertices[i].y / m_weldDistance)),
+                            int64_t(std::llround(vertices[i].z / m_weldDistance)),
+                            uint32_t(i) };
+            }
+            std::sort(keys.data(), keys.data() + keys.size());
+
+            prt::vector<uint32_t> remap;
+            remap.resize(nVertices);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (i == 0 || !(keys[i] == keys[i - 1])) {
+                    m_positions.push_back(vertices[keys[i].index]);
+                }
+                remap[keys[i].index] = m_positions.size() - 1;
+            }
+
+            m_triangles.resize(nVertices / 3);
+            for (size_t i = 0; i < m_triangles.size(); ++i) {
+                m_triangles[i].v[0] = remap[3 * i];
+                m_triangles[i].v[1] = remap[3 * i + 1];
+                m_triangles[i].v[2] = remap[3 * i + 2];
+            }
+        }
+
+        bool isSliver(glm::vec3 const & a, glm::vec3 const & b, glm::vec3 const & c) const {
+            float longest = std::max(std::max(glm::dot(b - a, b - a), glm::dot(c - b, c - b)), glm::dot(a - c, a - c));
+            float doubleArea = glm::length(glm::cross(b - a, c - a));
+            // height relative to the longest edge is
+            // twice the area over the squared longest edge
+            return doubleArea <= m_settings.sliverRatio * longest;
+        }
+
+        void dropDegenerates() {
+            size_t kept = 0;
+            for (size_t i = 0; i < m_triangles.size(); ++i) {
+                Triangle const & tri = m_triangles[i];
+                if (tri.v[0] == tri.v[1] || tri.v[1] == tri.v[2] || tri.v[2] == tri.v[0] ||
+                    isSliver(m_positions[tri.v[0]], m_positions[tri.v[1]], m_positions[tri.v[2]])) {
+                    continue;
+                }
+                m_triangles[kept] = tri;
+                ++kept;
+            }
+            m_triangles.resize(kept);
+            m_nTriangles = kept;
+        }
+
+        void buildAdjacency() {
+            m_vertexTriangles.resize(m_positions.size());
+            for (size_t i = 0; i < m_triangles.size(); ++i) {
+                for (uint32_t v : m_triangles[i].v) {
+                    m_vertexTriangles[v].push_back(i);
+                }
+            }
+            m_versions.resize(m_positions.size());
+            m_alive.resize(m_positions.size());
+            m_boundary.resize(m_positions.size());
+            for (size_t i = 0; i < m_positions.size(); ++i) {
+                m_versions[i] = 0;
+                m_alive[i] = true;
+                m_boundary[i] = false;
+            }
+        }
+
+        // number of live triangles sharing edge (a, b)
+        unsigned int countEdgeTriangles(uint32_t a, uint32_t b) const {
+            unsigned int count = 0;
+            for (uint32_t t : m_vertexTriangles[a]) {
+                if (!m_triangles[t].removed && m_triangles[t].contains(b)) {
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        void buildQuadrics() {
+            m_quadrics.resize(m_positions.size());
+            for (Triangle const & tri : m_triangles) {
+                glm::vec3 const & a = m_positions[tri.v[0]];
+                glm::vec3 const & b = m_positions[tri.v[1]];
+                glm::vec3 const & c = m_positions[tri.v[2]];
+                glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+                Quadric q = Quadric::plane(normal, a, 1.0);
+                for (int i = 0; i < 3; ++i) {
+                    m_quadrics[tri.v[i]] += q;
+
+                    // constrain open borders with planes perpendicular to
+                    // the triangle, so that they keep their outline
+                    uint32_t from = tri.v[i];
+                    uint32_t to = tri.v[(i + 1) % 3];
+                    if (countEdgeTriangles(from, to) != 2) {
+                        glm::vec3 edge = m_positions[to] - m_positions[from];
+                        glm::vec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+                        Quadric border = Quadric::plane(borderNormal, m_positions[from], borderWeight);
+                        m_quadrics[from] += border;
+                        m_quadrics[to] += border;
+                        m_boundary[from] = true;
+                        m_boundary[to] = true;
+                    }
+                }
+            }
+        }
+
+        void pushEdge(uint32_t a, uint32_t b) {
+            Quadric q = m_quadrics[a];
+            q += m_quadrics[b];
+            glm::vec3 candidates[3] = { m_positions[b], m_positions[a], 0.5f * (m_positions[a] + m_positions[b]) };
+            EdgeCollapse collapse;
+            collapse.cost = std::numeric_limits<double>::max();
+            for (glm::vec3 const & candidate : candidates) {
+                double cost = std::max(q.error(candidate), 0.0);
+                if (cost < collapse.cost) {
+                    collapse.cost = cost;
+                    collapse.position = candidate;
+                }
+            }
+            collapse.from = a;
+            collapse.to = b;
+            collapse.fromVersion = m_versions[a];
+            collapse.toVersion = m_versions[b];
+            m_queue.push(collapse);
+        }
+
+        void pushEdges(uint32_t vertex) {
+            for (uint32_t t : m_vertexTriangles[vertex]) {
+                Triangle const & tri = m_triangles[t];
+                for (uint32_t other : tri.v) {
+                    // push each edge once from its lower vertex
+                    if (vertex < other) {
+                        pushEdge(vertex, other);
+                    }
+                }
+            }
+        }
+
+        void gatherNeighbours(uint32_t vertex, prt::vector<uint32_t> & neighbours) const {
+            for (uint32_t t : m_vertexTriangles[vertex]) {
+                for (uint32_t other : m_triangles[t].v) {
+                    if (other != vertex) {
+                        neighbours.push_back(other);
+                    }
+                }
+            }
+            std::sort(neighbours.data(), neighbours.data() + neighbours.size());
+            uint32_t * last = std::unique(neighbours.data(), neighbours.data() + neighbours.size());
+            neighbours.resize(last - neighbours.data());
+        }
+
+        bool canCollapse(EdgeCollapse const & collapse) const {
+            uint32_t from = collapse.from;
+            uint32_t to = collapse.to;
+
+            unsigned int shared = countEdgeTriangles(from, to);
+            if (shared == 0 || shared > 2) {
+                return false;
+            }
+            // collapsing an interior edge between two borders pinches the mesh
+            if (shared == 2 && m_boundary[from] && m_boundary[to]) {
+                return false;
+            }
+
+            // link condition: the vertices may only share the
+            // neighbours opposite to their common edge
+            prt::vector<uint32_t> fromNeighbours;
+            prt::vector<uint32_t> toNeighbours;
+            gatherNeighbours(from, fromNeighbours);
+            gatherNeighbours(to, toNeighbours);
+            unsigned int common = 0;
+            size_t i = 0;
+            size_t j = 0;
+            while (i < fromNeighbours.size() && j < toNeighbours.size()) {
+                if (fromNeighbours[i] < toNeighbours[j]) {
+                    ++i;
+                } else if (toNeighbours[j] < fromNeighbours[i]) {
+                    ++j;
+                } else {
+                    ++common;
+                    ++i;
+                    ++j;
+                }
+            }
+            if (common != shared) {
+                return false;
+            }
+
+            // remaining triangles may neither flip nor turn into slivers
+            for (uint32_t vertex : { from, to }) {
+                for (uint32_t t : m_vertexTriangles[vertex]) {
+                    Triangle const & tri = m_triangles[t];
+                    if (tri.contains(from) && tri.contains(to)) {
+                        continue;
+                    }
+                    glm::vec3 before[3];
+                    glm::vec3 after[3];
+                    for (int k = 0; k < 3; ++k) {
+                        before[k] = m_positions[tri.v[k]];
+                        after[k] = tri.v[k] == vertex ? collapse.position : before[k];
+                    }
+                    glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    if (glm::dot(normalBefore, normalAfter) <= 0.0f ||
+                        isSliver(after[0], after[1], after[2])) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void collapse(EdgeCollapse const & collapse) {
+            uint32_t from = collapse.from;
+            uint32_t to = collapse.to;
+
+            m_positions[to] = collapse.position;
+            m_quadrics[to] += m_quadrics[from];
+            m_boundary[to] = m_boundary[to] || m_boundary[from];
+            m_alive[from] = false;
+            ++m_versions[from];
+            ++m_versions[to];
+
+            for (uint32_t t : m_vertexTriangles[from]) {
+                Triangle & tri = m_triangles[t];
+                if (tri.contains(to)) {
+                    tri.removed = true;
+                    --m_nTriangles;
+                } else {
+                    for (uint32_t & v : tri.v) {
+                        if (v == from) {
+                            v = to;
+                        }
+                    }
+                    m_vertexTriangles[to].push_back(t);
+                }
+            }
+            m_vertexTriangles[from].clear();
+
+            // forget removed triangles
+            prt::vector<uint32_t> neighbours;
+            gatherNeighbours(to, neighbours);
+            for (uint32_t vertex : neighbours) {
+                removeDeadTriangles(vertex);
+            }
+            removeDeadTriangles(to);
+
+            for (uint32_t vertex : neighbours) {
+                if (m_alive[vertex]) {
+                    pushEdge(std::min(vertex, to), std::max(vertex, to));
+                }
+            }
+        }
+
+        void removeDeadTriangles(uint32_t vertex) {
+            prt::vector<uint32_t> & triangles = m_vertexTriangles[vertex];
+            size_t kept = 0;
+            for (size_t i = 0; i < triangles.size(); ++i) {
+                if (!m_triangles[triangles[i]].removed) {
+                    triangles[kept] = triangles[i];
+                    ++kept;
+                }
+            }
+            triangles.resize(kept);
+        }
+
+        void collapseEdges(unsigned int targetTriangles) {
+            for (uint32_t v = 0; v < m_positions.size(); ++v) {
+                pushEdges(v);
+            }
+
+            while (!m_queue.empty()) {
+                EdgeCollapse top = m_queue.top();
+                m_queue.pop();
+
+                // merge coplanar triangles for free, and
+                // beyond that only to stay within budget
+                if (top.cost > m_maxMergeError && m_nTriangles <= targetTriangles) {
+                    break;
+                }
+                if (!m_alive[top.from] || !m_alive[top.to] ||
+                    m_versions[top.from] != top.fromVersion ||
+                    m_versions[top.to] != top.toVersion) {
+                    continue;
+                }
+                if (canCollapse(top)) {
+                    collapse(top);
+                }
+            }
+        }
+    };
+}
+
+void collision_mesh::build(glm::vec3 const * vertices,
+                           unsigned int const * meshSizes,
+                           size_t nMeshes,
+                           CollisionMeshSettings const & settings,
+                           CollisionMesh & result) {
+    size_t nVertices = 0;
+    for (size_t i = 0; i < nMeshes; ++i) {
+        nVertices += meshSizes[i];
+    }
+    if (nVertices == 0) {
+        result.meshSizes.resize(nMeshes);
+        for (size_t i = 0; i < nMeshes; ++i) {
+            result.meshSizes[i] = 0;
+        }
+        return;
+    }
+
+    glm::vec3 min = vertices[0];
+    glm::vec3 max = vertices[0];
+    for (size_t i = 0; i < nVertices; ++i) {
+        min = glm::min(min, vertices[i]);
+        max = glm::max(max, vertices[i]);
+    }
+    float extent = glm::length(max - min);
+
+    size_t start = 0;
+    for (size_t i = 0; i < nMeshes; ++i) {
+        // share the budget between meshes by their size
+        unsigned int targetTriangles = settings.targetTriangles == 0 ?
+                                       meshSizes[i] / 3 :
+                                       std::max(static_cast<unsigned int>(double(settings.targetTriangles) * meshSizes[i] / nVertices), 1u);
+
+        size_t prevSize = result.vertices.size();
+        MeshSimplifier simplifier(settings, extent);
+        simplifier.simplify(vertices + start, meshSizes[i], targetTriangles, result.vertices);
+        result.meshSizes.push_back(result.vertices.size() - prevSize);
+        start += meshSizes[i];
+    }
+}
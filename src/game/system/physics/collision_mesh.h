@@ -0,0 +1,54 @@
+#ifndef PRT_COLLISION_MESH_H
+#define PRT_COLLISION_MESH_H
+
+#include "src/container/vector.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+struct CollisionMesh {
+    // triangle vertices, three consecutive vertices per triangle
+    prt::vector<glm::vec3> vertices;
+    // number of vertices per mesh
+    prt::vector<unsigned int> meshSizes;
+};
+
+struct CollisionMeshSettings {
+    // vertices closer than this, relative to the
+    // extent of the model, are welded together
+    float weldTolerance = 0.0001f;
+    // triangles whose height is less than this ratio
+    // of their longest edge are dropped as slivers
+    float sliverRatio = 0.001f;
+    // coplanar triangles are merged while they stay within
+    // this distance, relative to the extent of the model
+    float coplanarTolerance = 0.0001f;
+    // if non-zero, triangles are merged further until the
+    // model is made up of no more than this many triangles
+    unsigned int targetTriangles = 0;
+};
+
+namespace collision_mesh {
+    /**
+     * Builds collision geometry from render geometry by
+     * welding vertices by position, dropping degenerate
+     * and sliver triangles and collapsing edges by quadric
+     * error, which merges coplanar triangles and optionally
+     * simplifies the meshes to a triangle budget.
+     * Meshes are kept apart and may end up empty
+     * @param vertices base pointer to triangle vertices,
+     *                 three consecutive vertices per triangle
+     * @param meshSizes base pointer to number of vertices per mesh
+     * @param nMeshes number of meshes
+     * @param settings simplification settings
+     * @param result resulting collision mesh, return by reference
+     */
+    void build(glm::vec3 const * vertices,
+               unsigned int const * meshSizes,
+               size_t nMeshes,
+               CollisionMeshSettings const & settings,
+               CollisionMesh & result);
+};
+
+#endif
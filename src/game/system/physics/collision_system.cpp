@@ -8,16 +8,35 @@
 #include <glm/gtx/matrix_operation.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
+
 CollisionSystem::CollisionSystem() {}
 
 void CollisionSystem::newFrame() {
-    m_entityToPrevCollisions = std::move(m_entityToCollisions);
-    m_entityToPrevTriggers = std::move(m_entityToTriggers);
+    assert(m_sorted && "Collisions of the previous frame were never sorted!");
+    // swap to keep the capacity of both buffers
+    std::swap(m_collisions, m_prevCollisions);
+    m_collisions.resize(0);
+}
+
+void CollisionSystem::keepCollisions(EntityID entityID, prt::hash_set<EntityID> & simulated) {
+    for (CollisionEntry const & entry : findEntity(m_prevCollisions, entityID)) {
+        if (simulated.find(entry.result.other) != simulated.end()) {
+            continue;
+        }
+        m_collisions.push_back(entry);
+        // the other entity's side of the collision
+        for (CollisionEntry const & otherEntry : findEntity(m_prevCollisions, entry.result.other)) {
+            if (otherEntry.result.other == entityID) {
+                m_collisions.push_back(otherEntry);
+            }
+        }
+        m_sorted = false;
+    }
 }
 
 // Thank you, Turanszkij: https://wickedengine.net/2020/04/26/capsule-collision-detection/
-void CollisionSystem::collideCapsuleMesh(Scene & scene,
-                                         CollisionPackage &      package,
+void CollisionSystem::collideCapsuleMesh(CollisionPackage &      package,
                                          CapsuleCollider const & capsule,
                                          AggregateMeshCollider const & aggregateMeshCollider) {
     Transform & transform = *package.transform;
@@ -150,13 +169,12 @@ void CollisionSystem::collideCapsuleMesh(Scene & scene,
             resB.intersectionPoint = resA.intersectionPoint;
             resB.other = package.entity;
 
-            handleCollision(scene, package, resA, resB);
+            handleCollision(package, resA, resB);
         }
     }
 }
 
-void CollisionSystem::collideCapsuleCapsule(Scene & scene,
-                                            CollisionPackage &      packageA,
+bool CollisionSystem::collideCapsuleCapsule(CollisionPackage &      packageA,
                                             CapsuleCollider const & capsuleA,
                                             CollisionPackage &      packageB,
                                             CapsuleCollider const & capsuleB) {
@@ -229,161 +247,93 @@ void CollisionSystem::collideCapsuleCapsule(Scene & scene,
         resB.intersectionPoint = resA.intersectionPoint;
         resB.other = packageA.entity;
 
-        handleCollision(scene, packageA, resA, resB);
+        handleCollision(packageA, resA, resB);
     }
+    return intersects;
 }
 
-void CollisionSystem::handleCollision(Scene & scene,
-                                      CollisionPackage & package,
+void CollisionSystem::handleCollision(CollisionPackage & package,
                                       CollisionResult const & resultA,
                                       CollisionResult const & resultB) {
     switch (package.tag.type) {
         case COLLIDER_TYPE_COLLIDE: {
             package.transform->position += resultA.impulse;
-            package.character->attributeInfo.updateEquipment(package.character->id, scene);
 
             bool groundCollision = glm::dot(resultA.collisionNormal, glm::vec3{0.0f,1.0f,0.0f}) > 0.3f;
 
             if (groundCollision) {
-                package.character->physics.isGrounded = true;
+                package.physics->isGrounded = true;
                 // TODO: figure out a way to pick no more
                 //       than one ground normal
-                package.character->physics.groundNormal = resultA.collisionNormal;
-            }
-
-            if (m_entityToCollisions.find(resultB.other) == m_entityToCollisions.end()) {
-                m_entityToCollisions.insert(resultB.other, {});
-            }
-
-            if (m_entityToCollisions.find(resultA.other) == m_entityToCollisions.end()) {
-                m_entityToCollisions.insert(resultA.other, {});
+                package.physics->groundNormal = resultA.collisionNormal;
             }
 
-            m_entityToCollisions[resultB.other].insert({resultA});
-            m_entityToCollisions[resultA.other].insert({resultB});
+            m_collisions.push_back({ resultB.other, resultA });
+            m_collisions.push_back({ resultA.other, resultB });
+            m_sorted = false;
 
             break;
         }
-        case COLLIDER_TYPE_TRIGGER: {
-            if (m_entityToTriggers.find(resultB.other) == m_entityToTriggers.end()) {
-                m_entityToTriggers.insert(resultB.other, {});
-            }
-
-            if (m_entityToTriggers.find(resultA.other) == m_entityToTriggers.end()) {
-                m_entityToTriggers.insert(resultA.other, {});
-            }
-
-            m_entityToTriggers[resultB.other].insert({resultA});
-            m_entityToTriggers[resultA.other].insert({resultB});
-            break;
-        }
         default: {}
     }
 }
 
 
-prt::vector<CollisionResult> CollisionSystem::queryCollision(EntityID entityID) {
-    if (m_entityToCollisions.find(entityID) == m_entityToCollisions.end()) {
-        return {};
-    } else {
-        prt::vector<CollisionResult> res;
-        prt::hash_set<CollisionSetEntry> & set = m_entityToCollisions[entityID];
-        res.reserve(set.size());
-        for (auto it = set.begin(); it != set.end(); it++) {
-            CollisionSetEntry & entry = it->value();
-            res.push_back(entry.result);
-        }
-        return res;
-    }
-}
-
-prt::vector<CollisionResult> CollisionSystem::queryCollisionEntry(EntityID entityID) {
-    if (m_entityToCollisions.find(entityID) == m_entityToCollisions.end()) {
-        return {};
-    } else {
-        prt::vector<CollisionResult> res;
-        prt::hash_set<CollisionSetEntry> & set = m_entityToCollisions[entityID];
-        res.reserve(set.size());
-        for (auto it = set.begin(); it != set.end(); it++) {
-            CollisionSetEntry & entry = it->value();
-            if (m_entityToPrevCollisions.find(entry.result.other) == m_entityToPrevCollisions.end()) {
-                res.push_back(entry.result);
-            }
-        }
-        return res;
-    }
-}
-
-prt::vector<CollisionResult> CollisionSystem::queryCollisionExit(EntityID entityID) {
-    if (m_entityToPrevCollisions.find(entityID) == m_entityToPrevCollisions.end()) {
-        return {};
-    } else {
-        prt::vector<CollisionResult> res;
-        prt::hash_set<CollisionSetEntry> & set = m_entityToPrevCollisions[entityID];
-        res.reserve(set.size());
-        for (auto it = set.begin(); it != set.end(); it++) {
-            CollisionSetEntry & entry = it->value();
-            if (m_entityToCollisions.find(entry.result.other) == m_entityToCollisions.end()) {
-                res.push_back(entry.result);
-            }
-        }
-        return res;
-    }
-}
-
-prt::vector<CollisionResult> CollisionSystem::queryTrigger(EntityID entityID) {
-    if (m_entityToTriggers.find(entityID) == m_entityToTriggers.end()) {
-        return {};
-    } else {
-        prt::vector<CollisionResult> res;
-        prt::hash_set<CollisionSetEntry> & set = m_entityToTriggers[entityID];
-        res.reserve(set.size());
-        for (auto it = set.begin(); it != set.end(); it++) {
-            CollisionSetEntry & entry = it->value();
-            res.push_back(entry.result);
+void CollisionSystem::sortCollisions() {
+    // keep the first collision of each pair
+    CollisionEntry * first = m_collisions.data();
+    CollisionEntry * last = first + m_collisions.size();
+    std::stable_sort(first, last);
+    last = std::unique(first, last, [](CollisionEntry const & lhs, CollisionEntry const & rhs) {
+        return !(lhs < rhs) && !(rhs < lhs);
+    });
+    m_collisions.resize(last - first);
+    m_sorted = true;
+
+    // diff sorted collisions against the previous frame
+    m_entries.resize(0);
+    m_exits.resize(0);
+    CollisionEntry const * curr = m_collisions.data();
+    CollisionEntry const * currEnd = curr + m_collisions.size();
+    CollisionEntry const * prev = m_prevCollisions.data();
+    CollisionEntry const * prevEnd = prev + m_prevCollisions.size();
+    while (curr != currEnd || prev != prevEnd) {
+        if (prev == prevEnd || (curr != currEnd && *curr < *prev)) {
+            m_entries.push_back(*curr);
+            ++curr;
+        } else if (curr == currEnd || *prev < *curr) {
+            m_exits.push_back(*prev);
+            ++prev;
+        } else {
+            ++curr;
+            ++prev;
         }
-        return res;
     }
 }
 
-prt::vector<CollisionResult> CollisionSystem::queryTriggerEntry(EntityID entityID) {
-    if (m_entityToTriggers.find(entityID) == m_entityToTriggers.end()) {
-        return {};
-    } else {
-        prt::vector<CollisionResult> res;
-        prt::hash_set<CollisionSetEntry> & set = m_entityToTriggers[entityID];
-        res.reserve(set.size());
-        for (auto it = set.begin(); it != set.end(); it++) {
-            CollisionSetEntry & entry = it->value();
-            if (m_entityToPrevTriggers.find(entry.result.other) == m_entityToPrevTriggers.end()) {
-                res.push_back(entry.result);
-            }
-        }
-        return res;
-    }
+CollisionSpan CollisionSystem::queryCollision(EntityID entityID) const {
+    assert(m_sorted && "Collisions must be sorted before they are queried!");
+    return findEntity(m_collisions, entityID);
 }
 
-prt::vector<CollisionResult> CollisionSystem::queryTriggerExit(EntityID entityID) {
-    if (m_entityToPrevTriggers.find(entityID) == m_entityToPrevTriggers.end()) {
-        return {};
-    } else {
-        prt::vector<CollisionResult> res;
-        prt::hash_set<CollisionSetEntry> & set = m_entityToPrevTriggers[entityID];
-        res.reserve(set.size());
-        for (auto it = set.begin(); it != set.end(); it++) {
-            CollisionSetEntry & entry = it->value();
-            if (m_entityToTriggers.find(entry.result.other) == m_entityToTriggers.end()) {
-                res.push_back(entry.result);
-            }
-        }
-        return res;
-    }
+CollisionSpan CollisionSystem::queryCollisionEntry(EntityID entityID) const {
+    assert(m_sorted && "Collisions must be sorted before they are queried!");
+    return findEntity(m_entries, entityID);
 }
 
-bool operator==(const CollisionSetEntry& lhs, const CollisionSetEntry& rhs) {
-    return lhs.result.other == rhs.result.other;
+CollisionSpan CollisionSystem::queryCollisionExit(EntityID entityID) const {
+    assert(m_sorted && "Collisions must be sorted before they are queried!");
+    return findEntity(m_exits, entityID);
 }
 
-bool operator!=(const CollisionSetEntry& lhs, const CollisionSetEntry& rhs) {
-    return !(lhs == rhs);
+CollisionSpan CollisionSystem::findEntity(prt::vector<CollisionEntry> const & entries, EntityID entityID) {
+    CollisionEntry const * first = entries.data();
+    CollisionEntry const * last = first + entries.size();
+    first = std::lower_bound(first, last, entityID, [](CollisionEntry const & entry, EntityID id) {
+        return entry.entity < id;
+    });
+    last = std::upper_bound(first, last, entityID, [](EntityID id, CollisionEntry const & entry) {
+        return id < entry.entity;
+    });
+    return { first, last };
 }
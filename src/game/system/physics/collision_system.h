@@ -3,7 +3,9 @@
 
 #include "src/game/system/physics/colliders.h"
 #include "src/game/system/physics/collider_tag.h"
-#include "src/game/system/character/character.h"
+#include "src/game/system/character/character_physics.h"
+#include "src/game/scene/id.h"
+#include "src/container/hash_set.h"
 
 #include <glm/glm.hpp>
 
@@ -18,8 +20,8 @@ struct CollisionResult {
 struct CollisionPackage {
     ColliderTag tag;
     EntityID entity;
-    Transform * transform = nullptr;;
-    Character * character = nullptr;
+    Transform * transform = nullptr;
+    CharacterPhysics * physics = nullptr;
 };
 
 struct AggregateMeshCollider {
@@ -34,17 +36,25 @@ struct AggregateMeshCollider {
     prt::vector<TagOffset> tagOffsets;
 };
 
-struct CollisionSetEntry {
+struct CollisionEntry {
+    EntityID entity;
     CollisionResult result;
+    friend bool operator<(CollisionEntry const & lhs, CollisionEntry const & rhs) {
+        return lhs.entity < rhs.entity ||
+               (lhs.entity == rhs.entity && lhs.result.other < rhs.result.other);
+    }
 };
 
-bool operator==(const CollisionSetEntry& lhs, const CollisionSetEntry& rhs);
-bool operator!=(const CollisionSetEntry& lhs, const CollisionSetEntry& rhs);
+// view into a range of collision entries,
+// valid until the next frame
+struct CollisionSpan {
+    CollisionEntry const * first = nullptr;
+    CollisionEntry const * last = nullptr;
 
-template<> struct std::hash<CollisionSetEntry> {
-    std::size_t operator()(CollisionSetEntry const& entry) const noexcept {
-        return std::hash<EntityID>{}(entry.result.other);
-    }
+    CollisionEntry const * begin() const { return first; }
+    CollisionEntry const * end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
 };
 
 class CollisionSystem {
@@ -53,35 +63,68 @@ public:
 
     void newFrame();
 
-    prt::vector<CollisionResult> queryCollision(EntityID entityID);
-    prt::vector<CollisionResult> queryCollisionEntry(EntityID entityID);
-    prt::vector<CollisionResult> queryCollisionExit(EntityID entityID);
-
-    prt::vector<CollisionResult> queryTrigger(EntityID entityID);
-    prt::vector<CollisionResult> queryTriggerEntry(EntityID entityID);
-    prt::vector<CollisionResult> queryTriggerExit(EntityID entityID);
-
-    void collideCapsuleMesh(Scene &                 scene,
-                            CollisionPackage &      package,
+    /**
+     * Sorts the collisions of the frame and finds the 
+     * collisions that began or ended since the previous
+     * frame. Must be called before querying collisions
+     */
+    void sortCollisions();
+
+    /**
+     * @param entityID entity
+     * @return collisions of entity this frame,
+     *         sorted by the other entity
+     */
+    CollisionSpan queryCollision(EntityID entityID) const;
+    /**
+     * @param entityID entity
+     * @return collisions of entity that began this frame
+     */
+    CollisionSpan queryCollisionEntry(EntityID entityID) const;
+    /**
+     * @param entityID entity
+     * @return collisions of entity that ended this frame
+     */
+    CollisionSpan queryCollisionExit(EntityID entityID) const;
+
+    /**
+     * Carries the collisions of an entity over from the
+     * previous frame, for entities that are not simulated
+     * @param entityID entity
+     * @param simulated entities whose collisions are found
+     *                  anew, collisions with them are dropped
+     */
+    void keepCollisions(EntityID entityID, prt::hash_set<EntityID> & simulated);
+
+    void collideCapsuleMesh(CollisionPackage &      package,
                             CapsuleCollider const & capsule,
                             AggregateMeshCollider const & aggregateMeshCollider);
 
-    void collideCapsuleCapsule(Scene & scene,
-                               CollisionPackage &      packageA,
+    /**
+     * Resolves intersection between two capsules by
+     * moving the capsule of packageA
+     * 
+     * @return true if the capsules intersect,
+     *         false otherwise
+     */
+    bool collideCapsuleCapsule(CollisionPackage &      packageA,
                                CapsuleCollider const & capsuleA,
                                CollisionPackage &      packageB,
                                CapsuleCollider const & capsuleB);
 
-    void handleCollision(Scene & scene,
-                         CollisionPackage & package,
+    void handleCollision(CollisionPackage & package,
                          CollisionResult const & resultA,
                          CollisionResult const & resultB);
 private:
-    prt::hash_map<EntityID, prt::hash_set<CollisionSetEntry> > m_entityToCollisions;
-    prt::hash_map<EntityID, prt::hash_set<CollisionSetEntry> > m_entityToPrevCollisions;
-
-    prt::hash_map<EntityID, prt::hash_set<CollisionSetEntry> > m_entityToTriggers;
-    prt::hash_map<EntityID, prt::hash_set<CollisionSetEntry> > m_entityToPrevTriggers;
+    // collisions of the current and previous frame, 
+    // sorted by entity and other entity once sorted
+    prt::vector<CollisionEntry> m_collisions;
+    prt::vector<CollisionEntry> m_prevCollisions;
+    prt::vector<CollisionEntry> m_entries;
+    prt::vector<CollisionEntry> m_exits;
+    bool m_sorted = true;
+
+    static CollisionSpan findEntity(prt::vector<CollisionEntry> const & entries, EntityID entityID);
 };
 
 #endif
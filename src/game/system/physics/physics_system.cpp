@@ -1,7 +1,5 @@
 #include "physics_system.h"
 
-#include "src/game/scene/scene.h"
-
 #include "src/util/physics_util.h"
 #include "src/util/math_util.h"
 
@@ -10,6 +8,9 @@
 #include <glm/gtx/matrix_operation.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #include <dirent.h>
 
 PhysicsSystem::PhysicsSystem() 
@@ -17,101 +18,155 @@ PhysicsSystem::PhysicsSystem()
 
 void PhysicsSystem::newFrame() {
     m_collisionSystem.newFrame();
+    m_statistics = PhysicsStatistics{};
+
+    m_aabbData.tree.optimize(m_treeOptimizationBudget);
+    m_triggers.tree.optimize(m_treeOptimizationBudget);
 }
 
 ColliderTag PhysicsSystem::addCapsuleCollider(float height,
                                               float radius,
                                               glm::vec3 const & offset) {
-    assert(m_capsules.size() < std::numeric_limits<uint16_t>::max() && "Too many capsule colliders!");
-    uint16_t id = m_capsules.size();
+    ColliderIndex id;
+    if (!m_capsuleFreeList.empty()) {
+        id = m_capsuleFreeList.back();
+        m_capsuleFreeList.pop_back();
+    } else {
+        assert(m_capsules.size() <= ColliderTag::maxIndex && "Too many capsule colliders!");
+        id = m_capsules.size();
+        m_capsules.push_back({});
+        m_aabbData.capsuleIndices.push_back({});
+        m_aabbData.capsuleAABBs.push_back({});
+    }
 
-    m_capsules.push_back({});
-    CapsuleCollider & capsule = m_capsules.back();
+    CapsuleCollider & capsule = m_capsules[id];
     capsule.height = height;
     capsule.radius = radius;
     capsule.offset = offset;
 
-    m_aabbData.capsuleIndices.push_back({});
+    m_aabbData.capsuleAABBs[id] = capsule.getAABB(glm::mat4{1.0f});
 
-    m_aabbData.capsuleAABBs.push_back(capsule.getAABB(glm::mat4{1.0f}));
-
-    ColliderTag tag = { uint16_t(id), ColliderShape::COLLIDER_SHAPE_CAPSULE, ColliderType::COLLIDER_TYPE_COLLIDE };
+    ColliderTag tag = { id, ColliderShape::COLLIDER_SHAPE_CAPSULE, ColliderType::COLLIDER_TYPE_COLLIDE };
     m_aabbData.tree.insert(&tag, &m_aabbData.capsuleAABBs[id], 1, &m_aabbData.capsuleIndices[id]);
 
     return tag;
 }
 
-ColliderTag PhysicsSystem::addModelCollider(Model const & model, Transform const & transform) {
+void PhysicsSystem::setCollisionMeshSettings(CollisionMeshSettings const & settings) {
+    m_collisionMeshSettings = settings;
+    // cached meshes were built with the old settings
+    m_collisionMeshes = prt::hash_map<ModelID, CollisionMesh>{};
+}
+
+ColliderTag PhysicsSystem::addModelCollider(glm::vec3 const * vertices,
+                                            unsigned int const * meshSizes,
+                                            size_t nMeshes,
+                                            Transform const & transform) {
     ColliderTag tag;
     tag.shape = COLLIDER_SHAPE_MODEL;
-
+    tag.type = COLLIDER_TYPE_COLLIDE;
 
     if (!m_models.freeList.empty()) {
         tag.index = m_models.freeList.back();
         m_models.freeList.pop_back();
     } else {
+        assert(m_models.models.size() <= ColliderTag::maxIndex && "Too many model colliders!");
         tag.index = m_models.models.size();
         m_models.geometries.push_back({});
         m_models.models.push_back({});
     }
-    ModelCollider & col = m_models.models[tag.index];
 
-    col.startIndex = m_models.meshes.size();
-    col.numIndices = model.meshes.size();
+    size_t nVertices = 0;
+    for (size_t mesh = 0; mesh < nMeshes; ++mesh) {
+        nVertices += meshSizes[mesh];
+    }
 
     Geometry & geometry = m_models.geometries[tag.index];
-    geometry.raw.resize(model.indexBuffer.size());
-    geometry.cache.resize(model.indexBuffer.size());
+    geometry.raw.resize(nVertices);
+    geometry.cache.resize(nVertices);
+
+    m_models.models[tag.index].numIndices = 0;
 
     unsigned int i = 0;
+    unsigned int prevMeshIndex = MeshCollider::NULL_INDEX;
 
-    for (Model::Mesh & mesh : model.meshes) {
-        size_t index = mesh.startIndex;
-        size_t endIndex = index + mesh.numIndices;
+    glm::mat4 mat = transform.transformMatrix();
+    for (size_t mesh = 0; mesh < nMeshes; ++mesh) {
+        // meshes simplified away have no bounds and
+        // would put inverted aabbs into the tree
+        if (meshSizes[mesh] == 0) {
+            continue;
+        }
+        ++m_models.models[tag.index].numIndices;
 
-        m_models.meshes.push_back({});
-        MeshCollider & mcol = m_models.meshes.back();
+        unsigned int meshIndex = allocateMeshCollider();
+        assert(meshIndex <= ColliderTag::maxIndex && "Too many mesh colliders!");
+        // link mesh into the model's list
+        if (prevMeshIndex == MeshCollider::NULL_INDEX) {
+            m_models.models[tag.index].startIndex = meshIndex;
+        } else {
+            m_models.meshes[prevMeshIndex].next = meshIndex;
+        }
+        prevMeshIndex = meshIndex;
 
+        unsigned int endIndex = i + meshSizes[mesh];
+
+        MeshCollider & mcol = m_models.meshes[meshIndex];
         mcol.transform = transform;
         mcol.startIndex = i;
-        mcol.numIndices = mesh.numIndices;
+        mcol.numIndices = meshSizes[mesh];
         mcol.modelIndex = tag.index;
 
         glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
         glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
 
-        glm::mat4 mat = transform.transformMatrix();
-        while (index < endIndex) {
-            geometry.raw[i] = model.vertexBuffer[model.indexBuffer[index]].pos;
+        while (i < endIndex) {
+            geometry.raw[i] = vertices[i];
             geometry.cache[i] = mat * glm::vec4(geometry.raw[i], 1.0f);
             min = glm::min(min, geometry.cache[i]);
             max = glm::max(max, geometry.cache[i]);
             ++i;
-            ++index;
         }
-        m_aabbData.meshAABBs.push_back({min, max});
-    }
-    size_t prevSize = m_aabbData.meshIndices.size();
-    size_t numMesh = model.meshes.size();
-    m_aabbData.meshIndices.resize(prevSize + numMesh);
-    prt::vector<ColliderTag> tags;
-    for (size_t i = prevSize; i < prevSize + numMesh; ++i) {
-        assert(i < std::numeric_limits<ColliderIndex>::max() && "Too many mesh colliders!");
-        tags.push_back({ColliderIndex(i), ColliderShape::COLLIDER_SHAPE_MESH, ColliderType::COLLIDER_TYPE_COLLIDE });
-    }
-    m_aabbData.tree.insert(tags.data(), m_aabbData.meshAABBs.data() + prevSize, numMesh, m_aabbData.meshIndices.data() + prevSize);
+        m_aabbData.meshAABBs[meshIndex] = {min, max};
 
+        ColliderTag meshTag = { ColliderIndex(meshIndex), ColliderShape::COLLIDER_SHAPE_MESH, ColliderType::COLLIDER_TYPE_COLLIDE };
+        // meshes are mostly static and get no margin
+        m_aabbData.tree.insert(&meshTag, &m_aabbData.meshAABBs[meshIndex], 1, &m_aabbData.meshIndices[meshIndex], 0.0f);
+    }
 
     return tag;
 }
 
+unsigned int PhysicsSystem::allocateMeshCollider() {
+    unsigned int meshIndex;
+    if (m_models.freeMeshHead != MeshCollider::NULL_INDEX) {
+        meshIndex = m_models.freeMeshHead;
+        m_models.freeMeshHead = m_models.meshes[meshIndex].next;
+        m_models.meshes[meshIndex] = MeshCollider{};
+    } else {
+        meshIndex = m_models.meshes.size();
+        m_models.meshes.push_back({});
+        m_aabbData.meshAABBs.push_back({});
+        m_aabbData.meshIndices.push_back({});
+    }
+    return meshIndex;
+}
+
 void PhysicsSystem::removeCollider(ColliderTag const & tag) {
+    if (tag.type == COLLIDER_TYPE_TRIGGER) {
+        removeTrigger(tag.index);
+        return;
+    }
+
     switch (tag.shape) {
         case COLLIDER_SHAPE_MODEL:
             removeModelCollider(tag.index);
             break;
         case COLLIDER_SHAPE_CAPSULE:
-            assert(false && "Not yet implemeneted!");
+            removeCapsuleCollider(tag.index);
+            break;
+        case COLLIDER_SHAPE_HEIGHTFIELD:
+            removeHeightfieldCollider(tag.index);
             break;
         default:
             assert(false && "This collider shape can not be removed!");
@@ -120,32 +175,331 @@ void PhysicsSystem::removeCollider(ColliderTag const & tag) {
 }
 
 void PhysicsSystem::removeModelCollider(ColliderIndex colliderIndex) {
+    // forget moved meshes of the model, keeping
+    // their bounds to wake characters nearby
+    size_t moved = 0;
+    for (size_t i = 0; i < m_models.movedMeshes.size(); ++i) {
+        if (m_models.meshes[m_models.movedMeshes[i]].modelIndex != colliderIndex) {
+            m_models.movedMeshes[moved] = m_models.movedMeshes[i];
+            m_models.movedAABBs[moved] = m_models.movedAABBs[i];
+            ++moved;
+        } else {
+            m_removedAABBs.push_back(m_models.movedAABBs[i]);
+        }
+    }
+    m_models.movedMeshes.resize(moved);
+    m_models.movedAABBs.resize(moved);
+
+    // release the model's meshes
+    unsigned int meshIndex = m_models.models[colliderIndex].startIndex;
+    while (meshIndex != MeshCollider::NULL_INDEX) {
+        MeshCollider & mesh = m_models.meshes[meshIndex];
+        unsigned int next = mesh.next;
+
+        m_aabbData.tree.remove(&m_aabbData.meshIndices[meshIndex], 1);
+        if (!mesh.hasMoved) {
+            m_removedAABBs.push_back(m_aabbData.meshAABBs[meshIndex]);
+        }
+
+        mesh = MeshCollider{};
+        mesh.next = m_models.freeMeshHead;
+        m_models.freeMeshHead = meshIndex;
+
+        meshIndex = next;
+    }
+
+    m_models.models[colliderIndex] = ModelCollider{};
+    m_models.geometries[colliderIndex] = Geometry{};
     m_models.freeList.push_back(colliderIndex);
+}
 
-    ModelCollider & col = m_models.models[colliderIndex];
-    unsigned int index = col.startIndex;
-    unsigned int numIndices = col.numIndices;
-    unsigned int endIndex = index + numIndices;
+ColliderTag PhysicsSystem::addHeightfieldCollider(float const * heights,
+                                                  unsigned int width,
+                                                  unsigned int depth,
+                                                  float cellSize,
+                                                  glm::vec3 const & origin) {
+    assert(width > 1 && depth > 1 && "Heightfields need at least one cell!");
+    assert(cellSize > 0.0f);
+
+    ColliderIndex index;
+    if (!m_heightfields.freeList.empty()) {
+        index = m_heightfields.freeList.back();
+        m_heightfields.freeList.pop_back();
+    } else {
+        assert(m_heightfields.heightfields.size() <= ColliderTag::maxIndex && "Too many heightfield colliders!");
+        index = m_heightfields.heightfields.size();
+        m_heightfields.heightfields.push_back({});
+        m_aabbData.heightfieldAABBs.push_back({});
+        m_aabbData.heightfieldIndices.push_back({});
+    }
 
-    for (ModelCollider & mc : m_models.models) {
-        if (mc.startIndex > index) {
-            mc.startIndex -= numIndices;
+    size_t nSamples = size_t(width) * depth;
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < nSamples; ++i) {
+        if (!std::isnan(heights[i])) {
+            min = std::min(min, heights[i]);
+            max = std::max(max, heights[i]);
         }
     }
+    if (min > max) {
+        // only holes
+        min = max = 0.0f;
+    }
+
+    // quantize heights to the range between the lowest and highest sample
+    HeightfieldCollider & heightfield = m_heightfields.heightfields[index];
+    heightfield.origin = origin + glm::vec3{0.0f, min, 0.0f};
+    heightfield.cellSize = cellSize;
+    heightfield.heightScale = max > min ? (max - min) / (HeightfieldCollider::HOLE - 1) : 1.0f;
+    heightfield.width = width;
+    heightfield.depth = depth;
+    heightfield.heights.resize(nSamples);
+    for (size_t i = 0; i < nSamples; ++i) {
+        heightfield.heights[i] = std::isnan(heights[i]) ? 
+                                 HeightfieldCollider::HOLE : 
+                                 static_cast<uint16_t>(std::round((heights[i] - min) / heightfield.heightScale));
+    }
+
+    AABB & aabb = m_aabbData.heightfieldAABBs[index];
+    aabb.lowerBound = heightfield.origin;
+    aabb.upperBound = heightfield.origin + glm::vec3{ (width - 1) * cellSize, max - min, (depth - 1) * cellSize };
+
+    ColliderTag tag = { index, COLLIDER_SHAPE_HEIGHTFIELD, COLLIDER_TYPE_COLLIDE };
+    m_aabbData.tree.insert(&tag, &aabb, 1, &m_aabbData.heightfieldIndices[index], 0.0f);
+
+    return tag;
+}
+
+ColliderTag PhysicsSystem::addHeightfieldCollider(glm::vec3 const * vertices,
+                                                  size_t nVertices,
+                                                  float cellSize,
+                                                  Transform const & transform) {
+    assert(nVertices >= 3);
+
+    prt::vector<glm::vec3> transformed;
+    transformed.resize(nVertices);
+    glm::mat4 mat = transform.transformMatrix();
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < nVertices; ++i) {
+        transformed[i] = mat * glm::vec4(vertices[i], 1.0f);
+        min = glm::min(min, transformed[i]);
+        max = glm::max(max, transformed[i]);
+    }
+
+    unsigned int width = static_cast<unsigned int>(std::ceil((max.x - min.x) / cellSize)) + 1;
+    unsigned int depth = static_cast<unsigned int>(std::ceil((max.z - min.z) / cellSize)) + 1;
+    width = std::max(width, 2u);
+    depth = std::max(depth, 2u);
+
+    prt::vector<float> heights;
+    heights.resize(size_t(width) * depth);
+    for (size_t i = 0; i < heights.size(); ++i) {
+        heights[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+
+    // rasterize triangles onto the grid, keeping the highest surface
+    for (size_t i = 0; i + 2 < nVertices; i += 3) {
+        glm::vec3 const & p0 = transformed[i];
+        glm::vec3 const & p1 = transformed[i + 1];
+        glm::vec3 const & p2 = transformed[i + 2];
+        // signed area of the triangle's projection onto the xz-plane
+        float area = (p1.x - p0.x) * (p2.z - p0.z) - (p2.x - p0.x) * (p1.z - p0.z);
+        if (std::abs(area) < std::numeric_limits<float>::epsilon()) {
+            continue;
+        }
+
+        glm::vec3 triMin = glm::min(glm::min(p0, p1), p2);
+        glm::vec3 triMax = glm::max(glm::max(p0, p1), p2);
+        unsigned int x0 = static_cast<unsigned int>(std::ceil((triMin.x - min.x) / cellSize));
+        unsigned int z0 = static_cast<unsigned int>(std::ceil((triMin.z - min.z) / cellSize));
+        unsigned int x1 = std::min(static_cast<unsigned int>((triMax.x - min.x) / cellSize), width - 1);
+        unsigned int z1 = std::min(static_cast<unsigned int>((triMax.z - min.z) / cellSize), depth - 1);
+        for (unsigned int z = z0; z <= z1; ++z) {
+            for (unsigned int x = x0; x <= x1; ++x) {
+                float px = min.x + x * cellSize;
+                float pz = min.z + z * cellSize;
+                // barycentric coordinates in the xz-plane
+                float u = ((p1.x - px) * (p2.z - pz) - (p2.x - px) * (p1.z - pz)) / area;
+                float v = ((p2.x - px) * (p0.z - pz) - (p0.x - px) * (p2.z - pz)) / area;
+                float w = 1.0f - u - v;
+                constexpr float tolerance = -0.0001f;
+                if (u < tolerance || v < tolerance || w < tolerance) {
+                    continue;
+                }
+                float height = u * p0.y + v * p1.y + w * p2.y;
+                float & sample = heights[size_t(z) * width + x];
+                if (std::isnan(sample) || height > sample) {
+                    sample = height;
+                }
+            }
+        }
+    }
+
+    return addHeightfieldCollider(heights.data(), width, depth, cellSize, glm::vec3{min.x, 0.0f, min.z});
+}
+
+void PhysicsSystem::removeHeightfieldCollider(ColliderIndex colliderIndex) {
+    m_aabbData.tree.remove(&m_aabbData.heightfieldIndices[colliderIndex], 1);
+    m_removedAABBs.push_back(m_aabbData.heightfieldAABBs[colliderIndex]);
+    m_heightfields.heightfields[colliderIndex] = HeightfieldCollider{};
+    m_heightfields.freeList.push_back(colliderIndex);
+}
+
+void PhysicsSystem::getHeightfieldPolygons(ColliderIndex heightfieldIndex,
+                                           AABB const & aabb,
+                                           prt::vector<Polygon> & polygons) const {
+    HeightfieldCollider const & heightfield = m_heightfields.heightfields[heightfieldIndex];
+
+    unsigned int minX, minZ, maxX, maxZ;
+    if (!heightfield.getCellRange(aabb, minX, minZ, maxX, maxZ)) {
+        return;
+    }
+
+    for (unsigned int z = minZ; z <= maxZ; ++z) {
+        for (unsigned int x = minX; x <= maxX; ++x) {
+            Polygon first;
+            Polygon second;
+            if (heightfield.getCellTriangles(x, z, first, second)) {
+                polygons.push_back(first);
+                polygons.push_back(second);
+            }
+        }
+    }
+}
+
+ColliderTag PhysicsSystem::addBoxTrigger(glm::vec3 const & halfExtents,
+                                         glm::vec3 const & offset,
+                                         Transform const & transform) {
+    TriggerCollider trigger{};
+    trigger.transform = transform;
+    trigger.offset = offset;
+    trigger.halfExtents = halfExtents;
+    return addTrigger(COLLIDER_SHAPE_BOX, trigger);
+}
+
+ColliderTag PhysicsSystem::addSphereTrigger(float radius,
+                                            glm::vec3 const & offset,
+                                            Transform const & transform) {
+    TriggerCollider trigger{};
+    trigger.transform = transform;
+    trigger.offset = offset;
+    trigger.radius = radius;
+    return addTrigger(COLLIDER_SHAPE_SPHERE, trigger);
+}
+
+ColliderTag PhysicsSystem::addCapsuleTrigger(float height,
+                                             float radius,
+                                             glm::vec3 const & offset,
+                                             Transform const & transform) {
+    TriggerCollider trigger{};
+    trigger.transform = transform;
+    trigger.offset = offset;
+    trigger.radius = radius;
+    trigger.height = height;
+    return addTrigger(COLLIDER_SHAPE_CAPSULE, trigger);
+}
+
+ColliderTag PhysicsSystem::addMeshTrigger(glm::vec3 const * vertices,
+                                          size_t nVertices,
+                                          Transform const & transform) {
+    TriggerCollider trigger{};
+    trigger.transform = transform;
+    trigger.raw.resize(nVertices);
+    for (size_t i = 0; i < nVertices; ++i) {
+        trigger.raw[i] = vertices[i];
+    }
+    return addTrigger(COLLIDER_SHAPE_MESH, trigger);
+}
+
+ColliderTag PhysicsSystem::addTrigger(ColliderShape shape, TriggerCollider const & trigger) {
+    ColliderIndex index;
+    if (!m_triggers.freeList.empty()) {
+        index = m_triggers.freeList.back();
+        m_triggers.freeList.pop_back();
+    } else {
+        assert(m_triggers.triggers.size() <= ColliderTag::maxIndex && "Too many trigger colliders!");
+        index = m_triggers.triggers.size();
+        m_triggers.triggers.push_back({});
+        m_triggers.aabbs.push_back({});
+        m_triggers.treeIndices.push_back({});
+    }
+    m_triggers.triggers[index] = trigger;
 
-    m_aabbData.tree.remove(&m_aabbData.meshIndices[index], numIndices);
+    ColliderTag tag = { index, shape, COLLIDER_TYPE_TRIGGER };
+    updateTriggerGeometry(tag);
+    m_triggers.tree.insert(&tag, &m_triggers.aabbs[index], 1, &m_triggers.treeIndices[index]);
 
-    if (endIndex < m_aabbData.meshIndices.size()) {
-        m_aabbData.tree.update(&m_aabbData.meshIndices[endIndex], 
-                               &m_aabbData.meshAABBs[endIndex], m_aabbData.meshIndices.size() - endIndex);
+    return tag;
+}
+
+void PhysicsSystem::updateTriggerGeometry(ColliderTag const & tag) {
+    TriggerCollider & trigger = m_triggers.triggers[tag.index];
+    AABB & aabb = m_triggers.aabbs[tag.index];
+
+    glm::mat4 tform = glm::translate(glm::mat4(1.0f), trigger.transform.position) * 
+                      glm::toMat4(glm::normalize(trigger.transform.rotation));
+    switch (tag.shape) {
+        case COLLIDER_SHAPE_BOX: {
+            glm::vec3 center = tform * glm::vec4{trigger.offset, 1.0f};
+            // extent of the rotated box along each axis
+            glm::mat3 rotation = glm::mat3(tform);
+            glm::vec3 extent = glm::abs(rotation[0]) * trigger.halfExtents.x +
+                               glm::abs(rotation[1]) * trigger.halfExtents.y +
+                               glm::abs(rotation[2]) * trigger.halfExtents.z;
+            aabb = { center - extent, center + extent };
+            break;
+        }
+        case COLLIDER_SHAPE_SPHERE: {
+            glm::vec3 center = tform * glm::vec4{trigger.offset, 1.0f};
+            aabb = { center - trigger.radius, center + trigger.radius };
+            break;
+        }
+        case COLLIDER_SHAPE_CAPSULE: {
+            CapsuleCollider capsule{ trigger.height, trigger.radius, trigger.offset };
+            aabb = capsule.getAABB(tform);
+            break;
+        }
+        case COLLIDER_SHAPE_MESH: {
+            glm::mat4 mat = trigger.transform.transformMatrix();
+            trigger.cache.resize(trigger.raw.size());
+            glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+            glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+            for (size_t i = 0; i < trigger.raw.size(); ++i) {
+                trigger.cache[i] = mat * glm::vec4(trigger.raw[i], 1.0f);
+                min = glm::min(min, trigger.cache[i]);
+                max = glm::max(max, trigger.cache[i]);
+            }
+            aabb = { min, max };
+            break;
+        }
+        default:
+            assert(false && "Invalid trigger shape!");
     }
+}
 
-    m_models.meshes.remove(index, numIndices);
-    m_aabbData.meshAABBs.remove(index, numIndices);
-    m_aabbData.meshIndices.remove(index, numIndices);
+void PhysicsSystem::removeTrigger(ColliderIndex colliderIndex) {
+    m_triggers.tree.remove(&m_triggers.treeIndices[colliderIndex], 1);
+    m_triggers.triggers[colliderIndex] = TriggerCollider{};
+    m_triggers.freeList.push_back(colliderIndex);
+
+    // forget overlaps with the trigger, so that it
+    // does not raise exit events once it is gone
+    size_t kept = 0;
+    for (size_t i = 0; i < m_triggers.overlaps.size(); ++i) {
+        if (m_triggers.overlaps[i].trigger.index != colliderIndex) {
+            m_triggers.overlaps[kept] = m_triggers.overlaps[i];
+            ++kept;
+        }
+    }
+    m_triggers.overlaps.resize(kept);
+}
 
-    col = ModelCollider{};
-    m_models.geometries[index] = Geometry{};
+void PhysicsSystem::removeCapsuleCollider(ColliderIndex colliderIndex) {
+    m_aabbData.tree.remove(&m_aabbData.capsuleIndices[colliderIndex], 1);
+    m_capsules[colliderIndex] = CapsuleCollider{};
+    m_capsuleFreeList.push_back(colliderIndex);
 }
 
 void PhysicsSystem::updateCapsuleCollider(ColliderTag const & tag, 
@@ -158,26 +512,39 @@ void PhysicsSystem::updateCapsuleCollider(ColliderTag const & tag,
     m_capsules[tag.index].offset = offset;
 }
 
+void PhysicsSystem::updateCapsuleColliders(ColliderTag const * tags,
+                                           Transform const * transforms,
+                                           size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        assert(tags[i].shape == COLLIDER_SHAPE_CAPSULE);
+        ColliderIndex index = tags[i].index;
+        glm::mat4 tform = glm::translate(glm::mat4(1.0f), transforms[i].position) * glm::toMat4(glm::normalize(transforms[i].rotation));
+        m_aabbData.capsuleAABBs[index] = m_capsules[index].getAABB(tform);
+        m_aabbData.tree.update(&m_aabbData.capsuleIndices[index], &m_aabbData.capsuleAABBs[index], 1);
+        m_movedCapsules.push_back(index);
+    }
+}
+
 void PhysicsSystem::updateModelColliders(ColliderTag const * tags,
                                          Transform const *transforms,
                                          size_t count) {
-    for (auto & meshCollider : m_models.meshes) {
-        meshCollider.hasMoved = false;
+    // only meshes moved by the previous update need their flag reset
+    for (unsigned int meshIndex : m_models.movedMeshes) {
+        m_models.meshes[meshIndex].hasMoved = false;
     }
+    m_models.movedMeshes.resize(0);
+    m_models.movedAABBs.resize(0);
+
     for (size_t i = 0; i < count; ++i) {
         assert(tags[i].shape == COLLIDER_SHAPE_MODEL);
         ModelCollider const & col = m_models.models[tags[i].index];
         Geometry & geometry = m_models.geometries[tags[i].index];
 
-        size_t startIndex = col.startIndex;
-        size_t currIndex = startIndex;
-        size_t numIndices = col.numIndices;
-        size_t endIndex = currIndex + numIndices;
         glm::mat4 mat = transforms[i].transformMatrix();
 
-        while (currIndex < endIndex) {
+        unsigned int currIndex = col.startIndex;
+        while (currIndex != MeshCollider::NULL_INDEX) {
             MeshCollider & curr = m_models.meshes[currIndex];
-            curr.hasMoved = true;
             curr.transform = transforms[i];
 
             // update geometry cache
@@ -191,230 +558,716 @@ void PhysicsSystem::updateModelColliders(ColliderTag const * tags,
                 max = glm::max(max, geometry.cache[currIndex2]);
                 ++currIndex2;
             }
-            m_aabbData.meshAABBs[currIndex].lowerBound = min;
-            m_aabbData.meshAABBs[currIndex].upperBound = max;
-            ++currIndex;
-        }
+            AABB & meshAABB = m_aabbData.meshAABBs[currIndex];
+            if (!curr.hasMoved) {
+                curr.hasMoved = true;
+                m_models.movedMeshes.push_back(currIndex);
+                m_models.movedAABBs.push_back(meshAABB + AABB{min, max});
+            }
+            glm::vec3 displacement = min - meshAABB.lowerBound;
+            meshAABB.lowerBound = min;
+            meshAABB.upperBound = max;
+
+            m_aabbData.tree.update(&m_aabbData.meshIndices[currIndex], &meshAABB, &displacement, 1);
 
-        m_aabbData.tree.update(&m_aabbData.meshIndices[startIndex], 
-                               &m_aabbData.meshAABBs[startIndex], numIndices);
+            currIndex = curr.next;
+        }
     }
+    m_statistics.treeReinsertions += m_aabbData.tree.getReinsertions();
+    m_aabbData.tree.resetReinsertions();
 }
 
-// From "Realtime Collision Detection" by Christer Ericson
 bool PhysicsSystem::raycast(glm::vec3 const& origin,
                             glm::vec3 const& direction,
                             float maxDistance,
                             glm::vec3 & hit) {
-    prt::vector<ColliderTag> tags; 
-    m_aabbData.tree.queryRaycast(origin, direction, maxDistance, tags);
+    bool intersect = false;
+    float hitDistance = maxDistance;
+    m_aabbData.tree.raycast(origin, direction, maxDistance, 
+                            [&](ColliderTag tag, float distance) {
+        if (tag.type != COLLIDER_TYPE_COLLIDE) {
+            return distance;
+        }
+        if ((tag.shape == COLLIDER_SHAPE_MESH && 
+             raycastMesh(tag.index, origin, direction, distance, false)) ||
+            (tag.shape == COLLIDER_SHAPE_HEIGHTFIELD && 
+             raycastHeightfield(tag.index, origin, direction, distance, false))) {
+            intersect = true;
+            hitDistance = distance;
+        }
+        return distance;
+    });
 
-    float intersectionTime = std::numeric_limits<float>::max();
+    if (intersect) {
+        hit = origin + direction * hitDistance;
+    }
+    return intersect;
+}
+
+bool PhysicsSystem::raycastAny(glm::vec3 const& origin,
+                               glm::vec3 const& direction,
+                               float maxDistance) {
     bool intersect = false;
-    for (auto tag : tags) {
-        if (tag.shape != COLLIDER_SHAPE_MESH) {
-            continue;
+    m_aabbData.tree.raycast(origin, direction, maxDistance, 
+                            [&](ColliderTag tag, float distance) {
+        if (tag.type != COLLIDER_TYPE_COLLIDE) {
+            return distance;
         }
-        MeshCollider & meshCollider = m_models.meshes[tag.index];
-
-        Geometry & geometry = m_models.geometries[meshCollider.modelIndex];
-
-        size_t index = meshCollider.startIndex;
-        for (size_t i = 0; i < meshCollider.numIndices; i+=3) {
-            float t;
-            bool in = physics_util::intersectLineSegmentTriangle(origin, origin + direction * maxDistance,
-                                                                 geometry.cache[index],
-                                                                 geometry.cache[index+1],
-                                                                 geometry.cache[index+2],
-                                                                 t);
-            intersect |= in;
-            if (in) {
-                intersectionTime = std::min(intersectionTime, t);
+        if ((tag.shape == COLLIDER_SHAPE_MESH && 
+             raycastMesh(tag.index, origin, direction, distance, true)) ||
+            (tag.shape == COLLIDER_SHAPE_HEIGHTFIELD && 
+             raycastHeightfield(tag.index, origin, direction, distance, true))) {
+            intersect = true;
+            return 0.0f;
+        }
+        return distance;
+    });
+
+    return intersect;
+}
+
+// From "Realtime Collision Detection" by Christer Ericson
+bool PhysicsSystem::raycastMesh(ColliderIndex meshIndex,
+                                glm::vec3 const& origin,
+                                glm::vec3 const& direction,
+                                float & maxDistance,
+                                bool anyHit) {
+    MeshCollider const & meshCollider = m_models.meshes[meshIndex];
+    Geometry const & geometry = m_models.geometries[meshCollider.modelIndex];
+
+    bool intersect = false;
+    size_t index = meshCollider.startIndex;
+    size_t endIndex = index + meshCollider.numIndices;
+    while (index < endIndex) {
+        float t;
+        ++m_statistics.raycastTriangleTests;
+        if (physics_util::intersectLineSegmentTriangle(origin, origin + direction * maxDistance,
+                                                       geometry.cache[index],
+                                                       geometry.cache[index+1],
+                                                       geometry.cache[index+2],
+                                                       t)) {
+            // clip the segment so that only closer triangles may hit
+            maxDistance *= t;
+            intersect = true;
+            if (anyHit) {
+                return true;
             }
-            
-            index += 3;
         }
+        index += 3;
     }
-    if (intersect) {
-        hit = origin + direction * intersectionTime * maxDistance;
+    return intersect;
+}
+
+// Traverses the cells below the ray with a 2D DDA, see
+// "A Fast Voxel Traversal Algorithm for Ray Tracing" by Amanatides and Woo
+bool PhysicsSystem::raycastHeightfield(ColliderIndex heightfieldIndex,
+                                       glm::vec3 const& origin,
+                                       glm::vec3 const& direction,
+                                       float & maxDistance,
+                                       bool anyHit) {
+    HeightfieldCollider const & heightfield = m_heightfields.heightfields[heightfieldIndex];
+    AABB const & aabb = m_aabbData.heightfieldAABBs[heightfieldIndex];
+
+    // clip the ray to the heightfield's bounds
+    float tEntry;
+    if (!AABB::intersectRay(aabb, origin, direction, maxDistance, tEntry)) {
+        return false;
+    }
+
+    // position in cell units at the point of entry
+    glm::vec3 entry = origin + direction * tEntry;
+    float gridX = (entry.x - heightfield.origin.x) / heightfield.cellSize;
+    float gridZ = (entry.z - heightfield.origin.z) / heightfield.cellSize;
+    int x = std::min(std::max(static_cast<int>(gridX), 0), int(heightfield.width) - 2);
+    int z = std::min(std::max(static_cast<int>(gridZ), 0), int(heightfield.depth) - 2);
+
+    int stepX = direction.x > 0.0f ? 1 : -1;
+    int stepZ = direction.z > 0.0f ? 1 : -1;
+    float const inf = std::numeric_limits<float>::max();
+    // distance along the ray between cell borders
+    float tDeltaX = direction.x != 0.0f ? heightfield.cellSize / std::abs(direction.x) : inf;
+    float tDeltaZ = direction.z != 0.0f ? heightfield.cellSize / std::abs(direction.z) : inf;
+    // distance along the ray to the next cell borders
+    float tMaxX = direction.x != 0.0f ? 
+                  tEntry + (heightfield.origin.x + (x + (stepX > 0)) * heightfield.cellSize - entry.x) / direction.x : inf;
+    float tMaxZ = direction.z != 0.0f ? 
+                  tEntry + (heightfield.origin.z + (z + (stepZ > 0)) * heightfield.cellSize - entry.z) / direction.z : inf;
+
+    float tCell = tEntry;
+    while (x >= 0 && z >= 0 && 
+           x < int(heightfield.width) - 1 && z < int(heightfield.depth) - 1) {
+        float tExit = std::min(std::min(tMaxX, tMaxZ), maxDistance);
+        Polygon first;
+        Polygon second;
+        // skip cells that the ray passes above
+        float lowestY = std::min(origin.y + direction.y * tCell, origin.y + direction.y * tExit);
+        if (heightfield.getCellTriangles(x, z, first, second) &&
+            lowestY <= std::max(std::max(std::max(first.a.y, first.b.y), first.c.y), second.c.y)) {
+            bool intersect = false;
+            for (Polygon const * p : { &first, &second }) {
+                float t;
+                ++m_statistics.raycastTriangleTests;
+                if (physics_util::intersectLineSegmentTriangle(origin, origin + direction * maxDistance,
+                                                               p->a, p->b, p->c, t)) {
+                    maxDistance *= t;
+                    intersect = true;
+                    if (anyHit) {
+                        return true;
+                    }
+                }
+            }
+            // cells are visited front to back, so the first hit is the closest
+            if (intersect) {
+                return true;
+            }
+        }
+
+        // the ray ends within this cell
+        if (tExit >= maxDistance) {
+            break;
+        }
+        tCell = tExit;
+        if (tMaxX < tMaxZ) {
+            x += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            z += stepZ;
+            tMaxZ += tDeltaZ;
+        }
+    }
+    return false;
+}
+
+bool PhysicsSystem::sphereCast(glm::vec3 const& origin,
+                               float radius,
+                               glm::vec3 const& direction,
+                               float maxDistance,
+                               ShapeCastResult & result) {
+    return capsuleCast(origin, origin, radius, direction, maxDistance, result);
+}
+
+bool PhysicsSystem::capsuleCast(glm::vec3 const& a,
+                                glm::vec3 const& b,
+                                float radius,
+                                glm::vec3 const& direction,
+                                float maxDistance,
+                                ShapeCastResult & result) {
+    result.hit = false;
+    AABB aabb = { glm::min(a, b) - radius, glm::max(a, b) + radius };
+    m_aabbData.tree.sweep(aabb, direction, maxDistance, 
+                          [&](ColliderTag tag, float distance) {
+        if (tag.shape == COLLIDER_SHAPE_MESH && tag.type == COLLIDER_TYPE_COLLIDE) {
+            capsuleCastMesh(tag.index, a, b, radius, direction, distance, result);
+        } else if (tag.shape == COLLIDER_SHAPE_HEIGHTFIELD && tag.type == COLLIDER_TYPE_COLLIDE) {
+            capsuleCastHeightfield(tag.index, a, b, radius, direction, distance, result);
+        }
+        return distance;
+    });
+
+    return result.hit;
+}
+
+void PhysicsSystem::sphereCast(SphereCastQuery const * queries,
+                               ShapeCastResult * results,
+                               size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        sphereCast(queries[i].origin, queries[i].radius, 
+                   queries[i].direction, queries[i].maxDistance, 
+                   results[i]);
+    }
+}
+
+void PhysicsSystem::capsuleCast(CapsuleCastQuery const * queries,
+                                ShapeCastResult * results,
+                                size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        capsuleCast(queries[i].a, queries[i].b, queries[i].radius, 
+                    queries[i].direction, queries[i].maxDistance, 
+                    results[i]);
+    }
+}
+
+bool PhysicsSystem::capsuleCastMesh(ColliderIndex meshIndex,
+                                    glm::vec3 const& a,
+                                    glm::vec3 const& b,
+                                    float radius,
+                                    glm::vec3 const& direction,
+                                    float & maxDistance,
+                                    ShapeCastResult & result) const {
+    MeshCollider const & meshCollider = m_models.meshes[meshIndex];
+    Geometry const & geometry = m_models.geometries[meshCollider.modelIndex];
+
+    bool intersect = false;
+    size_t index = meshCollider.startIndex;
+    size_t endIndex = index + meshCollider.numIndices;
+    while (index < endIndex) {
+        glm::vec3 const & p0 = geometry.cache[index];
+        glm::vec3 const & p1 = geometry.cache[index+1];
+        glm::vec3 const & p2 = geometry.cache[index+2];
+        index += 3;
+
+        // reject triangles outside of the swept volume
+        glm::vec3 displacement = direction * maxDistance;
+        AABB swept = { glm::min(a, b) + glm::min(displacement, glm::vec3{0.0f}) - radius,
+                       glm::max(a, b) + glm::max(displacement, glm::vec3{0.0f}) + radius };
+        AABB triangle = { glm::min(glm::min(p0, p1), p2), glm::max(glm::max(p0, p1), p2) };
+        if (!AABB::intersect(swept, triangle)) {
+            continue;
+        }
+
+        float t;
+        glm::vec3 normal;
+        glm::vec3 point;
+        if (physics_util::sweepCapsuleTriangle(a, b, radius, displacement, 
+                                               p0, p1, p2, 
+                                               t, normal, point)) {
+            // clip the sweep so that only closer triangles may hit
+            maxDistance *= t;
+            result.hit = true;
+            result.distance = maxDistance;
+            result.point = point;
+            result.normal = normal;
+            result.tag = { meshIndex, COLLIDER_SHAPE_MESH, COLLIDER_TYPE_COLLIDE };
+            intersect = true;
+        }
     }
     return intersect;
 }
 
+bool PhysicsSystem::capsuleCastHeightfield(ColliderIndex heightfieldIndex,
+                                           glm::vec3 const& a,
+                                           glm::vec3 const& b,
+                                           float radius,
+                                           glm::vec3 const& direction,
+                                           float & maxDistance,
+                                           ShapeCastResult & result) {
+    glm::vec3 displacement = direction * maxDistance;
+    AABB swept = { glm::min(a, b) + glm::min(displacement, glm::vec3{0.0f}) - radius,
+                   glm::max(a, b) + glm::max(displacement, glm::vec3{0.0f}) + radius };
+    prt::vector<Polygon> & polygons = m_heightfields.castPolygons;
+    polygons.resize(0);
+    getHeightfieldPolygons(heightfieldIndex, swept, polygons);
+
+    bool intersect = false;
+    for (Polygon const & p : polygons) {
+        float t;
+        glm::vec3 normal;
+        glm::vec3 point;
+        if (physics_util::sweepCapsuleTriangle(a, b, radius, direction * maxDistance, 
+                                               p.a, p.b, p.c, 
+                                               t, normal, point)) {
+            // clip the sweep so that only closer triangles may hit
+            maxDistance *= t;
+            result.hit = true;
+            result.distance = maxDistance;
+            result.point = point;
+            result.normal = normal;
+            result.tag = { heightfieldIndex, COLLIDER_SHAPE_HEIGHTFIELD, COLLIDER_TYPE_COLLIDE };
+            intersect = true;
+        }
+    }
+    return intersect;
+}
 
 void PhysicsSystem::updateCharacters(float deltaTime,
-                                     Scene & scene,
-                                     Transform * transforms) {
-    // unpack variables
-    CharacterSystem & characterSystem = scene.getCharacterSystem();
-    size_t n = characterSystem.getNumberOfCharacters();
-    // CharacterPhysics * physics = characterSystem.getCharacterPhysics();
-    // CharacterAttributeInfo * attributeInfos = characterSystem.getCharacterAttribueInfos();
+                                     CharacterPhysics * physics,
+                                     Transform * transforms,
+                                     EntityID const * entityIDs,
+                                     size_t n) {
+    prt::hash_map<ColliderIndex, size_t> tagToCharacter;
+    size_t nAsleep = 0;
+    m_aabbData.tree.resetNodesVisited();
+
+    size_t i = 0;    
+    while (i < n) {
+        CharacterPhysics & phys = physics[i];
+        tagToCharacter.insert(phys.colliderTag.index, i);
+
+        // input and impulses wake sleeping characters
+        if (phys.isAsleep && 
+            (glm::length2(phys.movementVector) > sleepThreshold * sleepThreshold ||
+             glm::length2(phys.velocity) > sleepThreshold * sleepThreshold)) {
+            phys.isAsleep = false;
+            phys.idleFrames = 0;
+        }
 
-    // update character AABBs
-    prt::hash_map<uint16_t, size_t> tagToCharacter;
+        // so do transforms set elsewhere, e.g. by scripts, that 
+        // move a sleeping character out of its resting aabb
+        if (phys.isAsleep) {
+            Transform const & transform = transforms[i];
+            glm::mat4 tform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
+            AABB aabb = m_capsules[phys.colliderTag.index].getAABB(tform);
+            if (!m_aabbData.capsuleAABBs[phys.colliderTag.index].contains(aabb)) {
+                phys.isAsleep = false;
+                phys.idleFrames = 0;
+            }
+        }
+        nAsleep += phys.isAsleep;
+        ++i;
+    }
+
+    for (ColliderIndex index : m_movedCapsules) {
+        auto it = tagToCharacter.find(index);
+        if (it != tagToCharacter.end() && physics[it->value()].isAsleep) {
+            physics[it->value()].isAsleep = false;
+            physics[it->value()].idleFrames = 0;
+            --nAsleep;
+        }
+    }
+    m_movedCapsules.resize(0);
+
+    // colliders moving nearby or removed wake sleeping characters
+    if (nAsleep != 0) {
+        auto wakeCharacters = [&](ColliderTag caller, AABB const & aabb) {
+            prt::vector<ColliderIndex> meshColIDs; 
+            prt::vector<ColliderIndex> capsuleColIDs; 
+            prt::vector<ColliderIndex> heightfieldColIDs; 
+            m_aabbData.tree.query(caller, aabb, 
+                                  meshColIDs, capsuleColIDs, heightfieldColIDs, 
+                                  COLLIDER_TYPE_COLLIDE);
+            for (ColliderIndex colID : capsuleColIDs) {
+                auto it = tagToCharacter.find(colID);
+                if (it != tagToCharacter.end()) {
+                    physics[it->value()].isAsleep = false;
+                    physics[it->value()].idleFrames = 0;
+                }
+            }
+        };
+        for (size_t j = 0; j < m_models.movedMeshes.size(); ++j) {
+            ColliderTag meshTag = { ColliderIndex(m_models.movedMeshes[j]), COLLIDER_SHAPE_MESH, COLLIDER_TYPE_COLLIDE };
+            wakeCharacters(meshTag, m_models.movedAABBs[j]);
+        }
+        // removed colliders are no longer in the tree
+        ColliderTag const removedTag = { 0, COLLIDER_SHAPE_NONE, COLLIDER_TYPE_COLLIDE };
+        for (AABB const & aabb : m_removedAABBs) {
+            wakeCharacters(removedTag, aabb);
+        }
+    }
+    m_removedAABBs.resize(0);
+
+    // update AABBs of awake characters
+    prt::vector<size_t> awake;
     prt::vector<glm::vec3> prevVelocities;
-    prevVelocities.resize(n);
+    awake.reserve(n);
+    prevVelocities.reserve(n);
 
-    size_t i = 0;    
+    i = 0;
     while (i < n) {
-        Character & character = characterSystem.getCharacter(i);
+        CharacterPhysics & phys = physics[i];
+        if (phys.isAsleep) {
+            ++i;
+            continue;
+        }
 
-        CapsuleCollider const & capsule = m_capsules[character.physics.colliderTag.index];
-        AABB & eAABB = m_aabbData.capsuleAABBs[character.physics.colliderTag.index];
+        CapsuleCollider const & capsule = m_capsules[phys.colliderTag.index];
+        AABB & eAABB = m_aabbData.capsuleAABBs[phys.colliderTag.index];
 
         Transform & transform = transforms[i];
         glm::mat4 tform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
         eAABB = capsule.getAABB(tform);
 
         float gravityFactor = m_gravity;
-        glm::mat4 velTform = glm::translate(tform, character.physics.velocity + glm::vec3{0.0f, -1.0f, 0.0f} * gravityFactor * deltaTime);
+        glm::mat4 velTform = glm::translate(tform, phys.velocity + glm::vec3{0.0f, -1.0f, 0.0f} * gravityFactor * deltaTime);
         
         eAABB += capsule.getAABB(velTform);
 
-        tagToCharacter.insert(character.physics.colliderTag.index, i);
+        // the character moves by its velocity plus its input
+        glm::vec3 displacement = phys.velocity + glm::vec3{phys.movementVector.x, 0.0f, phys.movementVector.z};
+        m_aabbData.tree.update(&m_aabbData.capsuleIndices[phys.colliderTag.index], &eAABB, &displacement, 1);
 
-        prevVelocities[i] = character.physics.velocity;
+        awake.push_back(i);
+        prevVelocities.push_back(phys.velocity);
 
-        if (character.physics.isGrounded) {
-            character.physics.velocity += (-0.05f * gravityFactor * deltaTime) * character.physics.groundNormal;
+        if (phys.isGrounded) {
+            phys.velocity += (-0.05f * gravityFactor * deltaTime) * phys.groundNormal;
         } 
-        character.physics.velocity.x += character.physics.movementVector.x;
-        character.physics.velocity.z += character.physics.movementVector.z;
+        phys.velocity.x += phys.movementVector.x;
+        phys.velocity.z += phys.movementVector.z;
 
-        character.physics.isGrounded = false;
+        phys.isGrounded = false;
 
         ++i;
     }
-    m_aabbData.tree.update(m_aabbData.capsuleIndices.data(), m_aabbData.capsuleAABBs.data(), m_capsules.size());
     
     // collide
-    i = 0;
-    while (i < n) {
+    for (size_t index : awake) {
         // movement
-        collideCharacterWithWorld(scene, transforms, i, tagToCharacter);
-        ++i;
+        collideCharacterWithWorld(physics, transforms, entityIDs, index, tagToCharacter);
     }
-    i = 0;
-    while (i < n) {
-        Character & character = characterSystem.getCharacter(i);
+
+    for (size_t j = 0; j < awake.size(); ++j) {
+        CharacterPhysics & phys = physics[awake[j]];
 
         float gravityFactor = m_gravity;
 
-        character.physics.velocity = prevVelocities[i];
+        phys.velocity = prevVelocities[j];
         // TODO: formalize friction
         // friction
         float frictionRatio = 1 / (1 + (deltaTime * 10.0f));
-        character.physics.velocity.x = character.physics.velocity.x * frictionRatio;
-        character.physics.velocity.z = character.physics.velocity.z * frictionRatio;
+        phys.velocity.x = phys.velocity.x * frictionRatio;
+        phys.velocity.z = phys.velocity.z * frictionRatio;
         
-        if (character.physics.isGrounded) {
-            character.physics.velocity.y = glm::max(0.0f * gravityFactor * deltaTime, character.physics.velocity.y);
+        if (phys.isGrounded) {
+            phys.velocity.y = glm::max(0.0f * gravityFactor * deltaTime, phys.velocity.y);
         } else {
-            character.physics.velocity.y += -1.0f * gravityFactor * deltaTime;
+            phys.velocity.y += -1.0f * gravityFactor * deltaTime;
         }
-        ++i;
-    }
-}
-
-// void PhysicsSystem::updateTriggers(float deltaTime,
-//                                    ColliderTag const * triggers,
-//                                    Transform * transforms,
-//                                    size_t n) {
-//     // update triggers
-//     for (int i = 0; i < n; ++i) {
-
-//     }
-// }
-
-void PhysicsSystem::collideCharacterWithWorld(Scene & scene,
-                                              Transform * transforms,
-                                              uint32_t characterIndex,
-                                              prt::hash_map<uint16_t, size_t> const & tagToCharacter) {
-    // unpack variables
-    CharacterSystem & characterSystem = scene.getCharacterSystem();
-    Character & character = characterSystem.getCharacter(characterIndex);
-    CharacterPhysics & physics = character.physics;
-
-    ColliderTag const & tag = physics.colliderTag;
-    AABB & eAABB = m_aabbData.capsuleAABBs[tag.index];
-    CapsuleCollider const & capsule = m_capsules[tag.index];
-    Transform & transform = transforms[characterIndex];
 
-    glm::mat4 prevTform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
-
-    static constexpr unsigned int nTimeSteps = 4;
-    unsigned int stepsLeft = nTimeSteps;
-    while (stepsLeft != 0) {
-        --stepsLeft;
-        transform.position += physics.velocity / float(nTimeSteps);
+        // put characters to sleep after resting for a while
+        if (phys.isGrounded &&
+            glm::length2(phys.velocity) <= sleepThreshold * sleepThreshold &&
+            glm::length2(phys.movementVector) <= sleepThreshold * sleepThreshold) {
+            ++phys.idleFrames;
+        } else {
+            phys.idleFrames = 0;
+        }
 
-        glm::mat4 tform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
+        if (phys.idleFrames >= sleepFrames) {
+            phys.isAsleep = true;
+            phys.velocity = glm::vec3{0.0f};
+
+            // shrink the aabb to the resting capsule, which
+            // tells whether the character is moved while asleep
+            ColliderIndex index = phys.colliderTag.index;
+            Transform const & transform = transforms[awake[j]];
+            glm::mat4 tform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
+            m_aabbData.capsuleAABBs[index] = m_capsules[index].getAABB(tform);
+            m_aabbData.tree.update(&m_aabbData.capsuleIndices[index], &m_aabbData.capsuleAABBs[index], 1);
+        }
+    }
 
-        // broad-phase query
-        eAABB = capsule.getAABB(prevTform);
-        eAABB += capsule.getAABB(tform);
+    // sleeping characters keep their contacts, except
+    // those with awake characters which are found anew
+    if (awake.size() < n) {
+        prt::hash_set<EntityID> awakeEntities;
+        for (size_t index : awake) {
+            awakeEntities.insert(entityIDs[index]);
+        }
+        for (size_t j = 0; j < n; ++j) {
+            if (awakeEntities.find(entityIDs[j]) == awakeEntities.end()) {
+                m_collisionSystem.keepCollisions(entityIDs[j], awakeEntities);
+            }
+        }
+    }
 
-        prevTform = tform;
-        
-        CollisionPackage package{};
-        package.tag = tag;
-        package.transform = &transforms[characterIndex];
-        package.character = &character;
+    m_statistics.awakeCharacters += awake.size();
+    m_statistics.asleepCharacters += n - awake.size();
+    m_statistics.treeNodesVisited += m_aabbData.tree.getNodesVisited();
+    m_statistics.treeReinsertions += m_aabbData.tree.getReinsertions();
+    m_aabbData.tree.resetReinsertions();
 
-        prt::vector<uint16_t> meshColIDs; 
-        prt::vector<uint16_t> capsuleColIDs; 
-        m_aabbData.tree.query(tag, eAABB, meshColIDs, capsuleColIDs, COLLIDER_TYPE_COLLIDE);
+    m_collisionSystem.sortCollisions();
 
-        for (uint32_t colID : capsuleColIDs) {
-            size_t otherCharacterIndex = tagToCharacter[colID];
+    updateTriggerOverlaps(physics, transforms, entityIDs, n);
+}
 
-            Character & otherCharacter = characterSystem.getCharacter(otherCharacterIndex);
-            CharacterPhysics & otherPhysics = otherCharacter.physics;
+void PhysicsSystem::updateTriggers(ColliderTag const * triggers,
+                                   Transform const * transforms,
+                                   size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        assert(triggers[i].type == COLLIDER_TYPE_TRIGGER);
+        ColliderIndex index = triggers[i].index;
+        m_triggers.triggers[index].transform = transforms[i];
+        updateTriggerGeometry(triggers[i]);
+        m_triggers.tree.update(&m_triggers.treeIndices[index], &m_triggers.aabbs[index], 1);
+    }
+    m_statistics.treeReinsertions += m_triggers.tree.getReinsertions();
+    m_triggers.tree.resetReinsertions();
+}
 
-            ColliderTag const & otherTag = otherPhysics.colliderTag;
-            CapsuleCollider const & otherCapsule = m_capsules[otherTag.index];
-            Transform & otherTransform = transforms[otherCharacterIndex];
+void PhysicsSystem::updateTriggerOverlaps(CharacterPhysics const * physics,
+                                          Transform const * transforms,
+                                          EntityID const * entityIDs,
+                                          size_t n) {
+    std::swap(m_triggers.overlaps, m_triggers.prevOverlaps);
+    m_triggers.overlaps.resize(0);
+    m_triggers.enterEvents.resize(0);
+    m_triggers.exitEvents.resize(0);
+
+    if (m_triggers.triggers.size() != m_triggers.freeList.size()) {
+        prt::vector<ColliderTag> tags;
+        for (size_t i = 0; i < n; ++i) {
+            CapsuleCollider const & capsule = m_capsules[physics[i].colliderTag.index];
+            glm::mat4 tform = glm::translate(glm::mat4(1.0f), transforms[i].position) * 
+                              glm::toMat4(glm::normalize(transforms[i].rotation));
+            glm::vec3 a = tform * glm::vec4{capsule.offset, 1.0f};
+            glm::vec3 b = tform * glm::vec4{capsule.offset + glm::vec3{0.0f, capsule.height, 0.0f}, 1.0f};
+
+            tags.resize(0);
+            m_triggers.tree.query(ColliderTag{}, capsule.getAABB(tform), tags);
+            for (ColliderTag const & tag : tags) {
+                if (overlapTriggerCapsule(tag, a, b, capsule.radius)) {
+                    m_triggers.overlaps.push_back({ tag, entityIDs[i] });
+                }
+            }
+        }
+        std::sort(m_triggers.overlaps.data(), m_triggers.overlaps.data() + m_triggers.overlaps.size());
+    }
 
-            CollisionPackage packageOther{};
-            packageOther.tag = otherTag;
-            packageOther.transform = &otherTransform;
-            packageOther.character = &otherCharacter;
+    // diff sorted overlaps against the previous update
+    TriggerOverlap const * curr = m_triggers.overlaps.data();
+    TriggerOverlap const * currEnd = curr + m_triggers.overlaps.size();
+    TriggerOverlap const * prev = m_triggers.prevOverlaps.data();
+    TriggerOverlap const * prevEnd = prev + m_triggers.prevOverlaps.size();
+    while (curr != currEnd || prev != prevEnd) {
+        if (prev == prevEnd || (curr != currEnd && *curr < *prev)) {
+            m_triggers.enterEvents.push_back(*curr);
+            ++curr;
+        } else if (curr == currEnd || *prev < *curr) {
+            m_triggers.exitEvents.push_back(*prev);
+            ++prev;
+        } else {
+            ++curr;
+            ++prev;
+        }
+    }
+}
 
-            m_collisionSystem.collideCapsuleCapsule(scene,
-                                                    package,
-                                                    capsule,
-                                                    packageOther,
-                                                    otherCapsule);
+bool PhysicsSystem::overlapTriggerCapsule(ColliderTag const & tag,
+                                          glm::vec3 const & a,
+                                          glm::vec3 const & b,
+                                          float radius) const {
+    TriggerCollider const & trigger = m_triggers.triggers[tag.index];
+    glm::mat4 tform = glm::translate(glm::mat4(1.0f), trigger.transform.position) * 
+                      glm::toMat4(glm::normalize(trigger.transform.rotation));
+    switch (tag.shape) {
+        case COLLIDER_SHAPE_BOX: {
+            // move the capsule into the box's frame
+            glm::mat4 inv = glm::inverse(tform * glm::translate(glm::mat4(1.0f), trigger.offset));
+            glm::vec3 localA = inv * glm::vec4{a, 1.0f};
+            glm::vec3 localB = inv * glm::vec4{b, 1.0f};
+            return physics_util::squaredDistanceLineSegmentBox(localA, localB, trigger.halfExtents) <= radius * radius;
         }
-        
-        if (meshColIDs.empty()) {
-            break;
+        case COLLIDER_SHAPE_SPHERE: {
+            glm::vec3 center = tform * glm::vec4{trigger.offset, 1.0f};
+            float r = radius + trigger.radius;
+            return glm::distance2(physics_util::closestPointOnLineSegment(a, b, center), center) <= r * r;
         }
+        case COLLIDER_SHAPE_CAPSULE: {
+            glm::vec3 triggerA = tform * glm::vec4{trigger.offset, 1.0f};
+            glm::vec3 triggerB = tform * glm::vec4{trigger.offset + glm::vec3{0.0f, trigger.height, 0.0f}, 1.0f};
+            glm::vec3 c1;
+            glm::vec3 c2;
+            float r = radius + trigger.radius;
+            return physics_util::closestPointsOnLineSegments(a, b, triggerA, triggerB, c1, c2) <= r * r;
+        }
+        case COLLIDER_SHAPE_MESH: {
+            AABB capsuleAABB = { glm::min(a, b) - radius, glm::max(a, b) + radius };
+            for (size_t i = 0; i + 2 < trigger.cache.size(); i += 3) {
+                glm::vec3 const & p0 = trigger.cache[i];
+                glm::vec3 const & p1 = trigger.cache[i + 1];
+                glm::vec3 const & p2 = trigger.cache[i + 2];
+                AABB polygon = { glm::min(glm::min(p0, p1), p2), glm::max(glm::max(p0, p1), p2) };
+                if (!AABB::intersect(capsuleAABB, polygon)) {
+                    continue;
+                }
+                glm::vec3 cSegment;
+                glm::vec3 cTriangle;
+                if (physics_util::closestPointsLineSegmentTriangle(a, b, p0, p1, p2, cSegment, cTriangle) <= radius * radius) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        default:
+            assert(false && "Invalid trigger shape!");
+            return false;
+    }
+}
 
-        // create aggregate mesh collider
-        AggregateMeshCollider aggregateCollider;
-        aggregateCollider.tagOffsets.resize(meshColIDs.size());
-
-        // construct all polygons
-        // count all indices
-        size_t nIndices = 0;
-        for (unsigned int i = 0; i < meshColIDs.size(); ++i) {
-            uint32_t colID = meshColIDs[i];
+bool PhysicsSystem::sweepCapsulePolygons(glm::vec3 const& a,
+                                         glm::vec3 const& b,
+                                         float radius,
+                                         glm::vec3 const& displacement,
+                                         prt::vector<Polygon> const & polygons,
+                                         float & t,
+                                         glm::vec3 & normal,
+                                         glm::vec3 & point) {
+    bool intersect = false;
+    t = 1.0f;
+    for (Polygon const & p : polygons) {
+        // reject polygons outside of the remaining swept volume
+        glm::vec3 clipped = displacement * t;
+        AABB swept = { glm::min(a, b) + glm::min(clipped, glm::vec3{0.0f}) - radius,
+                       glm::max(a, b) + glm::max(clipped, glm::vec3{0.0f}) + radius };
+        AABB polygon = { glm::min(glm::min(p.a, p.b), p.c), glm::max(glm::max(p.a, p.b), p.c) };
+        if (!AABB::intersect(swept, polygon)) {
+            continue;
+        }
+        ++m_statistics.triangleTests;
+
+        float tHit;
+        glm::vec3 hitNormal;
+        glm::vec3 hitPoint;
+        if (physics_util::sweepCapsuleTriangle(a, b, radius, clipped, 
+                                               p.a, p.b, p.c, 
+                                               tHit, hitNormal, hitPoint)) {
+            // clip the sweep so that only closer polygons may hit
+            t *= tHit;
+            normal = hitNormal;
+            point = hitPoint;
+            intersect = true;
+        }
+    }
+    return intersect;
+}
 
-            aggregateCollider.tagOffsets[i].offset = nIndices / 3;
+void PhysicsSystem::collideCharacterWithWorld(CharacterPhysics * physics,
+                                              Transform * transforms,
+                                              EntityID const * entityIDs,
+                                              uint32_t characterIndex,
+                                              prt::hash_map<ColliderIndex, size_t> const & tagToCharacter) {
+    // unpack variables
+    CharacterPhysics & phys = physics[characterIndex];
 
-            aggregateCollider.tagOffsets[i].tag.index = colID;
-            aggregateCollider.tagOffsets[i].tag.type = COLLIDER_TYPE_COLLIDE;
-            aggregateCollider.tagOffsets[i].tag.shape = COLLIDER_SHAPE_MESH;
-            
-            nIndices += m_models.meshes[colID].numIndices;
-        }
-        // fill vector with polygons in ellipsoid space
+    ColliderTag const & tag = phys.colliderTag;
+    CapsuleCollider const & capsule = m_capsules[tag.index];
+    Transform & transform = transforms[characterIndex];
 
+    glm::vec3 const displacement = phys.velocity;
+    float const distance = glm::length(displacement);
+
+    // broad-phase query, once per frame. Sliding never moves the 
+    // capsule farther than the length of its displacement
+    glm::mat4 tform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
+    AABB eAABB = capsule.getAABB(tform);
+    eAABB.lowerBound -= glm::vec3{distance};
+    eAABB.upperBound += glm::vec3{distance};
+
+    prt::vector<ColliderIndex> meshColIDs; 
+    prt::vector<ColliderIndex> capsuleColIDs; 
+    prt::vector<ColliderIndex> heightfieldColIDs; 
+    m_aabbData.tree.query(tag, eAABB, meshColIDs, capsuleColIDs, heightfieldColIDs, COLLIDER_TYPE_COLLIDE);
+    ++m_statistics.characterQueries;
+
+    CollisionPackage package{};
+    package.tag = tag;
+    package.entity = entityIDs[characterIndex];
+    package.transform = &transform;
+    package.physics = &phys;
+
+    // create aggregate mesh collider
+    AggregateMeshCollider aggregateCollider;
+    aggregateCollider.entityID = -1;
+    aggregateCollider.tagOffsets.resize(meshColIDs.size());
+
+    // construct all polygons
+    // count all indices
+    size_t nIndices = 0;
+    for (unsigned int i = 0; i < meshColIDs.size(); ++i) {
+        uint32_t colID = meshColIDs[i];
+
+        aggregateCollider.tagOffsets[i].offset = nIndices / 3;
+
+        aggregateCollider.tagOffsets[i].tag.index = colID;
+        aggregateCollider.tagOffsets[i].tag.type = COLLIDER_TYPE_COLLIDE;
+        aggregateCollider.tagOffsets[i].tag.shape = COLLIDER_SHAPE_MESH;
+        
+        nIndices += m_models.meshes[colID].numIndices;
+    }
 
-        // prt::vector<Polygon> polygons;
-        aggregateCollider.polygons.resize(nIndices / 3);
+    aggregateCollider.polygons.resize(nIndices / 3);
+    if (!aggregateCollider.polygons.empty()) {
         glm::vec3* pCurr = &aggregateCollider.polygons[0].a;
         for (uint32_t colID : meshColIDs) {
             MeshCollider & meshCollider = m_models.meshes[colID];
@@ -427,12 +1280,107 @@ void PhysicsSystem::collideCharacterWithWorld(Scene & scene,
                 ++pCurr;
             }
         }
+    }
+
+    // heightfields only contribute the cells below the capsule
+    for (ColliderIndex colID : heightfieldColIDs) {
+        AggregateMeshCollider::TagOffset tagOffset;
+        tagOffset.tag = { colID, COLLIDER_SHAPE_HEIGHTFIELD, COLLIDER_TYPE_COLLIDE };
+        tagOffset.offset = aggregateCollider.polygons.size();
+        aggregateCollider.tagOffsets.push_back(tagOffset);
+
+        getHeightfieldPolygons(colID, eAABB, aggregateCollider.polygons);
+    }
 
-        m_collisionSystem.collideCapsuleMesh(scene,
-                                             package,
+    // sweep and slide: advance the capsule to its first impact 
+    // and project the remaining displacement onto the contact plane.
+    // One iteration for the impact and one for the slide, while
+    // fast characters get more, as they may slide across more 
+    // surfaces within a single frame
+    unsigned int nIterations = 2 + std::min(static_cast<unsigned int>(distance / capsule.radius), 
+                                            maxSlideIterations - 2);
+    glm::vec3 remaining = displacement;
+    unsigned int iteration = 0;
+    while (iteration < nIterations && glm::length2(remaining) > 0.0f) {
+        ++iteration;
+        ++m_statistics.sweepIterations;
+
+        tform = glm::translate(glm::mat4(1.0f), transform.position) * glm::toMat4(glm::normalize(transform.rotation));
+        glm::vec3 a = tform * glm::vec4{capsule.offset, 1.0f};
+        glm::vec3 b = tform * glm::vec4{capsule.offset + glm::vec3{0.0f, capsule.height, 0.0f}, 1.0f};
+
+        float t;
+        glm::vec3 normal;
+        glm::vec3 point;
+        if (!sweepCapsulePolygons(a, b, capsule.radius, remaining, 
+                                  aggregateCollider.polygons, 
+                                  t, normal, point)) {
+            transform.position += remaining;
+            remaining = glm::vec3{0.0f};
+            break;
+        }
+
+        // stop short of the impact to not start the next sweep in contact
+        float remainingLength = glm::length(remaining);
+        float advance = glm::max(t * remainingLength - contactOffset, 0.0f);
+        transform.position += (advance / remainingLength) * remaining;
+
+        CollisionResult resA{};
+        resA.impulse = glm::vec3{0.0f};
+        resA.collisionNormal = normal;
+        resA.collisionDepth = 0.0f;
+        resA.intersectionPoint = point;
+        resA.other = aggregateCollider.entityID;
+
+        CollisionResult resB{};
+        resB.impulse = glm::vec3{0.0f};
+        resB.collisionNormal = -normal;
+        resB.collisionDepth = 0.0f;
+        resB.intersectionPoint = point;
+        resB.other = package.entity;
+
+        m_collisionSystem.handleCollision(package, resA, resB);
+
+        // slide along the contact plane
+        remaining *= 1.0f - t;
+        remaining -= glm::min(glm::dot(remaining, normal), 0.0f) * normal;
+
+        // remainders within the contact offset are not worth another sweep
+        if (glm::length2(remaining) < contactOffset * contactOffset) {
+            break;
+        }
+    }
+
+    // resolve remaining contacts at the final position
+    for (uint32_t colID : capsuleColIDs) {
+        size_t otherCharacterIndex = tagToCharacter[colID];
+
+        CharacterPhysics & otherPhysics = physics[otherCharacterIndex];
+
+        ColliderTag const & otherTag = otherPhysics.colliderTag;
+        CapsuleCollider const & otherCapsule = m_capsules[otherTag.index];
+        Transform & otherTransform = transforms[otherCharacterIndex];
+
+        CollisionPackage packageOther{};
+        packageOther.tag = otherTag;
+        packageOther.entity = entityIDs[otherCharacterIndex];
+        packageOther.transform = &otherTransform;
+        packageOther.physics = &otherPhysics;
+
+        if (m_collisionSystem.collideCapsuleCapsule(package,
+                                                    capsule,
+                                                    packageOther,
+                                                    otherCapsule) && otherPhysics.isAsleep) {
+            // contacts from awake characters wake sleeping ones
+            otherPhysics.isAsleep = false;
+            otherPhysics.idleFrames = 0;
+        }
+    }
+
+    if (!aggregateCollider.polygons.empty()) {
+        m_statistics.triangleTests += aggregateCollider.polygons.size();
+        m_collisionSystem.collideCapsuleMesh(package,
                                              capsule,
                                              aggregateCollider);
-        
     }
-    transform.position += float(stepsLeft) * physics.velocity / float(nTimeSteps);
 }
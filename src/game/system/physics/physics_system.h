@@ -6,9 +6,9 @@
 #include "src/game/system/physics/aabb_tree.h"
 #include "src/game/system/physics/colliders.h"
 #include "src/game/system/physics/collision_system.h"
-#include "src/graphics/geometry/model.h"
-#include "src/system/assets/model_manager.h"
-#include "src/game/system/character/character.h"
+#include "src/game/system/physics/collision_mesh.h"
+#include "src/game/system/character/character_physics.h"
+#include "src/game/scene/id.h"
 
 #include "src/container/vector.h"
 #include "src/container/hash_map.h"
@@ -19,6 +19,62 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+class Model;
+
+struct ShapeCastResult {
+    bool        hit = false;
+    // distance travelled along the cast direction before impact
+    float       distance;
+    glm::vec3   point;
+    // normal of impact, pointing away from the hit collider
+    glm::vec3   normal;
+    ColliderTag tag;
+};
+
+struct SphereCastQuery {
+    glm::vec3 origin;
+    float     radius;
+    glm::vec3 direction;
+    float     maxDistance;
+};
+
+struct CapsuleCastQuery {
+    // end points of the capsule segment
+    glm::vec3 a;
+    glm::vec3 b;
+    float     radius;
+    glm::vec3 direction;
+    float     maxDistance;
+};
+
+struct TriggerOverlap {
+    ColliderTag trigger;
+    EntityID    entity;
+    friend bool operator<(TriggerOverlap const & lhs, TriggerOverlap const & rhs) {
+        return lhs.entity < rhs.entity || 
+               (lhs.entity == rhs.entity && lhs.trigger.index < rhs.trigger.index);
+    }
+};
+
+struct PhysicsStatistics {
+    // broad-phase queries issued by character movement
+    uint32_t characterQueries = 0;
+    // sweep-and-slide iterations of character movement
+    uint32_t sweepIterations = 0;
+    // narrow-phase triangle tests of character movement
+    uint32_t triangleTests = 0;
+    // aabb tree nodes visited by character movement
+    uint32_t treeNodesVisited = 0;
+    // aabb tree leaves reinserted after leaving their fat aabb
+    uint32_t treeReinsertions = 0;
+    // characters simulated this frame
+    uint32_t awakeCharacters = 0;
+    // characters skipped this frame
+    uint32_t asleepCharacters = 0;
+    // narrow-phase triangle tests of raycasts
+    uint32_t raycastTriangleTests = 0;
+};
+
 class PhysicsSystem {
 public:
     PhysicsSystem();
@@ -33,6 +89,18 @@ public:
     void updateModelColliders(ColliderTag const * tags,
                               Transform const * transforms,
                               size_t count);
+
+    /**
+     * Moves capsule colliders that were placed outside of
+     * the character update, e.g. by the editor, and wakes
+     * their characters in the next character update
+     * @param tags capsule collider tags
+     * @param transforms new transforms of the capsules
+     * @param count number of capsules
+     */
+    void updateCapsuleColliders(ColliderTag const * tags,
+                                Transform const * transforms,
+                                size_t count);
     
     /**
      * Checks hit between ray and active colliders
@@ -47,37 +115,249 @@ public:
                  float maxDistance,
                  glm::vec3 & hit);
 
+    /**
+     * Checks whether ray hits any active collider, 
+     * without searching for the closest hit.
+     * Intended for line-of-sight checks
+     * 
+     * @param origin ray origin
+     * @param direction ray direction
+     * @param maxDistance maximum distance ray may travel from origin
+     * @return true if ray hits a collider,
+     *         false otherwise
+     */
+    bool raycastAny(glm::vec3 const& origin,
+                    glm::vec3 const& direction,
+                    float maxDistance);
+
+    /**
+     * Sweeps a sphere against active mesh colliders
+     * and finds the first impact
+     * 
+     * @param origin sphere center at the start of the sweep
+     * @param radius sphere radius
+     * @param direction normalized sweep direction
+     * @param maxDistance maximum distance sphere may travel from origin
+     * @param result first impact, return by reference
+     * @return true if sphere hits a collider,
+     *         false otherwise
+     */
+    bool sphereCast(glm::vec3 const& origin,
+                    float radius,
+                    glm::vec3 const& direction,
+                    float maxDistance,
+                    ShapeCastResult & result);
+
+    /**
+     * Sweeps a capsule against active mesh colliders
+     * and finds the first impact
+     * 
+     * @param a start of the capsule segment
+     * @param b end of the capsule segment
+     * @param radius capsule radius
+     * @param direction normalized sweep direction
+     * @param maxDistance maximum distance capsule may travel
+     * @param result first impact, return by reference
+     * @return true if capsule hits a collider,
+     *         false otherwise
+     */
+    bool capsuleCast(glm::vec3 const& a,
+                     glm::vec3 const& b,
+                     float radius,
+                     glm::vec3 const& direction,
+                     float maxDistance,
+                     ShapeCastResult & result);
+
+    /**
+     * Performs a batch of sphere casts
+     * 
+     * @param queries base pointer to sphere casts
+     * @param results base pointer to results
+     * @param n number of sphere casts
+     */
+    void sphereCast(SphereCastQuery const * queries,
+                    ShapeCastResult * results,
+                    size_t n);
+
+    /**
+     * Performs a batch of capsule casts
+     * 
+     * @param queries base pointer to capsule casts
+     * @param results base pointer to results
+     * @param n number of capsule casts
+     */
+    void capsuleCast(CapsuleCastQuery const * queries,
+                     ShapeCastResult * results,
+                     size_t n);
+
     /**
      * Updates physics for character entities
      * 
      * @param deltaTime delta time
      * @param physics base pointer to character physics component
      * @param transforms base pointer to character transforms
+     * @param entityIDs base pointer to character entity IDs
      * @param n number of character entities
      */
     void updateCharacters(float deltaTime,
-                          Scene & scene,
-                          Transform * transforms);
+                          CharacterPhysics * physics,
+                          Transform * transforms,
+                          EntityID const * entityIDs,
+                          size_t n);
 
-    void updateTriggers(float deltaTime,
-                        ColliderTag const * triggers,
-                        Transform * transforms,
+    /**
+     * Moves trigger colliders
+     * 
+     * @param triggers base pointer to trigger collider tags
+     * @param transforms base pointer to new trigger transforms
+     * @param n number of triggers
+     */
+    void updateTriggers(ColliderTag const * triggers,
+                        Transform const * transforms,
                         size_t n);
 
+    /**
+     * @return overlaps between triggers and characters, 
+     *         sorted by entity and trigger
+     */
+    prt::vector<TriggerOverlap> const & getTriggerOverlaps() const { return m_triggers.overlaps; }
+    /**
+     * @return overlaps that began with the last character update
+     */
+    prt::vector<TriggerOverlap> const & getTriggerEnterEvents() const { return m_triggers.enterEvents; }
+    /**
+     * @return overlaps that ended with the last character update
+     */
+    prt::vector<TriggerOverlap> const & getTriggerExitEvents() const { return m_triggers.exitEvents; }
+
     ColliderTag addCapsuleCollider(float height,
                                    float radius,
                                    glm::vec3 const & offset);
                                    
-    ColliderTag addModelCollider(Model const & model, Transform const & transform);
+    /**
+     * Adds a model collider from a simplified version of the 
+     * model's render geometry, which is built once per model
+     * 
+     * @param modelID id of the model
+     * @param model model
+     * @param transform model transform
+     * @return tag of the model collider
+     */
+    ColliderTag addModelCollider(ModelID modelID, Model const & model, Transform const & transform);
+
+    /**
+     * Sets how collision meshes of models are built,
+     * and discards collision meshes built so far
+     */
+    void setCollisionMeshSettings(CollisionMeshSettings const & settings);
+
+    /**
+     * Adds a model collider from raw triangle data
+     * 
+     * @param vertices base pointer to triangle vertices,
+     *                 three consecutive vertices per triangle
+     * @param meshSizes base pointer to number of vertices per mesh
+     * @param nMeshes number of meshes
+     * @param transform model transform
+     * @return tag of the model collider
+     */
+    ColliderTag addModelCollider(glm::vec3 const * vertices,
+                                 unsigned int const * meshSizes,
+                                 size_t nMeshes,
+                                 Transform const & transform);
+
+    /**
+     * Adds a heightfield collider from a grid of heights
+     * 
+     * @param heights base pointer to width * depth heights, row by 
+     *                row along x, NaN marks samples without ground
+     * @param width number of samples along x
+     * @param depth number of samples along z
+     * @param cellSize distance between neighbouring samples
+     * @param origin position of the first sample at height zero
+     * @return tag of the heightfield collider
+     */
+    ColliderTag addHeightfieldCollider(float const * heights,
+                                       unsigned int width,
+                                       unsigned int depth,
+                                       float cellSize,
+                                       glm::vec3 const & origin);
+
+    /**
+     * Bakes a heightfield collider from raw triangle data by sampling
+     * the highest surface above each grid point. Points not covered
+     * by any triangle are left without ground
+     * 
+     * @param vertices base pointer to triangle vertices,
+     *                 three consecutive vertices per triangle
+     * @param nVertices number of vertices
+     * @param cellSize distance between neighbouring samples
+     * @param transform transform applied to the vertices
+     * @return tag of the heightfield collider
+     */
+    ColliderTag addHeightfieldCollider(glm::vec3 const * vertices,
+                                       size_t nVertices,
+                                       float cellSize,
+                                       Transform const & transform);
+
+    ColliderTag addBoxTrigger(glm::vec3 const & halfExtents,
+                              glm::vec3 const & offset,
+                              Transform const & transform);
+
+    ColliderTag addSphereTrigger(float radius,
+                                 glm::vec3 const & offset,
+                                 Transform const & transform);
+
+    ColliderTag addCapsuleTrigger(float height,
+                                  float radius,
+                                  glm::vec3 const & offset,
+                                  Transform const & transform);
+
+    /**
+     * Adds a mesh trigger from raw triangle data.
+     * Characters overlap mesh triggers when they 
+     * touch their surface
+     * 
+     * @param vertices base pointer to triangle vertices,
+     *                 three consecutive vertices per triangle
+     * @param nVertices number of vertices
+     * @param transform trigger transform
+     * @return tag of the trigger collider
+     */
+    ColliderTag addMeshTrigger(glm::vec3 const * vertices,
+                               size_t nVertices,
+                               Transform const & transform);
 
     void removeCollider(ColliderTag const & tag);
 
-    CapsuleCollider & getCapsuleCollider(ColliderTag tag) { assert(tag.shape == COLLIDER_SHAPE_CAPSULE); return m_capsules[tag.index]; }
+    CapsuleCollider & getCapsuleCollider(ColliderTag tag) { assert(tag.shape == COLLIDER_SHAPE_CAPSULE && 
+                                                                   tag.type == COLLIDER_TYPE_COLLIDE); 
+                                                            return m_capsules[tag.index]; }
 
     float getGravity() const { return m_gravity; }
+
+    PhysicsStatistics const & getStatistics() const { return m_statistics; }
+
+    /**
+     * @return cost of the collider aabb tree,
+     *         see DynamicAABBTree::cost
+     */
+    float getTreeCost() const { return m_aabbData.tree.cost(); }
+
+    /**
+     * Sets how many leaves of the aabb trees are reinserted
+     * each frame to maintain tree quality, see
+     * DynamicAABBTree::optimize. Zero disables reinsertion
+     * @param budget maximum reinsertions per tree and frame
+     */
+    void setTreeOptimizationBudget(unsigned int budget) { m_treeOptimizationBudget = budget; }
+
+    CollisionSystem const & getCollisionSystem() const { return m_collisionSystem; }
         
 private:
     prt::vector<CapsuleCollider> m_capsules;
+    // indices of removed capsule colliders
+    prt::vector<unsigned int> m_capsuleFreeList;
 
     // geometric data for model colliders
     struct Geometry {
@@ -92,18 +372,68 @@ private:
         prt::vector<MeshCollider> meshes;
         prt::vector<Geometry> geometries;
 
+        // indices of removed model colliders
         prt::vector<unsigned int> freeList;
+        // first removed mesh collider, the rest 
+        // are linked through MeshCollider::next
+        unsigned int freeMeshHead = MeshCollider::NULL_INDEX;
+
+        // meshes moved by the last update, along with 
+        // aabbs enclosing their previous and current bounds
+        prt::vector<unsigned int> movedMeshes;
+        prt::vector<AABB> movedAABBs;
     } m_models;
 
+    // aabbs of colliders removed since the last
+    // character update, they wake the characters
+    // that rest on or against them
+    prt::vector<AABB> m_removedAABBs;
+    // capsules moved since the last character update,
+    // they wake the characters they belong to
+    prt::vector<ColliderIndex> m_movedCapsules;
+
+    // collision meshes built from models
+    prt::hash_map<ModelID, CollisionMesh> m_collisionMeshes;
+    CollisionMeshSettings m_collisionMeshSettings;
+
+    struct HeightfieldData {
+        prt::vector<HeightfieldCollider> heightfields;
+        // indices of removed heightfield colliders
+        prt::vector<unsigned int> freeList;
+        // polygons of the cells swept by a shape cast,
+        // kept between casts to reuse their memory
+        prt::vector<Polygon> castPolygons;
+    } m_heightfields;
+
     // dynamic aabb tree data
     struct TreeData {
         prt::vector<AABB> meshAABBs;
         prt::vector<int32_t> meshIndices;
         prt::vector<AABB> capsuleAABBs;
         prt::vector<int32_t> capsuleIndices;
+        prt::vector<AABB> heightfieldAABBs;
+        prt::vector<int32_t> heightfieldIndices;
 
         DynamicAABBTree tree;
     } m_aabbData;
+
+    // trigger colliders, kept in a broad-phase of 
+    // their own to not slow down character movement
+    struct TriggerData {
+        prt::vector<TriggerCollider> triggers;
+        prt::vector<AABB> aabbs;
+        prt::vector<int32_t> treeIndices;
+        // indices of removed triggers
+        prt::vector<unsigned int> freeList;
+
+        DynamicAABBTree tree;
+
+        // sorted overlaps of the current and previous update
+        prt::vector<TriggerOverlap> overlaps;
+        prt::vector<TriggerOverlap> prevOverlaps;
+        prt::vector<TriggerOverlap> enterEvents;
+        prt::vector<TriggerOverlap> exitEvents;
+    } m_triggers;
     
     struct CollisionEvent {
         EntityID entityID;
@@ -121,12 +451,96 @@ private:
 
     float m_gravity = 1.0f;
 
+    PhysicsStatistics m_statistics;
+
+    unsigned int m_treeOptimizationBudget = 0;
+
+    // gap kept between characters and the surfaces they slide along
+    static constexpr float contactOffset = 0.001f;
+    // upper bound on sweep-and-slide iterations per character and frame
+    static constexpr unsigned int maxSlideIterations = 4;
+    // speed below which characters are considered at rest
+    static constexpr float sleepThreshold = 0.001f;
+    // consecutive frames at rest before characters are put to sleep
+    static constexpr uint32_t sleepFrames = 30;
+
     void removeModelCollider(ColliderIndex colliderIndex);
+    void removeCapsuleCollider(ColliderIndex colliderIndex);
+    void removeTrigger(ColliderIndex colliderIndex);
+    void removeHeightfieldCollider(ColliderIndex colliderIndex);
+
+    /**
+     * Appends the triangles of the heightfield cells 
+     * whose xz-extent overlaps aabb
+     */
+    void getHeightfieldPolygons(ColliderIndex heightfieldIndex,
+                                AABB const & aabb,
+                                prt::vector<Polygon> & polygons) const;
+
+    ColliderTag addTrigger(ColliderShape shape, TriggerCollider const & trigger);
+    void updateTriggerGeometry(ColliderTag const & tag);
+
+    /**
+     * Finds overlaps between triggers and characters and
+     * produces enter and exit events by comparing them 
+     * to the overlaps of the previous update
+     */
+    void updateTriggerOverlaps(CharacterPhysics const * physics,
+                               Transform const * transforms,
+                               EntityID const * entityIDs,
+                               size_t n);
+
+    bool overlapTriggerCapsule(ColliderTag const & tag,
+                               glm::vec3 const & a,
+                               glm::vec3 const & b,
+                               float radius) const;
+
+    unsigned int allocateMeshCollider();
+
+    void buildCollisionMesh(Model const & model, CollisionMesh & collisionMesh) const;
+
+    bool raycastMesh(ColliderIndex meshIndex,
+                     glm::vec3 const& origin,
+                     glm::vec3 const& direction,
+                     float & maxDistance,
+                     bool anyHit);
+
+    bool raycastHeightfield(ColliderIndex heightfieldIndex,
+                            glm::vec3 const& origin,
+                            glm::vec3 const& direction,
+                            float & maxDistance,
+                            bool anyHit);
+
+    bool capsuleCastHeightfield(ColliderIndex heightfieldIndex,
+                                glm::vec3 const& a,
+                                glm::vec3 const& b,
+                                float radius,
+                                glm::vec3 const& direction,
+                                float & maxDistance,
+                                ShapeCastResult & result);
+
+    bool capsuleCastMesh(ColliderIndex meshIndex,
+                         glm::vec3 const& a,
+                         glm::vec3 const& b,
+                         float radius,
+                         glm::vec3 const& direction,
+                         float & maxDistance,
+                         ShapeCastResult & result) const;
+
+    bool sweepCapsulePolygons(glm::vec3 const& a,
+                              glm::vec3 const& b,
+                              float radius,
+                              glm::vec3 const& displacement,
+                              prt::vector<Polygon> const & polygons,
+                              float & t,
+                              glm::vec3 & normal,
+                              glm::vec3 & point);
 
-    void collideCharacterWithWorld(Scene & scene,                                 
+    void collideCharacterWithWorld(CharacterPhysics * physics,
                                    Transform * transforms,
+                                   EntityID const * entityIDs,
                                    uint32_t characterIndex,
-                                   prt::hash_map<uint16_t, size_t> const & tagToCharacter);
+                                   prt::hash_map<ColliderIndex, size_t> const & tagToCharacter);
 
     void collisionResponse(glm::vec3 const & intersectionPoint,
                            glm::vec3 const & collisionNormal,
@@ -0,0 +1,41 @@
+#include "physics_system.h"
+
+// kept apart from physics_system.cpp, which then
+// builds without the graphics headers of Model
+#include "src/graphics/geometry/model.h"
+
+ColliderTag PhysicsSystem::addModelCollider(ModelID modelID, Model const & model, Transform const & transform) {
+    auto it = m_collisionMeshes.find(modelID);
+    if (it == m_collisionMeshes.end()) {
+        m_collisionMeshes.insert(modelID, {});
+        it = m_collisionMeshes.find(modelID);
+        buildCollisionMesh(model, it->value());
+    }
+
+    CollisionMesh const & mesh = it->value();
+    return addModelCollider(mesh.vertices.data(), mesh.meshSizes.data(), mesh.meshSizes.size(), transform);
+}
+
+void PhysicsSystem::buildCollisionMesh(Model const & model, CollisionMesh & collisionMesh) const {
+    prt::vector<glm::vec3> vertices;
+    prt::vector<unsigned int> meshSizes;
+    vertices.resize(model.indexBuffer.size());
+    meshSizes.resize(model.meshes.size());
+
+    size_t i = 0;
+    size_t meshIndex = 0;
+    for (Model::Mesh const & mesh : model.meshes) {
+        size_t index = mesh.startIndex;
+        size_t endIndex = index + mesh.numIndices;
+        while (index < endIndex) {
+            vertices[i] = model.vertexBuffer[model.indexBuffer[index]].pos;
+            ++i;
+            ++index;
+        }
+        meshSizes[meshIndex] = mesh.numIndices;
+        ++meshIndex;
+    }
+
+    collision_mesh::build(vertices.data(), meshSizes.data(), meshSizes.size(), 
+                          m_collisionMeshSettings, collisionMesh);
+}
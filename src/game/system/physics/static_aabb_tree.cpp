@@ -0,0 +1,243 @@
+#include "static_aabb_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+void StaticAABBTree::build(ColliderTag const * tags, AABB const * aabbs, size_t n) {
+    m_nodes.resize(0);
+    m_tags.resize(0);
+    if (n == 0) {
+        return;
+    }
+    assert(2 * n - 1 <= Node::leafBit && "StaticAABBTree: too many leaves!");
+
+    AABB bounds = aabbs[0];
+    prt::vector<glm::vec3> centroids;
+    prt::vector<uint32_t> order;
+    centroids.resize(n);
+    order.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        bounds += aabbs[i];
+        centroids[i] = 0.5f * (aabbs[i].lowerBound + aabbs[i].upperBound);
+        order[i] = i;
+    }
+
+    // pick the step so that the largest quantized
+    // value reaches the upper bound of the tree
+    m_lowerBound = bounds.lowerBound;
+    for (int i = 0; i < 3; ++i) {
+        float extent = bounds.upperBound[i] - bounds.lowerBound[i];
+        m_step[i] = std::max(extent / maxQuantized, std::numeric_limits<float>::min());
+        while (dequantize(maxQuantized, i) < bounds.upperBound[i]) {
+            m_step[i] = std::nextafter(m_step[i], std::numeric_limits<float>::max());
+        }
+        m_invStep[i] = 1.0f / m_step[i];
+    }
+
+    m_nodes.reserve(2 * n - 1);
+    m_tags.reserve(n);
+    buildNode(aabbs, centroids.data(), tags, order.data(), 0, n);
+}
+
+void StaticAABBTree::query(ColliderTag caller, AABB const & aabb, prt::vector<ColliderTag> & tags) const {
+    traverse(aabb, [&](ColliderTag tag) {
+        if (caller != tag) {
+            tags.push_back(tag);
+        }
+    });
+}
+
+void StaticAABBTree::query(ColliderTag caller, AABB const & aabb,
+                           prt::vector<ColliderIndex> & meshIndices,
+                           prt::vector<ColliderIndex> & capsuleIndices,
+                           prt::vector<ColliderIndex> & heightfieldIndices,
+                           ColliderType type) const {
+    traverse(aabb, [&](ColliderTag tag) {
+        if (caller != tag && type == tag.type) {
+            switch (tag.shape) {
+                case ColliderShape::COLLIDER_SHAPE_MESH:
+                    meshIndices.push_back(tag.index);
+                    break;
+                case ColliderShape::COLLIDER_SHAPE_CAPSULE:
+                    capsuleIndices.push_back(tag.index);
+                    break;
+                case ColliderShape::COLLIDER_SHAPE_HEIGHTFIELD:
+                    heightfieldIndices.push_back(tag.index);
+                    break;
+                default:
+                    break;
+            }
+        }
+    });
+}
+
+void StaticAABBTree::queryRaycast(glm::vec3 const& origin,
+                                  glm::vec3 const& direction,
+                                  float maxDistance,
+                                  prt::vector<ColliderTag> & tags) const {
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    prt::vector<uint32_t> nodeStack;
+    nodeStack.push_back(0);
+    while (!nodeStack.empty()) {
+        uint32_t index = nodeStack.back();
+        nodeStack.pop_back();
+        Node const & node = m_nodes[index];
+        if (AABB::intersectRay(getAABB(node), origin, direction, maxDistance)) {
+            if (node.isLeaf()) {
+                ColliderTag tag = m_tags[node.leafIndex()];
+                if (tag.type == COLLIDER_TYPE_COLLIDE) {
+                    tags.push_back(tag);
+                }
+            } else {
+                nodeStack.push_back(node.right());
+                nodeStack.push_back(index + 1);
+            }
+        }
+    }
+}
+
+size_t StaticAABBTree::memoryUsage() const {
+    return m_nodes.capacity() * sizeof(Node) + m_tags.capacity() * sizeof(ColliderTag);
+}
+
+uint32_t StaticAABBTree::buildNode(AABB const * aabbs, glm::vec3 const * centroids,
+                                   ColliderTag const * tags,
+                                   uint32_t * order, size_t begin, size_t end) {
+    uint32_t index = m_nodes.size();
+    m_nodes.push_back({});
+
+    AABB bounds = aabbs[order[begin]];
+    for (size_t i = begin + 1; i < end; ++i) {
+        bounds += aabbs[order[i]];
+    }
+
+    if (end - begin == 1) {
+        m_nodes[index].data = Node::leafBit | uint32_t(m_tags.size());
+        m_tags.push_back(tags[order[begin]]);
+    } else {
+        size_t mid = split(aabbs, centroids, order, begin, end);
+        buildNode(aabbs, centroids, tags, order, begin, mid);
+        // recursion may reallocate the nodes, so index again
+        uint32_t right = buildNode(aabbs, centroids, tags, order, mid, end);
+        m_nodes[index].data = right;
+    }
+
+    Node & node = m_nodes[index];
+    for (int i = 0; i < 3; ++i) {
+        node.lowerBound[i] = quantizeLower(bounds.lowerBound[i], i);
+        node.upperBound[i] = quantizeUpper(bounds.upperBound[i], i);
+    }
+    return index;
+}
+
+size_t StaticAABBTree::split(AABB const * aabbs, glm::vec3 const * centroids,
+                             uint32_t * order, size_t begin, size_t end) const {
+    glm::vec3 lower = centroids[order[begin]];
+    glm::vec3 upper = lower;
+    for (size_t i = begin + 1; i < end; ++i) {
+        lower = glm::min(lower, centroids[order[i]]);
+        upper = glm::max(upper, centroids[order[i]]);
+    }
+    glm::vec3 extent = upper - lower;
+    int axis = 0;
+    if (extent[1] > extent[axis]) axis = 1;
+    if (extent[2] > extent[axis]) axis = 2;
+
+    size_t mid = begin + (end - begin) / 2;
+    if (extent[axis] <= 0.0f) {
+        // all centroids coincide, any split will do
+        return mid;
+    }
+
+    // binned surface area heuristic
+    float binScale = numBins / extent[axis];
+    auto binIndex = [&](uint32_t i) {
+        unsigned int bin = static_cast<unsigned int>((centroids[i][axis] - lower[axis]) * binScale);
+        return std::min(bin, numBins - 1);
+    };
+
+    AABB binBounds[numBins];
+    size_t binCounts[numBins] = {};
+    for (size_t i = begin; i < end; ++i) {
+        unsigned int bin = binIndex(order[i]);
+        binBounds[bin] = binCounts[bin] == 0 ? aabbs[order[i]] : binBounds[bin] + aabbs[order[i]];
+        ++binCounts[bin];
+    }
+
+    // cost of the right side of a split after each bin
+    float rightCosts[numBins];
+    AABB rightBounds{};
+    size_t rightCount = 0;
+    for (unsigned int bin = numBins - 1; bin > 0; --bin) {
+        if (binCounts[bin] != 0) {
+            rightBounds = rightCount == 0 ? binBounds[bin] : rightBounds + binBounds[bin];
+            rightCount += binCounts[bin];
+        }
+        rightCosts[bin - 1] = rightCount == 0 ? std::numeric_limits<float>::max() :
+                                                rightBounds.area() * rightCount;
+    }
+
+    unsigned int bestBin = numBins;
+    float bestCost = std::numeric_limits<float>::max();
+    AABB leftBounds{};
+    size_t leftCount = 0;
+    for (unsigned int bin = 0; bin + 1 < numBins; ++bin) {
+        if (binCounts[bin] != 0) {
+            leftBounds = leftCount == 0 ? binBounds[bin] : leftBounds + binBounds[bin];
+            leftCount += binCounts[bin];
+        }
+        if (leftCount == 0 || leftCount == end - begin) {
+            continue;
+        }
+        float cost = leftBounds.area() * leftCount + rightCosts[bin];
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestBin = bin;
+        }
+    }
+
+    if (bestBin != numBins) {
+        uint32_t * pivot = std::partition(order + begin, order + end,
+                                          [&](uint32_t i) { return binIndex(i) <= bestBin; });
+        size_t split = pivot - order;
+        if (split != begin && split != end) {
+            return split;
+        }
+    }
+
+    // fall back to a median split
+    std::nth_element(order + begin, order + mid, order + end,
+                     [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+    return mid;
+}
+
+uint16_t StaticAABBTree::quantizeLower(float x, int axis) const {
+    float t = (x - m_lowerBound[axis]) * m_invStep[axis];
+    if (!(t > 0.0f)) {
+        return 0;
+    }
+    uint32_t q = t < float(maxQuantized) ? static_cast<uint32_t>(t) : maxQuantized;
+    // correct for rounding so that the bound stays conservative
+    while (q > 0 && dequantize(q, axis) > x) {
+        --q;
+    }
+    return q;
+}
+
+uint16_t StaticAABBTree::quantizeUpper(float x, int axis) const {
+    float t = (x - m_lowerBound[axis]) * m_invStep[axis];
+    if (!(t < float(maxQuantized))) {
+        return maxQuantized;
+    }
+    uint32_t q = t > 0.0f ? static_cast<uint32_t>(std::ceil(t)) : 0;
+    // correct for rounding so that the bound stays conservative
+    while (q < maxQuantized && dequantize(q, axis) < x) {
+        ++q;
+    }
+    return q;
+}
@@ -0,0 +1,271 @@
+#ifndef STATIC_AABB_TREE_H
+#define STATIC_AABB_TREE_H
+
+#include "aabb.h"
+#include "src/container/vector.h"
+
+#include "colliders.h"
+
+#include <cstdint>
+
+/**
+ * Bounding volume hierarchy over colliders that never move,
+ * e.g. level geometry. The tree is built once and stored
+ * as compact nodes in depth-first order, with bounds
+ * quantized to 16 bits relative to the bounds of the tree.
+ * Quantized bounds are rounded outwards, so that queries
+ * are conservative and never miss a leaf the full-precision
+ * bounds would have hit
+ */
+class StaticAABBTree {
+public:
+    /**
+     * Builds the tree from aabbs along with their collider tags,
+     * replacing any previous contents of the tree
+     * @param tags address of the start of the range of collider tags
+     * @param aabbs address of the start of the range of aabbs
+     * @param n number of aabbs
+     */
+    void build(ColliderTag const * tags, AABB const * aabbs, size_t n);
+
+    /**
+     * Finds all intersecting nodes for aabb
+     * @param aabb aabb of query object
+     * @param tags vector to store collider tags of nodes
+     */
+    void query(ColliderTag caller, AABB const & aabb, prt::vector<ColliderTag> & tags) const;
+    /**
+     * Finds all intersecting nodes for aabb
+     * @param aabb aabb of query object
+     * @param meshIndices vector to store mesh indices
+     * @param capsuleIndices vector to store capsule indices
+     * @param heightfieldIndices vector to store heightfield indices
+     */
+    void query(ColliderTag caller, AABB const & aabb,
+               prt::vector<ColliderIndex> & meshIndices,
+               prt::vector<ColliderIndex> & capsuleIndices,
+               prt::vector<ColliderIndex> & heightfieldIndices,
+               ColliderType type) const;
+
+    /**
+     * Finds all intersecting nodes for raycast
+     * @param origin origin of the ray
+     * @param direction direction of the ray
+     * @param maxDistance maximum length of the ray
+     * @param tags vector to store collider tags of nodes
+     */
+    void queryRaycast(glm::vec3 const& origin,
+                      glm::vec3 const& direction,
+                      float maxDistance,
+                      prt::vector<ColliderTag> & tags) const;
+
+    /**
+     * Traverses the leaves intersected by a ray in front-to-back order,
+     * with the same callback protocol as DynamicAABBTree::raycast
+     * @param origin origin of the ray
+     * @param direction direction of the ray
+     * @param maxDistance maximum length of the ray
+     * @param callback callback invoked for every intersected leaf
+     */
+    template<typename Callback>
+    void raycast(glm::vec3 const & origin,
+                 glm::vec3 const & direction,
+                 float maxDistance,
+                 Callback && callback) const;
+
+    /**
+     * Traverses the leaves intersected by an aabb swept along a
+     * direction in front-to-back order, with the same callback
+     * protocol as DynamicAABBTree::sweep
+     * @param aabb aabb at the start of the sweep
+     * @param direction direction of the sweep
+     * @param maxDistance maximum length of the sweep
+     * @param callback callback invoked for every intersected leaf
+     */
+    template<typename Callback>
+    void sweep(AABB const & aabb,
+               glm::vec3 const & direction,
+               float maxDistance,
+               Callback && callback) const;
+
+    /**
+     * @return number of leaves in the tree
+     */
+    size_t size() const { return m_tags.size(); }
+
+    /**
+     * @return memory held by nodes and tags in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    struct Node {
+        // bounds in units of the quantization step from
+        // the lower bound of the tree
+        uint16_t lowerBound[3];
+        uint16_t upperBound[3];
+        // leaves: leaf bit and index into tags,
+        // internal nodes: index of the right child,
+        // the left child directly follows its parent
+        uint32_t data;
+
+        static constexpr uint32_t leafBit = uint32_t(1) << 31;
+
+        bool isLeaf() const { return data & leafBit; }
+        uint32_t leafIndex() const { return data & ~leafBit; }
+        uint32_t right() const { return data; }
+    };
+    static_assert(sizeof(Node) == 16, "StaticAABBTree::Node should be 16 bytes!");
+
+    static constexpr uint32_t maxQuantized = 0xFFFF;
+    // number of bins when evaluating split candidates
+    static constexpr unsigned int numBins = 16;
+
+    prt::vector<Node> m_nodes;
+    prt::vector<ColliderTag> m_tags;
+
+    glm::vec3 m_lowerBound;
+    // quantization step per axis and its inverse
+    glm::vec3 m_step;
+    glm::vec3 m_invStep;
+
+    uint32_t buildNode(AABB const * aabbs, glm::vec3 const * centroids,
+                       ColliderTag const * tags,
+                       uint32_t * order, size_t begin, size_t end);
+
+    size_t split(AABB const * aabbs, glm::vec3 const * centroids,
+                 uint32_t * order, size_t begin, size_t end) const;
+
+    float dequantize(uint16_t q, int axis) const { return m_lowerBound[axis] + float(q) * m_step[axis]; }
+    // largest quantized value not above x
+    uint16_t quantizeLower(float x, int axis) const;
+    // smallest quantized value not below x
+    uint16_t quantizeUpper(float x, int axis) const;
+
+    AABB getAABB(Node const & node) const {
+        return AABB{ glm::vec3{ dequantize(node.lowerBound[0], 0),
+                                dequantize(node.lowerBound[1], 1),
+                                dequantize(node.lowerBound[2], 2) },
+                     glm::vec3{ dequantize(node.upperBound[0], 0),
+                                dequantize(node.upperBound[1], 1),
+                                dequantize(node.upperBound[2], 2) } };
+    }
+
+    template<typename Visitor>
+    void traverse(AABB const & aabb, Visitor && visitor) const;
+};
+
+template<typename Callback>
+void StaticAABBTree::raycast(glm::vec3 const & origin,
+                             glm::vec3 const & direction,
+                             float maxDistance,
+                             Callback && callback) const {
+    sweep(AABB{origin, origin}, direction, maxDistance, callback);
+}
+
+template<typename Callback>
+void StaticAABBTree::sweep(AABB const & aabb,
+                           glm::vec3 const & direction,
+                           float maxDistance,
+                           Callback && callback) const {
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    // sweeping an aabb against a node is equivalent to casting
+    // a ray from its center against the node grown by its extent
+    glm::vec3 origin = 0.5f * (aabb.lowerBound + aabb.upperBound);
+    glm::vec3 extent = 0.5f * (aabb.upperBound - aabb.lowerBound);
+
+    float tEntry;
+    AABB rootAABB = getAABB(m_nodes[0]);
+    rootAABB = { rootAABB.lowerBound - extent, rootAABB.upperBound + extent };
+    if (!AABB::intersectRay(rootAABB, origin, direction, maxDistance, tEntry)) {
+        return;
+    }
+
+    struct StackEntry {
+        uint32_t index;
+        float tEntry;
+    };
+
+    prt::vector<StackEntry> nodeStack;
+    nodeStack.push_back({0, tEntry});
+    while (!nodeStack.empty()) {
+        StackEntry entry = nodeStack.back();
+        nodeStack.pop_back();
+        // the sweep may have been clipped since the node was pushed
+        if (entry.tEntry > maxDistance) {
+            continue;
+        }
+
+        Node const & node = m_nodes[entry.index];
+        if (node.isLeaf()) {
+            maxDistance = callback(m_tags[node.leafIndex()], maxDistance);
+            if (maxDistance <= 0.0f) {
+                return;
+            }
+            continue;
+        }
+
+        uint32_t left = entry.index + 1;
+        uint32_t right = node.right();
+        AABB leftAABB = getAABB(m_nodes[left]);
+        AABB rightAABB = getAABB(m_nodes[right]);
+        leftAABB = { leftAABB.lowerBound - extent, leftAABB.upperBound + extent };
+        rightAABB = { rightAABB.lowerBound - extent, rightAABB.upperBound + extent };
+        float tLeft;
+        float tRight;
+        bool hitLeft = AABB::intersectRay(leftAABB, origin, direction, maxDistance, tLeft);
+        bool hitRight = AABB::intersectRay(rightAABB, origin, direction, maxDistance, tRight);
+        // push the farther child first so that the nearer child is visited first
+        if (hitLeft && hitRight) {
+            if (tLeft <= tRight) {
+                nodeStack.push_back({right, tRight});
+                nodeStack.push_back({left, tLeft});
+            } else {
+                nodeStack.push_back({left, tLeft});
+                nodeStack.push_back({right, tRight});
+            }
+        } else if (hitLeft) {
+            nodeStack.push_back({left, tLeft});
+        } else if (hitRight) {
+            nodeStack.push_back({right, tRight});
+        }
+    }
+}
+
+template<typename Visitor>
+void StaticAABBTree::traverse(AABB const & aabb, Visitor && visitor) const {
+    if (m_nodes.empty() || !AABB::intersect(getAABB(m_nodes[0]), aabb)) {
+        return;
+    }
+
+    // compare in quantized space, rounding the query outwards
+    uint16_t lower[3];
+    uint16_t upper[3];
+    for (int i = 0; i < 3; ++i) {
+        lower[i] = quantizeLower(aabb.lowerBound[i], i);
+        upper[i] = quantizeUpper(aabb.upperBound[i], i);
+    }
+
+    prt::vector<uint32_t> nodeStack;
+    nodeStack.push_back(0);
+    while (!nodeStack.empty()) {
+        uint32_t index = nodeStack.back();
+        nodeStack.pop_back();
+        Node const & node = m_nodes[index];
+        if (lower[0] <= node.upperBound[0] && upper[0] >= node.lowerBound[0] &&
+            lower[1] <= node.upperBound[1] && upper[1] >= node.lowerBound[1] &&
+            lower[2] <= node.upperBound[2] && upper[2] >= node.lowerBound[2]) {
+            if (node.isLeaf()) {
+                visitor(m_tags[node.leafIndex()]);
+            } else {
+                nodeStack.push_back(node.right());
+                nodeStack.push_back(index + 1);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef PRT_BONE_TRANSFORM_H
+#define PRT_BONE_TRANSFORM_H
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+/**
+ * Bone transform of the skinning palette. Bone transforms
+ * are affine, so only the upper three rows are stored,
+ * each row in a column. This matches the std140 layout
+ * of a mat3x4 and a vertex is skinned with
+ * vec4(position, 1.0) * transform
+ */
+typedef glm::mat3x4 BoneTransform;
+
+inline BoneTransform toBoneTransform(glm::mat4 const & transform) {
+    return glm::transpose(glm::mat4x3(transform));
+}
+
+inline glm::mat4 toMat4(BoneTransform const & transform) {
+    return glm::mat4(glm::transpose(transform));
+}
+
+#endif
@@ -13,6 +13,8 @@
 
 #include "src/game/system/animation/animation_clip.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
 Model::Model(char const * path)
@@ -213,6 +215,12 @@ bool Model::load(bool loadAnimation, TextureManager & textureManager) {
     }
     // parse animations
     if (loadAnimation) {
+        AnimationTolerance tolerance;
+        prt::vector<float> times;
+        prt::vector<glm::vec3> positions;
+        prt::vector<glm::quat> rotations;
+        prt::vector<glm::vec3> scales;
+
         animations.resize(scene->mNumAnimations);
         for (size_t i = 0; i < scene->mNumAnimations; ++i) {
             aiAnimation const * aiAnim = scene->mAnimations[i];
@@ -241,18 +249,42 @@ bool Model::load(bool loadAnimation, TextureManager & textureManager) {
                 auto nodeIndex = nameToNode.find(aiChannel->mNodeName)->value();
                 mNodes[nodeIndex].channelIndex = j;
 
-                assert(aiChannel->mNumPositionKeys == aiChannel->mNumRotationKeys && 
-                       aiChannel->mNumPositionKeys == aiChannel->mNumScalingKeys && "number of position, rotation and scaling keys need to match");
-                channel.keys.resize(aiChannel->mNumPositionKeys);
-
-                for (size_t k = 0; k < channel.keys.size(); ++k) {
-                    aiVector3D const & aiPos = aiChannel->mPositionKeys[k].mValue;
-                    aiQuaternion const & aiRot = aiChannel->mRotationKeys[k].mValue;
-                    aiVector3D const & aiScale = aiChannel->mScalingKeys[k].mValue;
-                    channel.keys[k].position = { aiPos.x, aiPos.y, aiPos.z };
-                    channel.keys[k].rotation = { aiRot.w, aiRot.x, aiRot.y, aiRot.z };
-                    channel.keys[k].scaling = { aiScale.x, aiScale.y, aiScale.z };
+                assert(aiChannel->mNumPositionKeys > 0 && aiChannel->mNumRotationKeys > 0 &&
+                       aiChannel->mNumScalingKeys > 0 && "every track needs at least one key");
+                // every track has keys of its own
+                times.resize(aiChannel->mNumPositionKeys);
+                positions.resize(aiChannel->mNumPositionKeys);
+                for (size_t k = 0; k < positions.size(); ++k) {
+                    aiVectorKey const & key = aiChannel->mPositionKeys[k];
+                    times[k] = key.mTime;
+                    positions[k] = { key.mValue.x, key.mValue.y, key.mValue.z };
+                }
+                channel.position.compress(times.data(), positions.data(), positions.size(), tolerance.position);
+                anim.lastKeyTime = glm::max(anim.lastKeyTime, times.back());
+
+                times.resize(aiChannel->mNumRotationKeys);
+                rotations.resize(aiChannel->mNumRotationKeys);
+                for (size_t k = 0; k < rotations.size(); ++k) {
+                    aiQuatKey const & key = aiChannel->mRotationKeys[k];
+                    times[k] = key.mTime;
+                    rotations[k] = { key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z };
+                }
+                channel.rotation.compress(times.data(), rotations.data(), rotations.size(), tolerance.rotation);
+                anim.lastKeyTime = glm::max(anim.lastKeyTime, times.back());
+
+                times.resize(aiChannel->mNumScalingKeys);
+                scales.resize(aiChannel->mNumScalingKeys);
+                for (size_t k = 0; k < scales.size(); ++k) {
+                    aiVectorKey const & key = aiChannel->mScalingKeys[k];
+                    times[k] = key.mTime;
+                    scales[k] = { key.mValue.x, key.mValue.y, key.mValue.z };
                 }
+                channel.scaling.compress(times.data(), scales.data(), scales.size(), tolerance.scale);
+                anim.lastKeyTime = glm::max(anim.lastKeyTime, times.back());
+
+                // size of the keys as full floats
+                mUncompressedAnimationSize += (positions.size() + scales.size()) * (sizeof(float) + sizeof(glm::vec3)) +
+                                              rotations.size() * (sizeof(float) + sizeof(glm::quat));
             }
         }
         // set node Indices
@@ -263,10 +295,22 @@ bool Model::load(bool loadAnimation, TextureManager & textureManager) {
             size_t nodeIndex = nameToNode.find(boneName)->value();
             mNodes[nodeIndex].boneIndices.push_back(i);
         }
+
+        flattenSkeleton();
+
+        mSkinnedBounds.reset(bones.size());
+        for (size_t i = 0; i < vertexBoneBuffer.size(); ++i) {
+            BoneData const & bd = vertexBoneBuffer[i];
+            mSkinnedBounds.addVertex(vertexBuffer[i].pos, bd.boneIDs, bd.boneWeights);
+        }
     }
 
     calcTangentSpace();
 
+    // stamps start at 1 so that unresolved clips never match
+    static uint32_t nextStamp = 1;
+    mStamp = nextStamp++;
+
     mLoaded = true;
     return true;
 }
@@ -278,6 +322,36 @@ int Model::getAnimationIndex(char const * name) const {
     return nameToAnimation.find(aiString(name))->value();
 }
 
+int Model::getAnimationIndex(AnimationClip & clip) const {
+    if (clip.m_modelStamp != mStamp) {
+        int animationIndex = getAnimationIndex(clip.m_clipName);
+        clip.m_animationIndex = animationIndex == -1 ? 0 : animationIndex;
+        clip.m_modelStamp = mStamp;
+
+        // key cursors of the previous animation no longer apply,
+        // one per track of every channel
+        size_t numChannels = clip.m_animationIndex < int(animations.size()) ?
+                             animations[clip.m_animationIndex].channels.size() : 0;
+        clip.m_keyCursors.resize(3 * numChannels);
+        for (uint32_t & cursor : clip.m_keyCursors) {
+            cursor = 0;
+        }
+    }
+    return clip.m_animationIndex;
+}
+
+void Model::getAnimationMemoryUsage(size_t & uncompressed, size_t & compressed) const {
+    uncompressed = mUncompressedAnimationSize;
+    compressed = 0;
+    for (Animation const & animation : animations) {
+        for (AnimationNode const & channel : animation.channels) {
+            compressed += channel.position.memoryUsage() +
+                          channel.rotation.memoryUsage() +
+                          channel.scaling.memoryUsage();
+        }
+    }
+}
+
 int Model::getBoneIndex(char const * name) const {
     if (nameToBone.find(aiString(name)) == nameToBone.end()) {
         return -1;
@@ -285,6 +359,27 @@ int Model::getBoneIndex(char const * name) const {
     return nameToBone.find(aiString(name))->value();
 }
 
+int32_t Model::addBoneMask(char const * rootName) {
+    auto it = nameToNode.find(aiString(rootName));
+    if (it == nameToNode.end()) {
+        return -1;
+    }
+    size_t numNodes = mSkeleton.parentIndices.size();
+    int32_t root = mSkeleton.flatIndices[it->value()];
+    int32_t maskIndex = mBoneMasks.size() / std::max(numNodes, size_t(1));
+    mBoneMasks.resize(mBoneMasks.size() + numNodes);
+
+    // parents precede their children, so a node is
+    // in the mask if it is the root or its parent is
+    float * mask = &mBoneMasks[maskIndex * numNodes];
+    for (size_t i = 0; i < numNodes; ++i) {
+        int32_t parentIndex = mSkeleton.parentIndices[i];
+        bool included = int32_t(i) == root || (parentIndex != -1 && mask[parentIndex] > 0.0f);
+        mask[i] = included ? 1.0f : 0.0f;
+    }
+    return maskIndex;
+}
+
 glm::mat4 Model::getBoneTransform(int index) const {
     return glm::inverse(bones[index].offsetMatrix);
 }
@@ -299,195 +394,145 @@ glm::mat4 Model::getBoneTransform(char const * name) const {
     return getBoneTransform(index);
 }
 
-void Model::sampleAnimation(AnimationClip & clip, glm::mat4 * transforms) const {
+void Model::sampleAnimation(AnimationComponent & component,
+                            AnimationPoseBuffers & poses,
+                            BoneTransform * transforms) const {
     assert(mAnimated);
-    int animationIndex = getAnimationIndex(clip.m_clipName);
-    animationIndex = animationIndex == -1 ? 0 : animationIndex;
-
-    auto const & animation = animations[animationIndex];
-
-    struct IndexedTForm {
-        int32_t index;
-        glm::mat4 tform;
-    };
-
-    prt::vector<IndexedTForm> nodeIndices;
-    nodeIndices.push_back({0, glm::mat4(1.0f)});
-    while (!nodeIndices.empty()) {
-        auto index = nodeIndices.back().index;
-        auto parentTForm = nodeIndices.back().tform;
-        nodeIndices.pop_back();
-
-        glm::mat4 tform = mNodes[index].transform;
-        int32_t channelIndex = mNodes[index].channelIndex;
-
-        if (channelIndex != -1) {
-            auto & channel = animation.channels[channelIndex];
-            
-            float duration = animation.duration / animation.ticksPerSecond;
-            float clipTime = clip.m_time / duration;
-
-            // calculate prev and next frame
-            int numFrames = animation.channels[channelIndex].keys.size();
-            float fracFrame = clipTime * numFrames;
-            int prevFrame = static_cast<int>(fracFrame);
-            float frac = fracFrame - prevFrame;
-            int nextFrame = (prevFrame + 1);
-
-            if (clip.m_loop) {
-                prevFrame = prevFrame % numFrames;
-                nextFrame = nextFrame % numFrames;
-            } else {
-                prevFrame = glm::min(prevFrame, numFrames - 1);
-                nextFrame = glm::min(nextFrame, numFrames - 1);
-                clip.m_completed = prevFrame == numFrames - 1;
-            }
-
-            glm::vec3 const & prevPos = channel.keys[prevFrame].position;
-            glm::vec3 const & nextPos = channel.keys[nextFrame].position;
-
-            glm::quat const & prevRot = channel.keys[prevFrame].rotation;
-            glm::quat const & nextRot = channel.keys[nextFrame].rotation;
-
-            glm::vec3 const & prevScale = channel.keys[prevFrame].scaling;
-            glm::vec3 const & nextScale = channel.keys[nextFrame].scaling;
-
-            glm::vec3 pos = glm::lerp(prevPos, nextPos, frac);
-            glm::quat rot = glm::slerp(prevRot, nextRot, frac);
-            glm::vec3 scale = glm::lerp(prevScale, nextScale, frac);
-            tform = glm::translate(pos) * glm::toMat4(rot) * glm::scale(scale);
-        }
-        // pose matrix
-        glm::mat4 poseMatrix = parentTForm * tform;
+    AnimationPose & pose = poses.result;
+    float blendFactor = component.blendFactor;
+    samplePose(blendFactor >= 1.0f ? component.clipB : component.clipA, pose);
+    if (blendFactor > 0.0f && blendFactor < 1.0f) {
+        samplePose(component.clipB, poses.layer);
+        blendPoses(pose, poses.layer, blendFactor, nullptr);
+    }
 
-        for (auto const & boneIndex : mNodes[index].boneIndices) {
-            transforms[boneIndex] = poseMatrix * bones[boneIndex].offsetMatrix;
+    size_t numNodes = mSkeleton.parentIndices.size();
+    for (uint32_t i = 0; i < component.numLayers; ++i) {
+        AnimationLayer & layer = component.layers[i];
+        if (layer.weight <= 0.0f) {
+            // gameplay waits on clips to complete
+            updateCompletion(layer.clip);
+            continue;
         }
-
-        for (auto const & childIndex : mNodes[index].childIndices) {
-            nodeIndices.push_back({childIndex, poseMatrix});
+        assert(layer.maskIndex == -1 || (layer.maskIndex + 1) * numNodes <= mBoneMasks.size());
+        float const * mask = layer.maskIndex == -1 ? nullptr : &mBoneMasks[layer.maskIndex * numNodes];
+
+        samplePose(layer.clip, poses.layer);
+        if (layer.mode == ANIMATION_BLEND_ADDITIVE) {
+            sampleReferencePose(layer.clip, poses.reference);
+            addPose(pose, poses.layer, poses.reference, layer.weight, mask);
+        } else {
+            blendPoses(pose, poses.layer, std::min(layer.weight, 1.0f), mask);
         }
     }
-}
-
-void Model::blendAnimation(AnimationClip & clipA, 
-                           AnimationClip & clipB,
-                           float blendFactor,
-                           glm::mat4 * transforms) const {
-    assert(mAnimated);
-
-    int animationIndexA = getAnimationIndex(clipA.m_clipName);
-    animationIndexA = animationIndexA == -1 ? 0 : animationIndexA;
-    int animationIndexB = getAnimationIndex(clipB.m_clipName);
-    animationIndexB = animationIndexB == -1 ? 0 : animationIndexB;
-
-    auto const & animationA = animations[animationIndexA];
-    auto const & animationB = animations[animationIndexB];
-
-    struct IndexedTForm {
-        int index;
-        glm::mat4 tform;
-    };
-    prt::vector<IndexedTForm> nodeIndices;
-    nodeIndices.push_back({0, glm::mat4(1.0f)});
-    while (!nodeIndices.empty()) {
-        auto index = nodeIndices.back().index;
-        auto parentTForm = nodeIndices.back().tform;
-        nodeIndices.pop_back();
-
-        glm::mat4 tform = mNodes[index].transform;
-        int channelIndex = mNodes[index].channelIndex;
-
-        if (channelIndex != -1) {
-            auto & channelA = animationA.channels[channelIndex];
-            auto & channelB = animationB.channels[channelIndex];
-
-            float durationA = animationA.duration / animationA.ticksPerSecond;
-            float clipTimeA = clipA.m_time / durationA;
-            // float clipTimeA = clipA.m_time * animationA.ticksPerSecond;
-
-            float durationB = animationB.duration / animationB.ticksPerSecond;
-            float clipTimeB = clipB.m_time / durationB;
-            // float clipTimeB = clipB.m_time * animationB.ticksPerSecond;
-
-            // calculate prev and next frame for clip A
-            int numFramesA = animationA.channels[channelIndex].keys.size();
-            float fracFrameA = clipTimeA * numFramesA;
-            int prevFrameA = static_cast<int>(fracFrameA);
-            float fracA = fracFrameA - prevFrameA;
-            int nextFrameA = (prevFrameA + 1);
-
-            if (clipA.m_loop) {
-                prevFrameA = prevFrameA % numFramesA;
-                nextFrameA = nextFrameA % numFramesA;
-            } else {
-                prevFrameA = glm::min(prevFrameA, numFramesA - 1);
-                nextFrameA = glm::min(nextFrameA, numFramesA - 1);
-                clipA.m_completed = prevFrameA == numFramesA - 1;
-            }
 
-            // calculate prev and next frame for clip B
-            int numFramesB = animationB.channels[channelIndex].keys.size();
-            float fracFrameB = clipTimeB * numFramesB;
-            int prevFrameB = static_cast<int>(fracFrameB);
-            float fracB = fracFrameB - prevFrameB;
-            int nextFrameB = (prevFrameB + 1);
-
-            if (clipB.m_loop) {
-                prevFrameB = prevFrameB % numFramesB;
-                nextFrameB = nextFrameB % numFramesB;
-            } else {
-                prevFrameB = glm::min(prevFrameB, numFramesB - 1);
-                nextFrameB = glm::min(nextFrameB, numFramesB - 1);
-                clipB.m_completed = prevFrameB == numFramesB - 1;
-            }
-            
-            // clip A
-            glm::vec3 const & prevPosA = channelA.keys[prevFrameA].position;
-            glm::vec3 const & nextPosA = channelA.keys[nextFrameA].position;
-
-            glm::quat const & prevRotA = channelA.keys[prevFrameA].rotation;
-            glm::quat const & nextRotA = channelA.keys[nextFrameA].rotation;
+    poseToBoneTransforms(pose, transforms);
+}
 
-            glm::vec3 const & prevScaleA = channelA.keys[prevFrameA].scaling;
-            glm::vec3 const & nextScaleA = channelA.keys[nextFrameA].scaling;
+void Model::samplePose(AnimationClip & clip, AnimationPose & pose) const {
+    auto const & animation = animations[getAnimationIndex(clip)];
 
-            glm::vec3 posA = glm::lerp(prevPosA, nextPosA, fracA);
-            glm::quat rotA = glm::slerp(prevRotA, nextRotA, fracA);
-            glm::vec3 scaleA = glm::lerp(prevScaleA, nextScaleA, fracA);
+    size_t numNodes = mSkeleton.parentIndices.size();
+    pose.resize(numNodes);
 
-            // clip B
-            glm::vec3 const & prevPosB = channelB.keys[prevFrameB].position;
-            glm::vec3 const & nextPosB = channelB.keys[nextFrameB].position;
+    // clip time in ticks
+    float time = clip.m_time * animation.ticksPerSecond;
+    if (clip.m_loop && animation.duration > 0.0f) {
+        time = std::fmod(time, animation.duration);
+    }
+    updateCompletion(clip);
+
+    for (size_t i = 0; i < numNodes; ++i) {
+        int32_t channelIndex = mSkeleton.channelIndices[i];
+        if (channelIndex == -1) {
+            // unused, but kept defined for blending
+            pose.positions[i] = glm::vec3{0.0f};
+            pose.rotations[i] = glm::quat{1.0f, 0.0f, 0.0f, 0.0f};
+            pose.scales[i] = glm::vec3{1.0f};
+            continue;
+        }
+        auto const & channel = animation.channels[channelIndex];
+        uint32_t * cursors = &clip.m_keyCursors[3 * channelIndex];
 
-            glm::quat const & prevRotB = channelB.keys[prevFrameB].rotation;
-            glm::quat const & nextRotB = channelB.keys[nextFrameB].rotation;
+        pose.positions[i] = channel.position.sample(time, animation.duration, clip.m_loop, cursors[0]);
+        pose.rotations[i] = channel.rotation.sample(time, animation.duration, clip.m_loop, cursors[1]);
+        pose.scales[i] = channel.scaling.sample(time, animation.duration, clip.m_loop, cursors[2]);
+    }
+}
 
-            glm::vec3 const & prevScaleB = channelB.keys[prevFrameB].scaling;
-            glm::vec3 const & nextScaleB = channelB.keys[nextFrameB].scaling;
+void Model::updateCompletion(AnimationClip & clip) const {
+    if (!clip.m_loop) {
+        auto const & animation = animations[getAnimationIndex(clip)];
+        clip.m_completed = clip.m_time * animation.ticksPerSecond >= animation.lastKeyTime;
+    }
+}
 
-            glm::vec3 posB = glm::lerp(prevPosB, nextPosB, fracB);
-            glm::quat rotB = glm::slerp(prevRotB, nextRotB, fracB);
-            glm::vec3 scaleB = glm::lerp(prevScaleB, nextScaleB, fracB);
+void Model::sampleReferencePose(AnimationClip & clip, AnimationPose & pose) const {
+    auto const & animation = animations[getAnimationIndex(clip)];
+
+    size_t numNodes = mSkeleton.parentIndices.size();
+    pose.resize(numNodes);
+    for (size_t i = 0; i < numNodes; ++i) {
+        int32_t channelIndex = mSkeleton.channelIndices[i];
+        if (channelIndex == -1) {
+            pose.positions[i] = glm::vec3{0.0f};
+            pose.rotations[i] = glm::quat{1.0f, 0.0f, 0.0f, 0.0f};
+            pose.scales[i] = glm::vec3{1.0f};
+            continue;
+        }
+        auto const & channel = animation.channels[channelIndex];
+        pose.positions[i] = channel.position.decodeKey(0);
+        pose.rotations[i] = channel.rotation.decodeKey(0);
+        pose.scales[i] = channel.scaling.decodeKey(0);
+    }
+}
 
-            // blend
-            glm::vec3 pos = glm::lerp(posA, posB, blendFactor);
-            glm::quat rot = glm::slerp(rotA, rotB, blendFactor);
-            glm::vec3 scale = glm::lerp(scaleA, scaleB, blendFactor);
+void Model::poseToBoneTransforms(AnimationPose & pose, BoneTransform * transforms) const {
+    size_t numNodes = mSkeleton.parentIndices.size();
+    pose.transforms.resize(numNodes);
+
+    // parents precede their children, so a single
+    // pass computes the global transform of every node
+    for (size_t i = 0; i < numNodes; ++i) {
+        glm::mat4 local = mSkeleton.channelIndices[i] == -1 ?
+                          mSkeleton.transforms[i] :
+                          glm::translate(pose.positions[i]) * glm::toMat4(pose.rotations[i]) * glm::scale(pose.scales[i]);
+        int32_t parentIndex = mSkeleton.parentIndices[i];
+        pose.transforms[i] = parentIndex == -1 ? local : pose.transforms[parentIndex] * local;
+    }
 
-            tform = glm::translate(pos) * glm::toMat4(rot) * glm::scale(scale);
-        }
-        // pose matrix
-        glm::mat4 poseMatrix = parentTForm * tform;
+    for (size_t i = 0; i < bones.size(); ++i) {
+        transforms[i] = toBoneTransform(pose.transforms[mSkeleton.boneNodes[i]] * bones[i].offsetMatrix);
+    }
+}
 
-        for (auto const & boneIndex : mNodes[index].boneIndices) {
-            transforms[boneIndex] = poseMatrix * bones[boneIndex].offsetMatrix;
+void Model::flattenSkeleton() {
+    size_t numNodes = mNodes.size();
+    mSkeleton.parentIndices.resize(0);
+    mSkeleton.channelIndices.resize(0);
+    mSkeleton.transforms.resize(0);
+    mSkeleton.boneNodes.resize(bones.size());
+
+    // breadth first, so that parents precede their children
+    prt::vector<int32_t> order;
+    prt::vector<int32_t> & nodeToFlat = mSkeleton.flatIndices;
+    order.reserve(numNodes);
+    nodeToFlat.resize(numNodes);
+    order.push_back(0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        Node const & node = mNodes[order[i]];
+        nodeToFlat[order[i]] = i;
+
+        mSkeleton.parentIndices.push_back(node.parentIndex == -1 ? -1 : nodeToFlat[node.parentIndex]);
+        mSkeleton.channelIndices.push_back(node.channelIndex);
+        mSkeleton.transforms.push_back(node.transform);
+        for (int32_t boneIndex : node.boneIndices) {
+            mSkeleton.boneNodes[boneIndex] = i;
         }
-
-        for (auto const & childIndex : mNodes[index].childIndices) {
-            nodeIndices.push_back({childIndex, poseMatrix});
+        for (int32_t childIndex : node.childIndices) {
+            order.push_back(childIndex);
         }
-    }                            
+    }
 }
 
 int32_t Model::getTexture(aiMaterial &aiMat, aiTextureType type, const char * modelPath,
@@ -2,6 +2,7 @@
 #define PRT_MODEL_H
 
 #include "texture.h"
+#include "bone_transform.h"
 
 #include "src/container/vector.h"
 #include "src/container/array.h"
@@ -23,6 +24,9 @@
 #include "src/system/assets/texture_manager.h"
 
 #include "src/game/system/animation/animation_system.h"
+#include "src/game/system/animation/animation_compression.h"
+#include "src/game/system/animation/animation_pose.h"
+#include "src/game/system/animation/skinned_bounds.h"
 
 
 #include <assimp/scene.h>
@@ -56,7 +60,6 @@ public:
     struct Bone;
     struct Animation;
     struct AnimatedVertex;
-    struct AnimationKey;
     struct AnimationNode;
     struct Node;
 
@@ -65,18 +68,61 @@ public:
     bool load(bool loadAnimation, TextureManager & textureManager);
     // TODO: add unload method
 
-    void sampleAnimation(AnimationClip & clip, glm::mat4 * transforms) const;
-    void blendAnimation(AnimationClip & clipA, 
-                        AnimationClip & clipB,
-                        float blendFactor,
-                        glm::mat4 * transforms) const;
+    /**
+     * Samples the clips of an animation and combines them
+     * into bone transforms. Clip A and B are blended, then
+     * the layers are applied in order, all in local space,
+     * followed by a single pass over the hierarchy
+     * @param component clips and layers to sample
+     * @param poses scratch buffers, reused between
+     *              calls to avoid allocations
+     * @param transforms receives a transform per bone
+     */
+    void sampleAnimation(AnimationComponent & component,
+                         AnimationPoseBuffers & poses,
+                         BoneTransform * transforms) const;
+
+    /**
+     * Updates whether a non-looping clip has completed
+     * without sampling it, for clips that are not sampled
+     * every frame
+     * @param clip clip to update
+     */
+    void updateCompletion(AnimationClip & clip) const;
 
     int getAnimationIndex(char const * name) const;
+    /**
+     * Resolves the animation index of a clip, the
+     * name lookup is cached in the clip
+     * @param clip clip to resolve
+     * @return index of the clip's animation, 0 if
+     *         the model has no animation by that name
+     */
+    int getAnimationIndex(AnimationClip & clip) const;
     int getNumBones() const { return bones.size(); }
+    // bounds of the vertices that every bone influences
+    SkinnedBounds const & getSkinnedBounds() const { return mSkinnedBounds; }
+    /**
+     * Adds a mask for animation layers that
+     * affect part of the skeleton
+     * @param rootName name of the node that the mask
+     *                 includes along with its descendants
+     * @return index of the mask, -1 if the model
+     *         has no node by that name
+     */
+    int32_t addBoneMask(char const * rootName);
     int getBoneIndex(char const * name) const;
     glm::mat4 getBoneTransform(int index) const;
     glm::mat4 getBoneTransform(char const * name) const;
 
+    /**
+     * @param uncompressed receives the size of the loaded
+     *                     animation keys as full floats
+     * @param compressed receives the size of the
+     *                   compressed animation tracks
+     */
+    void getAnimationMemoryUsage(size_t & uncompressed, size_t & compressed) const;
+
     inline bool isloaded() const { return mLoaded; }
     inline bool isAnimated() const { return mAnimated; }
 
@@ -85,14 +131,46 @@ public:
 
 private:
     void calcTangentSpace();
+    void flattenSkeleton();
+
+    void samplePose(AnimationClip & clip, AnimationPose & pose) const;
+    /**
+     * Samples the first key of every track of a clip,
+     * the pose that an additive layer is relative to
+     * @param clip clip to sample
+     * @param pose receives the pose
+     */
+    void sampleReferencePose(AnimationClip & clip, AnimationPose & pose) const;
+    void poseToBoneTransforms(AnimationPose & pose, BoneTransform * transforms) const;
     int32_t getTexture(aiMaterial &aiMat, aiTextureType type, const char * modelPath, 
                        TextureManager & textureManager);
 
     prt::vector<Node> mNodes;
+
+    // nodes flattened at load, in an order
+    // where parents precede their children
+    struct Skeleton {
+        prt::vector<int32_t> parentIndices;
+        prt::vector<int32_t> channelIndices;
+        prt::vector<glm::mat4> transforms;
+        // node of every bone
+        prt::vector<int32_t> boneNodes;
+        // flattened index of every node in mNodes
+        prt::vector<int32_t> flatIndices;
+    };
+    Skeleton mSkeleton;
+    // weights of every flattened node, per bone mask
+    prt::vector<float> mBoneMasks;
+    SkinnedBounds mSkinnedBounds;
+
     glm::mat4 mGlobalInverseTransform;
 
     bool mLoaded;
     bool mAnimated;
+    // identifies the model and version of its
+    // animations in clips that cache an index
+    uint32_t mStamp = 0;
+    size_t mUncompressedAnimationSize = 0;
     char mPath[256] = {};
 
     prt::vector<Mesh> meshes;
@@ -160,19 +238,18 @@ struct Model::Mesh {
     char name[256];
 };
 
-struct Model::AnimationKey {
-    glm::vec3 position;
-    glm::quat rotation;
-    glm::vec3 scaling;
-};
-
+// tracks of a node, compressed at load
 struct Model::AnimationNode {
-    prt::vector<AnimationKey> keys;
+    Vec3Track position;
+    RotationTrack rotation;
+    Vec3Track scaling;
 };
 
 struct Model::Animation {
     float duration;
     double ticksPerSecond;
+    // time of the last key of any track
+    float lastKeyTime = 0.0f;
     prt::vector<AnimationNode> channels;
 };
 
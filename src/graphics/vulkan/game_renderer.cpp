@@ -1137,7 +1137,7 @@ void GameRenderer::bindAssets(Model const * models, size_t nModels,
 RenderResult GameRenderer::update(prt::vector<glm::mat4> const & modelMatrices, 
                                   prt::vector<glm::mat4> const & animatedModelMatrices,
                                   prt::vector<glm::mat4> const & colliderModelMatrices,
-                                  prt::vector<glm::mat4> const & bones,
+                                  prt::vector<BoneTransform> const & bones,
                                   prt::vector<glm::vec4> const & billboardPositions,
                                   prt::vector<glm::vec4> const & billboardColors,
                                   Camera & camera,
@@ -1197,7 +1197,7 @@ RenderResult GameRenderer::update(prt::vector<glm::mat4> const & modelMatrices,
 void GameRenderer::updateUBOs(prt::vector<glm::mat4> const & modelMatrices, 
                               prt::vector<glm::mat4> const & animatedModelMatrices,
                               prt::vector<glm::mat4> const & colliderModelMatrices,
-                              prt::vector<glm::mat4> const & bones,
+                              prt::vector<BoneTransform> const & bones,
                               prt::vector<glm::vec4> const & billboardPositions,
                               prt::vector<glm::vec4> const & billboardColors,
                               Camera & camera,
@@ -1314,7 +1314,7 @@ void GameRenderer::updateUBOs(prt::vector<glm::mat4> const & modelMatrices,
         }
         // bones
         assert(bones.size() <= NUMBER_MAX_BONES);
-        memcpy(&animatedStandardUBO.bones.bones[0], bones.data(), sizeof(glm::mat4) * bones.size()); 
+        memcpy(&animatedStandardUBO.bones.bones[0], bones.data(), sizeof(BoneTransform) * bones.size());
         // shadow map ubo
         auto animatedShadowUboData = getUniformBufferData(getPipeline(pipelineIndices.shadowAnimated).uboIndex).uboData.data();
         AnimatedShadowMapUBO & animatedShadowUBO = *reinterpret_cast<AnimatedShadowMapUBO*>(animatedShadowUboData);
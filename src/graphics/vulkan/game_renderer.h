@@ -56,7 +56,7 @@ public:
     RenderResult update(prt::vector<glm::mat4> const & modelMatrices, 
                         prt::vector<glm::mat4> const & animatedModelMatrices,
                         prt::vector<glm::mat4> const & colliderModelMatrices,
-                        prt::vector<glm::mat4> const & bones,
+                        prt::vector<BoneTransform> const & bones,
                         prt::vector<glm::vec4> const & billboardPositions,
                         prt::vector<glm::vec4> const & billboardColors,
                         Camera & camera,
@@ -229,7 +229,7 @@ private:
     void updateUBOs(prt::vector<glm::mat4> const & nonAnimatedModelMatrices, 
                     prt::vector<glm::mat4> const & animatedModelMatrices,
                     prt::vector<glm::mat4> const & colliderModelMatrices,
-                    prt::vector<glm::mat4> const & bones,
+                    prt::vector<BoneTransform> const & bones,
                     prt::vector<glm::vec4> const & billboardPositions,
                     prt::vector<glm::vec4> const & billboardColors,
                     Camera & camera,
@@ -3,6 +3,7 @@
 
 #include "src/config/prototype2Config.h"
 #include "src/graphics/lighting/light.h"
+#include "src/graphics/geometry/bone_transform.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -32,7 +33,7 @@ struct LightUBO {
 };
 
 struct BoneUBO {
-    alignas(16) glm::mat4 bones[NUMBER_MAX_BONES];
+    alignas(16) BoneTransform bones[NUMBER_MAX_BONES];
 };
 
 struct StandardUBO {
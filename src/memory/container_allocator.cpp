@@ -64,7 +64,8 @@ prt::ContainerAllocator::ContainerAllocator(void* memoryPointer, size_t memorySi
                           m_initialPadding(prt::memory_util::calcPadding(reinterpret_cast<uintptr_t>(memoryPointer),
                                                                         m_alignment)),
                           m_numFreeBlocks(m_numBlocks),
-                          m_firstFreeBlockIndex(0) {
+                          m_firstFreeBlockIndex(0),
+                          m_numAllocations(0) {
     assert(m_alignment > 0);
     assert(m_blockSize >= sizeof(size_t));
     assert(m_alignment <= m_blockSize);
@@ -95,6 +96,7 @@ void* prt::ContainerAllocator::allocate(size_t sizeBytes, size_t alignment) {
                     (sizeof(size_t) + sizeBytes + alignment + m_blockSize - 1) / m_blockSize;
     
     uintptr_t blockPointer = reinterpret_cast<uintptr_t>(allocate(blocks));
+    ++m_numAllocations;
     size_t padding = prt::memory_util::calcPadding(reinterpret_cast<uintptr_t>(blockPointer + sizeof(size_t)),
                                                    alignment);
     *reinterpret_cast<size_t*>(blockPointer) = blocks;                                          
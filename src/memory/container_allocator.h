@@ -88,6 +88,11 @@ namespace prt {
 
         inline size_t getFreeMemory() const { return m_numFreeBlocks * m_blockSize; }
 
+        /**
+         * @return number of allocations made since construction
+         */
+        inline size_t getNumberOfAllocations() const { return m_numAllocations; }
+
         /**
          * @return default container allocator
          */
@@ -141,6 +146,8 @@ namespace prt {
         // If this is greater than or equal to
         // m_numBlocks, there are no free blocks
         size_t m_firstFreeBlockIndex;
+        // Number of allocations made, for profiling
+        size_t m_numAllocations;
     };
 }
 
@@ -8,6 +8,10 @@
 
 #include <dirent.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
 #include <string>   
 
 #include <fstream>
@@ -32,28 +36,80 @@ void ModelManager::getBoneOffsets(ModelID const * modelIDs,
 
 void ModelManager::sampleAnimation(ModelID const * modelIDs,
                                               AnimationComponent * animationComponents, 
-                                              prt::vector<glm::mat4> & transforms,
+                                              prt::vector<BoneTransform> & transforms,
                                               size_t n) {
-    size_t numBones = 0;
+    sampleAnimation(modelIDs, animationComponents, nullptr, n, transforms, n);
+}
+
+void ModelManager::sampleAnimation(ModelID const * modelIDs,
+                                   AnimationComponent * animationComponents,
+                                   uint32_t const * indices,
+                                   size_t nIndices,
+                                   prt::vector<BoneTransform> & transforms,
+                                   size_t n) {
+    m_paletteOffsets.resize(n + 1);
+    m_paletteOffsets[0] = 0;
     for (size_t i = 0; i < n; ++i) {
-        numBones += m_loadedModels[modelIDs[i]].bones.size();
+        m_paletteOffsets[i + 1] = m_paletteOffsets[i] + m_loadedModels[modelIDs[i]].bones.size();
     }
-    transforms.resize(numBones);
+    transforms.resize(m_paletteOffsets[n]);
 
-    size_t tIndex = 0;
-    for (size_t i = 0; i < n; ++i) {
+    // resolve the clips and size the buffers up front,
+    // the container allocator is not thread safe
+    size_t maxNodes = 0;
+    for (size_t k = 0; k < nIndices; ++k) {
+        size_t i = indices == nullptr ? k : indices[k];
         auto const & model = m_loadedModels[modelIDs[i]];
-        if (animationComponents[i].blendFactor <= 0.0f) {
-            model.sampleAnimation(animationComponents[i].clipA, &transforms[tIndex]);
-        } else if (animationComponents[i].blendFactor >= 1.0f) {
-            model.sampleAnimation(animationComponents[i].clipB, &transforms[tIndex]);
-        } else {
-            model.blendAnimation(animationComponents[i].clipA, 
-                                 animationComponents[i].clipB, 
-                                 animationComponents[i].blendFactor,
-                                 &transforms[tIndex]);
+        AnimationComponent & component = animationComponents[i];
+        model.getAnimationIndex(component.clipA);
+        model.getAnimationIndex(component.clipB);
+        for (uint32_t j = 0; j < component.numLayers; ++j) {
+            model.getAnimationIndex(component.layers[j].clip);
+        }
+        maxNodes = std::max(maxNodes, model.mSkeleton.parentIndices.size());
+    }
+
+    size_t numChunks = (nIndices + samplingChunkSize - 1) / samplingChunkSize;
+    size_t numThreads = std::max(size_t(1), std::min(m_samplingThreads, numChunks));
+    if (m_poseBuffers.size() < numThreads) {
+        m_poseBuffers.resize(numThreads);
+    }
+    for (AnimationPoseBuffers & poses : m_poseBuffers) {
+        poses.reserve(maxNodes);
+    }
+
+    // every entity writes its own range of the palette,
+    // so the chunks are sampled independently
+    std::atomic<size_t> nextChunk{0};
+    std::function<void(size_t)> sampleChunks = [&](size_t thread) {
+        for (size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+            size_t begin = chunk * samplingChunkSize;
+            size_t end = std::min(begin + samplingChunkSize, nIndices);
+            sampleAnimationRange(modelIDs, animationComponents, indices, transforms.data(),
+                                 begin, end, m_poseBuffers[thread]);
         }
-        tIndex += model.bones.size();
+    };
+
+    m_samplingWorkers.run(sampleChunks, numThreads);
+}
+
+void ModelManager::setSamplingThreads(size_t numThreads) {
+    m_samplingThreads = std::max(size_t(1), std::min(numThreads, maxSamplingThreads));
+    m_samplingWorkers.resize(m_samplingThreads - 1);
+}
+
+void ModelManager::sampleAnimationRange(ModelID const * modelIDs,
+                                        AnimationComponent * animationComponents,
+                                        uint32_t const * indices,
+                                        BoneTransform * transforms,
+                                        size_t begin, size_t end,
+                                        AnimationPoseBuffers & poses) {
+    for (size_t k = begin; k < end; ++k) {
+        size_t i = indices == nullptr ? k : indices[k];
+        auto const & model = m_loadedModels[modelIDs[i]];
+        AnimationComponent & component = animationComponents[i];
+        BoneTransform * palette = &transforms[m_paletteOffsets[i]];
+        model.sampleAnimation(component, poses, palette);
     }
 }
 
@@ -94,3 +150,7 @@ ModelID ModelManager::loadModel(char const * path,
 uint32_t ModelManager::getAnimationIndex(ModelID modelID, char const * name) {
     return m_loadedModels[modelID].getAnimationIndex(name);
 }
+
+int32_t ModelManager::addBoneMask(ModelID modelID, char const * rootName) {
+    return m_loadedModels[modelID].addBoneMask(rootName);
+}
@@ -7,6 +7,7 @@
 #include "src/game/system/animation/animation_system.h"
 
 #include "src/system/assets/texture_manager.h"
+#include "src/system/thread/worker_pool.h"
 
 #include "src/graphics/geometry/model.h"
 #include "src/game/scene/entity.h"
@@ -29,24 +30,84 @@ public:
     //                          prt::vector<uint32_t> const & animationIndices, 
     //                          prt::vector<glm::mat4> & transforms);
 
+    /**
+     * Samples the clips of entities into a bone palette. Entities
+     * are sampled in chunks, spread over the sampling threads
+     * @param modelIDs model of every entity
+     * @param animationComponents clips of every entity
+     * @param transforms receives the bone transforms of
+     *                   every entity, in entity order
+     * @param n number of entities
+     */
     void sampleAnimation(ModelID const * modelIDs,
                          AnimationComponent * animationComponents, 
-                         prt::vector<glm::mat4> & transforms,
+                         prt::vector<BoneTransform> & transforms,
                          size_t n);
+    /**
+     * Samples the clips of a subset of the entities, the
+     * palette ranges of the other entities are left as is
+     * @param modelIDs model of every entity
+     * @param animationComponents clips of every entity
+     * @param indices entities to sample
+     * @param nIndices number of entities to sample
+     * @param transforms receives the bone transforms of
+     *                   every entity, in entity order
+     * @param n number of entities
+     */
+    void sampleAnimation(ModelID const * modelIDs,
+                         AnimationComponent * animationComponents,
+                         uint32_t const * indices,
+                         size_t nIndices,
+                         prt::vector<BoneTransform> & transforms,
+                         size_t n);
+
+    /**
+     * @param numThreads number of threads that sample
+     *                   animations, including the caller
+     */
+    void setSamplingThreads(size_t numThreads);
 
     static bool defAlreadyLoaded;
     ModelID loadModel(char const * path, 
                       bool animated, bool & alreadyLoaded = defAlreadyLoaded);
 
     uint32_t getAnimationIndex(ModelID modelID, char const * name);
+    /**
+     * Adds a mask for animation layers of a model
+     * @param modelID model to add the mask to
+     * @param rootName name of the node that the mask
+     *                 includes along with its descendants
+     * @return index of the mask, -1 if the model
+     *         has no node by that name
+     */
+    int32_t addBoneMask(ModelID modelID, char const * rootName);
 
 private:
+    static constexpr size_t maxSamplingThreads = WorkerPool::maxWorkers + 1;
+    // entities sampled by a thread at a time
+    static constexpr size_t samplingChunkSize = 8;
+
+    void sampleAnimationRange(ModelID const * modelIDs,
+                              AnimationComponent * animationComponents,
+                              uint32_t const * indices,
+                              BoneTransform * transforms,
+                              size_t begin, size_t end,
+                              AnimationPoseBuffers & poses);
+
     TextureManager & m_textureManager;  
 
     prt::hash_map<std::string, ModelID> m_pathToModelID;
     char m_modelDirectory[256];
 
     prt::vector<Model> m_loadedModels;
+
+    size_t m_samplingThreads = 1;
+    // threads that sample besides the caller
+    WorkerPool m_samplingWorkers;
+    // offset of every entity in the bone palette
+    prt::vector<uint32_t> m_paletteOffsets;
+    // scratch buffers of sampleAnimation, one per thread
+    prt::vector<AnimationPoseBuffers> m_poseBuffers;
 };
 
 #endif
\ No newline at end of file
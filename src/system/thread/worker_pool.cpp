@@ -0,0 +1,81 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+WorkerPool::~WorkerPool() {
+    resize(0);
+}
+
+void WorkerPool::resize(size_t numWorkers) {
+    numWorkers = std::min(numWorkers, maxWorkers);
+    if (numWorkers == m_numWorkers) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (size_t i = 0; i < m_numWorkers; ++i) {
+        m_workers[i].join();
+    }
+
+    m_stop = false;
+    m_numWorkers = numWorkers;
+    for (size_t i = 0; i < m_numWorkers; ++i) {
+        m_workers[i] = std::thread(&WorkerPool::work, this, i + 1, m_generation);
+    }
+}
+
+void WorkerPool::run(std::function<void(size_t)> const & job, size_t numThreads) {
+    numThreads = std::max(size_t(1), std::min(numThreads, m_numWorkers + 1));
+    if (numThreads > 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &job;
+            m_numThreads = numThreads;
+            m_running = numThreads - 1;
+            ++m_generation;
+        }
+        m_start.notify_all();
+    }
+
+    job(0);
+
+    if (numThreads > 1) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_running == 0; });
+        m_job = nullptr;
+    }
+}
+
+void WorkerPool::work(size_t thread, uint64_t generation) {
+    while (true) {
+        std::function<void(size_t)> const * job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]() { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+            // workers beyond the threads of a run sit it out
+            if (thread >= m_numThreads) {
+                continue;
+            }
+            job = m_job;
+        }
+
+        (*job)(thread);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            last = --m_running == 0;
+        }
+        if (last) {
+            m_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef PRT_WORKER_POOL_H
+#define PRT_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Threads that wait for jobs between runs, so that work
+ * spread over threads every frame does not pay for
+ * starting and joining them
+ */
+class WorkerPool {
+public:
+    static constexpr size_t maxWorkers = 16;
+
+    WorkerPool() = default;
+    ~WorkerPool();
+
+    WorkerPool(WorkerPool const &) = delete;
+    WorkerPool & operator=(WorkerPool const &) = delete;
+
+    /**
+     * Joins the current workers and starts new ones
+     * @param numWorkers number of threads besides the caller
+     */
+    void resize(size_t numWorkers);
+    size_t size() const { return m_numWorkers; }
+
+    /**
+     * Runs the job on the calling thread and on workers,
+     * returns once every thread has finished the job
+     * @param job called with the index of the thread,
+     *            0 for the caller
+     * @param numThreads number of threads that run
+     *                   the job, including the caller
+     */
+    void run(std::function<void(size_t)> const & job, size_t numThreads);
+
+private:
+    void work(size_t thread, uint64_t generation);
+
+    std::thread m_workers[maxWorkers];
+    size_t m_numWorkers = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    // job of the current run, guarded by the mutex
+    std::function<void(size_t)> const * m_job = nullptr;
+    size_t m_numThreads = 0;
+    // incremented on every run
+    uint64_t m_generation = 0;
+    // workers that have not finished the current run
+    size_t m_running = 0;
+    bool m_stop = false;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "physics_util.h"
 #include <glm/gtx/norm.hpp>
 
+#include <algorithm>
+#include <limits>
+
 // From "Realtime Collision Detection" by Christer Ericson
 glm::vec3 physics_util::closestPointOnTriangle(glm::vec3 const & a,
                                                glm::vec3 const & b,
@@ -138,6 +141,231 @@ glm::vec3 physics_util::closestPointOnLineSegment(glm::vec3 const & a,
     return a + v;
 }
 
+// From "Realtime Collision Detection" by Christer Ericson
+float physics_util::closestPointsOnLineSegments(glm::vec3 const & p1,
+                                                glm::vec3 const & q1,
+                                                glm::vec3 const & p2,
+                                                glm::vec3 const & q2,
+                                                glm::vec3 & c1,
+                                                glm::vec3 & c2) {
+    static constexpr float epsilon = 0.000001f;
+    glm::vec3 d1 = q1 - p1; // Direction vector of segment S1
+    glm::vec3 d2 = q2 - p2; // Direction vector of segment S2
+    glm::vec3 r = p1 - p2;
+    float a = glm::dot(d1, d1); // Squared length of segment S1, always nonnegative
+    float e = glm::dot(d2, d2); // Squared length of segment S2, always nonnegative
+    float f = glm::dot(d2, r);
+    float s;
+    float t;
+    // Check if either or both segments degenerate into points
+    if (a <= epsilon && e <= epsilon) {
+        // Both segments degenerate into points
+        c1 = p1;
+        c2 = p2;
+        return glm::dot(c1 - c2, c1 - c2);
+    }
+    if (a <= epsilon) {
+        // First segment degenerates into a point
+        s = 0.0f;
+        t = glm::clamp(f / e, 0.0f, 1.0f); // s = 0 => t = (b*s + f) / e = f / e
+    } else {
+        float c = glm::dot(d1, r);
+        if (e <= epsilon) {
+            // Second segment degenerates into a point
+            t = 0.0f;
+            s = glm::clamp(-c / a, 0.0f, 1.0f); // t = 0 => s = (b*t - c) / a = -c / a
+        } else {
+            // The general nondegenerate case starts here
+            float b = glm::dot(d1, d2);
+            float denom = a*e-b*b; // Always nonnegative
+            // If segments not parallel, compute closest point on L1 to L2 and
+            // clamp to segment S1. Else pick arbitrary s (here 0)
+            if (denom != 0.0f) {
+                s = glm::clamp((b*f - c*e) / denom, 0.0f, 1.0f);
+            } else {
+                s = 0.0f;
+            }
+            // Compute point on L2 closest to S1(s)
+            t = (b*s + f) / e;
+            // If t in [0,1] done. Else clamp t, recompute s for the new value
+            // of t and clamp s to [0, 1]
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            } else if (t > 1.0f) {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+    return glm::dot(c1 - c2, c1 - c2);
+}
+
+float physics_util::closestPointsLineSegmentTriangle(glm::vec3 const & a,
+                                                     glm::vec3 const & b,
+                                                     glm::vec3 const & p0,
+                                                     glm::vec3 const & p1,
+                                                     glm::vec3 const & p2,
+                                                     glm::vec3 & cSegment,
+                                                     glm::vec3 & cTriangle) {
+    // segment pierces the triangle from either side
+    float t;
+    if (intersectLineSegmentTriangle(a, b, p0, p1, p2, t) ||
+        intersectLineSegmentTriangle(a, b, p0, p2, p1, t)) {
+        cSegment = a + t * (b - a);
+        cTriangle = cSegment;
+        return 0.0f;
+    }
+
+    // otherwise the closest points are found on either
+    // a segment end point or a triangle edge
+    cSegment = a;
+    cTriangle = closestPointOnTriangle(p0, p1, p2, a);
+    float minDist2 = glm::distance2(cSegment, cTriangle);
+
+    glm::vec3 cs;
+    glm::vec3 ct = closestPointOnTriangle(p0, p1, p2, b);
+    float dist2 = glm::distance2(b, ct);
+    if (dist2 < minDist2) {
+        minDist2 = dist2;
+        cSegment = b;
+        cTriangle = ct;
+    }
+
+    glm::vec3 const * edges[3][2] = { {&p0, &p1}, {&p1, &p2}, {&p2, &p0} };
+    for (auto const & edge : edges) {
+        dist2 = closestPointsOnLineSegments(a, b, *edge[0], *edge[1], cs, ct);
+        if (dist2 < minDist2) {
+            minDist2 = dist2;
+            cSegment = cs;
+            cTriangle = ct;
+        }
+    }
+    return minDist2;
+}
+
+// The squared distance is a convex piecewise quadratic along the segment,
+// with pieces that end where the segment enters or leaves a slab of the box.
+// Each piece is minimized in closed form.
+float physics_util::squaredDistanceLineSegmentBox(glm::vec3 const & a,
+                                                  glm::vec3 const & b,
+                                                  glm::vec3 const & halfExtents) {
+    glm::vec3 const d = b - a;
+
+    // ends of the pieces, kept in order
+    float ts[8] = { 0.0f, 1.0f };
+    size_t n = 2;
+    for (int i = 0; i < 3; ++i) {
+        if (d[i] == 0.0f) continue;
+        for (float plane : { -halfExtents[i], halfExtents[i] }) {
+            float t = (plane - a[i]) / d[i];
+            if (t > 0.0f && t < 1.0f) {
+                size_t j = n++;
+                for (; ts[j - 1] > t; --j) {
+                    ts[j] = ts[j - 1];
+                }
+                ts[j] = t;
+            }
+        }
+    }
+
+    auto squaredDistance = [&](float t) {
+        glm::vec3 p = a + t * d;
+        glm::vec3 e = glm::max(glm::abs(p) - halfExtents, glm::vec3{0.0f});
+        return glm::dot(e, e);
+    };
+
+    float minDist2 = std::numeric_limits<float>::max();
+    for (size_t k = 0; k + 1 < n; ++k) {
+        // every axis stays below, within or above its slab
+        // over the piece, which gives a quadratic in t
+        float mid = 0.5f * (ts[k] + ts[k + 1]);
+        float quadratic = 0.0f;
+        float linear = 0.0f;
+        for (int i = 0; i < 3; ++i) {
+            float p = a[i] + mid * d[i];
+            float offset;
+            if (p > halfExtents[i]) {
+                offset = a[i] - halfExtents[i];
+            } else if (p < -halfExtents[i]) {
+                offset = a[i] + halfExtents[i];
+            } else {
+                continue;
+            }
+            quadratic += d[i] * d[i];
+            linear += offset * d[i];
+        }
+        float t = quadratic > 0.0f ? glm::clamp(-linear / quadratic, ts[k], ts[k + 1]) : ts[k];
+        minDist2 = std::min(minDist2, squaredDistance(t));
+    }
+    return minDist2;
+}
+
+// Conservative advancement. The distance between two convex shapes
+// under linear translation is a convex function of t, so stepping along
+// its tangent never overshoots the time of impact.
+bool physics_util::sweepCapsuleTriangle(glm::vec3 const & a,
+                                        glm::vec3 const & b,
+                                        float radius,
+                                        glm::vec3 const & displacement,
+                                        glm::vec3 const & p0,
+                                        glm::vec3 const & p1,
+                                        glm::vec3 const & p2,
+                                        float & t,
+                                        glm::vec3 & normal,
+                                        glm::vec3 & point) {
+    static constexpr unsigned int maxIterations = 32;
+    static constexpr float tolerance = 0.0001f;
+    // relative rate of approach below which motion is tangential
+    static constexpr float tangentTolerance = 0.001f;
+
+    glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+    float nLength = glm::length(n);
+    if (nLength == 0.0f) return false; // degenerate triangle
+    n /= nLength;
+    // only front faces block movement
+    if (glm::dot(n, displacement) >= 0.0f) return false;
+    float minApproach = tangentTolerance * glm::length(displacement);
+
+    t = 0.0f;
+    for (unsigned int i = 0; i < maxIterations; ++i) {
+        glm::vec3 offset = t * displacement;
+        glm::vec3 cSegment;
+        glm::vec3 cTriangle;
+        float dist = glm::sqrt(closestPointsLineSegmentTriangle(a + offset, b + offset, 
+                                                                p0, p1, p2, 
+                                                                cSegment, cTriangle));
+        glm::vec3 dir = dist > 0.0f ? (cSegment - cTriangle) / dist : n;
+        // rate at which the distance decreases
+        float approach = -glm::dot(dir, displacement);
+        if (approach <= minApproach) {
+            // moving away or sliding along, the distance 
+            // can not decrease noticeably from here on
+            return false;
+        }
+
+        float separation = dist - radius;
+        if (separation <= tolerance) {
+            normal = dir;
+            point = cTriangle;
+            return true;
+        }
+
+        t += separation / approach;
+        if (t > 1.0f) {
+            return false;
+        }
+    }
+    // still separated, but report impact to remain conservative
+    glm::vec3 offset = t * displacement;
+    glm::vec3 cSegment;
+    closestPointsLineSegmentTriangle(a + offset, b + offset, p0, p1, p2, cSegment, point);
+    normal = n;
+    return true;
+}
+
 // from Generic Collision Detection for Games Using Ellipsoids
 // by Paul Nettle
 bool physics_util::intersectRayPlane(glm::vec3 const & planeOrigin, 
@@ -44,6 +44,91 @@ namespace physics_util {
                                         glm::vec3 const & b,
                                         glm::vec3 const & p);
 
+    /**
+     * Computes the closest points between line segments
+     * (p1,q1) and (p2,q2)
+     * @param p1 start of first segment
+     * @param q1 end of first segment
+     * @param p2 start of second segment
+     * @param q2 end of second segment
+     * @param c1 closest point on first segment, return by reference
+     * @param c2 closest point on second segment, return by reference
+     * @return squared distance between the segments
+     */
+    float closestPointsOnLineSegments(glm::vec3 const & p1,
+                                      glm::vec3 const & q1,
+                                      glm::vec3 const & p2,
+                                      glm::vec3 const & q2,
+                                      glm::vec3 & c1,
+                                      glm::vec3 & c2);
+
+    /**
+     * Computes the closest points between line segment
+     * (a,b) and non-degenerate triangle (p0,p1,p2)
+     * @param a start of segment
+     * @param b end of segment
+     * @param p0 triangle vertex
+     * @param p1 triangle vertex
+     * @param p2 triangle vertex
+     * @param cSegment closest point on segment, return by reference
+     * @param cTriangle closest point on triangle, return by reference
+     * @return squared distance between segment and triangle
+     */
+    float closestPointsLineSegmentTriangle(glm::vec3 const & a,
+                                           glm::vec3 const & b,
+                                           glm::vec3 const & p0,
+                                           glm::vec3 const & p1,
+                                           glm::vec3 const & p2,
+                                           glm::vec3 & cSegment,
+                                           glm::vec3 & cTriangle);
+
+    /**
+     * Computes the squared distance between line segment
+     * (a,b) and the axis aligned box with given half
+     * extents, centered at the origin
+     * @param a start of segment
+     * @param b end of segment
+     * @param halfExtents half extents of box
+     * @return squared distance between segment and box,
+     *         zero if they intersect
+     */
+    float squaredDistanceLineSegmentBox(glm::vec3 const & a,
+                                        glm::vec3 const & b,
+                                        glm::vec3 const & halfExtents);
+
+    /**
+     * Computes time of impact of a capsule, given by
+     * segment (a,b) and radius, translated by displacement
+     * against the front face of triangle (p0,p1,p2).
+     * A sphere is given by a == b.
+     * A capsule that initially overlaps the triangle hits
+     * at t = 0, unless it is moving away from the triangle
+     * @param a capsule segment start
+     * @param b capsule segment end
+     * @param radius capsule radius
+     * @param displacement translation of the capsule
+     * @param p0 triangle vertex
+     * @param p1 triangle vertex
+     * @param p2 triangle vertex
+     * 
+     * @param t resulting t in [0,1] such that a + t * displacement
+     *          gives the position of impact, if possible
+     * @param normal normal of impact, pointing away from the triangle
+     * @param point point of impact on the triangle
+     * @return true if intersection,
+     *         false otherwise 
+     */
+    bool sweepCapsuleTriangle(glm::vec3 const & a,
+                              glm::vec3 const & b,
+                              float radius,
+                              glm::vec3 const & displacement,
+                              glm::vec3 const & p0,
+                              glm::vec3 const & p1,
+                              glm::vec3 const & p2,
+                              float & t,
+                              glm::vec3 & normal,
+                              glm::vec3 & point);
+
     /**
      * Computes intersection of ray and plane
      * @param planeOrigin point on plane
@@ -0,0 +1,139 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/animation/animation_compression.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    float random(float min, float max) {
+        return min + (max - min) * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
+    }
+
+    float angle(glm::quat const & a, glm::quat const & b) {
+        glm::quat d = glm::dot(a, b) < 0.0f ? a + b : a - b;
+        float chord = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z + d.w * d.w);
+        return 4.0f * std::asin(std::min(0.5f * chord, 1.0f));
+    }
+
+    glm::quat rotation(float t) {
+        glm::vec3 axis = glm::normalize(glm::vec3{ std::sin(t), 1.0f, std::cos(0.5f * t) });
+        return glm::angleAxis(1.5f * std::sin(t), axis);
+    }
+
+    // reference interpolation of uncompressed keys
+    template<typename T, typename Interpolate>
+    T interpolate(prt::vector<float> const & times, prt::vector<T> const & values, float time, Interpolate mix) {
+        size_t i = 0;
+        while (i + 1 < times.size() && times[i + 1] <= time) {
+            ++i;
+        }
+        if (i + 1 == times.size()) {
+            return values[i];
+        }
+        float t = (time - times[i]) / (times[i + 1] - times[i]);
+        return mix(values[i], values[i + 1], glm::clamp(t, 0.0f, 1.0f));
+    }
+}
+
+TEST_CASE( "RotationTrack: Smallest three encoding", "[animation_compression]") {
+    srand(1);
+    for (int i = 0; i < 10000; ++i) {
+        glm::quat q = glm::normalize(glm::quat{ random(-1.0f, 1.0f), random(-1.0f, 1.0f),
+                                                random(-1.0f, 1.0f), random(-1.0f, 1.0f) });
+        uint16_t packed[3];
+        RotationTrack::encode(q, packed);
+        REQUIRE(angle(RotationTrack::decode(packed), q) < 0.0002f);
+    }
+
+    // components on the boundaries
+    glm::quat axes[4] = { glm::quat{1.0f, 0.0f, 0.0f, 0.0f}, glm::quat{0.0f, 1.0f, 0.0f, 0.0f},
+                          glm::quat{0.0f, 0.0f, 0.0f, -1.0f}, glm::normalize(glm::quat{1.0f, 1.0f, 0.0f, 0.0f}) };
+    for (glm::quat const & q : axes) {
+        uint16_t packed[3];
+        RotationTrack::encode(q, packed);
+        REQUIRE(angle(RotationTrack::decode(packed), q) < 0.0002f);
+    }
+}
+
+TEST_CASE( "Vec3Track: Constant and linear tracks are reduced", "[animation_compression]") {
+    prt::vector<float> times;
+    prt::vector<glm::vec3> constant;
+    prt::vector<glm::vec3> linear;
+    for (int i = 0; i < 100; ++i) {
+        times.push_back(float(i));
+        constant.push_back(glm::vec3{1.0f, 2.0f, 3.0f});
+        linear.push_back(glm::vec3{0.1f * i, -0.02f * i, 5.0f});
+    }
+
+    Vec3Track track;
+    track.compress(times.data(), constant.data(), constant.size(), 0.0001f);
+    REQUIRE(track.size() == 1);
+    uint32_t cursor = 0;
+    glm::vec3 value = track.sample(42.0f, 99.0f, false, cursor);
+    REQUIRE(glm::length(value - glm::vec3{1.0f, 2.0f, 3.0f}) == Approx(0.0f));
+
+    track.compress(times.data(), linear.data(), linear.size(), 0.0001f);
+    REQUIRE(track.size() == 2);
+    cursor = 0;
+    for (float t = 0.0f; t < 99.0f; t += 0.37f) {
+        glm::vec3 expected = glm::vec3{0.1f * t, -0.02f * t, 5.0f};
+        REQUIRE(glm::length(track.sample(t, 99.0f, false, cursor) - expected) < 0.001f);
+    }
+}
+
+TEST_CASE( "Compressed tracks stay within their tolerance", "[animation_compression]") {
+    // variable rate keys, dense where the motion is fast
+    prt::vector<float> times;
+    prt::vector<glm::vec3> positions;
+    prt::vector<glm::quat> rotations;
+    float t = 0.0f;
+    while (t < 100.0f) {
+        times.push_back(t);
+        positions.push_back(glm::vec3{ std::sin(0.1f * t), 0.5f * std::cos(0.05f * t), 0.01f * t });
+        rotations.push_back(rotation(0.1f * t));
+        t += 0.75f + 0.5f * std::sin(0.3f * t);
+    }
+
+    AnimationTolerance tolerance;
+    Vec3Track positionTrack;
+    RotationTrack rotationTrack;
+    positionTrack.compress(times.data(), positions.data(), positions.size(), tolerance.position);
+    rotationTrack.compress(times.data(), rotations.data(), rotations.size(), tolerance.rotation);
+    REQUIRE(positionTrack.size() < times.size());
+    REQUIRE(rotationTrack.size() < times.size());
+
+    // at the original keys the error is bounded by the tolerance and quantization
+    float duration = times.back();
+    uint32_t positionCursor = 0;
+    uint32_t rotationCursor = 0;
+    for (size_t i = 0; i < times.size(); ++i) {
+        glm::vec3 position = positionTrack.sample(times[i], duration, false, positionCursor);
+        glm::quat rotation = rotationTrack.sample(times[i], duration, false, rotationCursor);
+        REQUIRE(glm::length(position - positions[i]) < tolerance.position + 0.0001f);
+        REQUIRE(angle(rotation, rotations[i]) < tolerance.rotation + 0.0002f);
+    }
+
+    // sequential and random access agree with the uncompressed keys
+    auto mix = [](glm::vec3 const & a, glm::vec3 const & b, float f) { return glm::mix(a, b, f); };
+    srand(2);
+    for (int i = 0; i < 1000; ++i) {
+        float time = i % 2 == 0 ? 0.1f * i : random(0.0f, duration);
+        glm::vec3 position = positionTrack.sample(time, duration, false, positionCursor);
+        REQUIRE(glm::length(position - interpolate(times, positions, time, mix)) < 0.005f);
+    }
+}
+
+TEST_CASE( "Looping tracks interpolate towards the first key", "[animation_compression]") {
+    prt::vector<float> times = { 0.0f, 10.0f, 20.0f };
+    prt::vector<glm::vec3> values = { glm::vec3{0.0f}, glm::vec3{2.0f}, glm::vec3{1.0f} };
+    Vec3Track track;
+    track.compress(times.data(), values.data(), values.size(), 0.0f);
+    REQUIRE(track.size() == 3);
+
+    uint32_t cursor = 0;
+    REQUIRE(track.sample(25.0f, 30.0f, true, cursor).x == Approx(0.5f).margin(0.001f));
+    REQUIRE(track.sample(25.0f, 30.0f, false, cursor).x == Approx(1.0f).margin(0.001f));
+    // time moving backwards restarts the search
+    REQUIRE(track.sample(5.0f, 30.0f, true, cursor).x == Approx(1.0f).margin(0.001f));
+}
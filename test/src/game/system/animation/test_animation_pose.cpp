@@ -0,0 +1,101 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/animation/animation_pose.h"
+
+#include <cmath>
+
+namespace {
+    float angle(glm::quat const & a, glm::quat const & b) {
+        glm::quat d = glm::dot(a, b) < 0.0f ? a + b : a - b;
+        float chord = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z + d.w * d.w);
+        return 4.0f * std::asin(std::min(0.5f * chord, 1.0f));
+    }
+
+    void setPose(AnimationPose & pose, size_t numNodes, glm::vec3 const & position,
+                 glm::quat const & rotation, glm::vec3 const & scale) {
+        pose.resize(numNodes);
+        for (size_t i = 0; i < numNodes; ++i) {
+            pose.positions[i] = position;
+            pose.rotations[i] = rotation;
+            pose.scales[i] = scale;
+        }
+    }
+}
+
+TEST_CASE( "blendPoses: Weighted blend of two poses", "[animation_pose]") {
+    glm::vec3 axis = glm::normalize(glm::vec3{1.0f, 2.0f, 0.5f});
+    glm::quat rotationA = glm::angleAxis(0.2f, axis);
+    glm::quat rotationB = glm::angleAxis(1.4f, axis);
+
+    for (float weight : { 0.0f, 0.25f, 0.5f, 0.9f, 1.0f }) {
+        AnimationPose poseA;
+        AnimationPose poseB;
+        setPose(poseA, 5, glm::vec3{0.0f}, rotationA, glm::vec3{1.0f});
+        setPose(poseB, 5, glm::vec3{2.0f, -4.0f, 1.0f}, rotationB, glm::vec3{3.0f});
+        blendPoses(poseA, poseB, weight, nullptr);
+
+        for (size_t i = 0; i < 5; ++i) {
+            REQUIRE(glm::length(poseA.positions[i] - weight * glm::vec3{2.0f, -4.0f, 1.0f}) < 0.0001f);
+            REQUIRE(poseA.scales[i].y == Approx(1.0f + 2.0f * weight));
+            REQUIRE(angle(poseA.rotations[i], glm::slerp(rotationA, rotationB, weight)) < 0.002f);
+        }
+    }
+}
+
+TEST_CASE( "blendPoses: Masked nodes keep their pose", "[animation_pose]") {
+    AnimationPose poseA;
+    AnimationPose poseB;
+    setPose(poseA, 4, glm::vec3{0.0f}, glm::quat{1.0f, 0.0f, 0.0f, 0.0f}, glm::vec3{1.0f});
+    setPose(poseB, 4, glm::vec3{1.0f}, glm::angleAxis(1.0f, glm::vec3{0.0f, 1.0f, 0.0f}), glm::vec3{2.0f});
+
+    float mask[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+    blendPoses(poseA, poseB, 1.0f, mask);
+
+    for (size_t i = 0; i < 4; ++i) {
+        REQUIRE(poseA.positions[i].x == Approx(mask[i]));
+        REQUIRE(poseA.scales[i].z == Approx(1.0f + mask[i]));
+        REQUIRE(angle(poseA.rotations[i], glm::quat{1.0f, 0.0f, 0.0f, 0.0f}) == Approx(mask[i]).margin(0.002f));
+    }
+}
+
+TEST_CASE( "addPose: Difference to the reference is added", "[animation_pose]") {
+    glm::quat base = glm::angleAxis(0.5f, glm::vec3{1.0f, 0.0f, 0.0f});
+    glm::quat referenceRotation = glm::angleAxis(0.3f, glm::vec3{0.0f, 0.0f, 1.0f});
+    glm::quat delta = glm::angleAxis(0.8f, glm::vec3{0.0f, 0.0f, 1.0f});
+
+    AnimationPose pose;
+    AnimationPose additive;
+    AnimationPose reference;
+    setPose(pose, 3, glm::vec3{1.0f, 2.0f, 3.0f}, base, glm::vec3{2.0f});
+    setPose(reference, 3, glm::vec3{0.5f}, referenceRotation, glm::vec3{1.0f, 2.0f, 4.0f});
+    setPose(additive, 3, glm::vec3{1.5f, 0.5f, 0.0f}, delta * referenceRotation, glm::vec3{2.0f, 2.0f, 2.0f});
+
+    SECTION( "The reference itself adds nothing" ) {
+        addPose(pose, reference, reference, 1.0f, nullptr);
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(glm::length(pose.positions[i] - glm::vec3{1.0f, 2.0f, 3.0f}) < 0.0001f);
+            REQUIRE(angle(pose.rotations[i], base) < 0.0005f);
+            REQUIRE(glm::length(pose.scales[i] - glm::vec3{2.0f}) < 0.0001f);
+        }
+    }
+
+    SECTION( "Full weight" ) {
+        addPose(pose, additive, reference, 1.0f, nullptr);
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(glm::length(pose.positions[i] - glm::vec3{2.0f, 2.0f, 2.5f}) < 0.0001f);
+            REQUIRE(angle(pose.rotations[i], delta * base) < 0.0005f);
+            REQUIRE(glm::length(pose.scales[i] - glm::vec3{4.0f, 2.0f, 1.0f}) < 0.0001f);
+        }
+    }
+
+    SECTION( "Partial weight and mask" ) {
+        float mask[3] = { 1.0f, 0.0f, 1.0f };
+        addPose(pose, additive, reference, 0.5f, mask);
+        REQUIRE(glm::length(pose.positions[0] - glm::vec3{1.5f, 2.0f, 2.75f}) < 0.0001f);
+        REQUIRE(angle(pose.rotations[0], base) == Approx(0.4f).margin(0.01f));
+        REQUIRE(glm::length(pose.scales[0] - glm::vec3{3.0f, 2.0f, 1.5f}) < 0.0001f);
+
+        REQUIRE(glm::length(pose.positions[1] - glm::vec3{1.0f, 2.0f, 3.0f}) < 0.0001f);
+        REQUIRE(angle(pose.rotations[1], base) < 0.0005f);
+    }
+}
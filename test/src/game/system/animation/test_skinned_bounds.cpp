@@ -0,0 +1,132 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/animation/skinned_bounds.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdlib>
+#include <limits>
+
+namespace {
+    float random(float min, float max) {
+        return min + (max - min) * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
+    }
+
+    glm::mat4 randomTransform() {
+        glm::vec3 axis = glm::normalize(glm::vec3{ random(-1.0f, 1.0f), random(-1.0f, 1.0f), 1.0f });
+        glm::mat4 rotation = glm::mat4_cast(glm::angleAxis(random(-3.0f, 3.0f), axis));
+        glm::mat4 transform = rotation;
+        for (int i = 0; i < 3; ++i) {
+            transform[i] *= random(0.5f, 2.0f);
+        }
+        transform[3] = glm::vec4{ random(-5.0f, 5.0f), random(-5.0f, 5.0f), random(-5.0f, 5.0f), 1.0f };
+        return transform;
+    }
+
+    bool contains(AABB const & bounds, glm::vec3 const & point) {
+        static constexpr float epsilon = 0.0001f;
+        for (int i = 0; i < 3; ++i) {
+            if (point[i] < bounds.lowerBound[i] - epsilon || point[i] > bounds.upperBound[i] + epsilon) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE( "SkinnedBounds: Identity palette gives the bounds of the vertices", "[skinned_bounds]") {
+    SkinnedBounds skinnedBounds;
+    skinnedBounds.reset(3);
+    skinnedBounds.addVertex(glm::vec3{-1.0f, 0.0f, 2.0f}, glm::uvec4{0, 0, 0, 0}, glm::vec4{1.0f, 0.0f, 0.0f, 0.0f});
+    skinnedBounds.addVertex(glm::vec3{3.0f, -2.0f, 0.5f}, glm::uvec4{1, 2, 0, 0}, glm::vec4{0.5f, 0.5f, 0.0f, 0.0f});
+    skinnedBounds.addVertex(glm::vec3{0.0f, 4.0f, 1.0f}, glm::uvec4{2, 0, 0, 0}, glm::vec4{1.0f, 0.0f, 0.0f, 0.0f});
+
+    BoneTransform palette[3];
+    for (BoneTransform & transform : palette) {
+        transform = toBoneTransform(glm::mat4(1.0f));
+    }
+    AABB bounds = skinnedBounds.transform(palette);
+    REQUIRE(glm::length(bounds.lowerBound - glm::vec3{-1.0f, -2.0f, 0.5f}) < 0.0001f);
+    REQUIRE(glm::length(bounds.upperBound - glm::vec3{3.0f, 4.0f, 2.0f}) < 0.0001f);
+
+    // a translated bone moves its vertices only
+    palette[0] = toBoneTransform(glm::translate(glm::mat4(1.0f), glm::vec3{0.0f, 0.0f, 10.0f}));
+    bounds = skinnedBounds.transform(palette);
+    REQUIRE(bounds.upperBound.z == Approx(12.0f));
+    REQUIRE(bounds.lowerBound.z == Approx(0.5f));
+}
+
+TEST_CASE( "SkinnedBounds: Skinned vertices lie within the bounds", "[skinned_bounds]") {
+    srand(3);
+    static constexpr size_t numBones = 8;
+    static constexpr size_t numVertices = 500;
+
+    prt::vector<glm::vec3> positions;
+    prt::vector<glm::uvec4> boneIDs;
+    prt::vector<glm::vec4> boneWeights;
+    SkinnedBounds skinnedBounds;
+    skinnedBounds.reset(numBones);
+    for (size_t i = 0; i < numVertices; ++i) {
+        glm::vec3 position = { random(-1.0f, 1.0f), random(0.0f, 2.0f), random(-0.5f, 0.5f) };
+        glm::uvec4 ids;
+        glm::vec4 weights;
+        for (int j = 0; j < 4; ++j) {
+            ids[j] = rand() % numBones;
+            weights[j] = j < 2 || i % 2 == 0 ? random(0.0f, 1.0f) : 0.0f;
+        }
+        // a few vertices without weights are not skinned
+        if (i % 50 == 0) {
+            weights = glm::vec4{0.0f};
+        }
+        float sum = weights.x + weights.y + weights.z + weights.w;
+        weights = sum > 0.0f ? weights / sum : weights;
+
+        positions.push_back(position);
+        boneIDs.push_back(ids);
+        boneWeights.push_back(weights);
+        skinnedBounds.addVertex(position, ids, weights);
+    }
+
+    for (int frame = 0; frame < 20; ++frame) {
+        glm::mat4 transforms[numBones];
+        BoneTransform palette[numBones];
+        for (size_t i = 0; i < numBones; ++i) {
+            transforms[i] = randomTransform();
+            palette[i] = toBoneTransform(transforms[i]);
+        }
+        AABB bounds = skinnedBounds.transform(palette);
+
+        for (size_t i = 0; i < numVertices; ++i) {
+            glm::vec4 position = glm::vec4{positions[i], 1.0f};
+            float sum = boneWeights[i].x + boneWeights[i].y + boneWeights[i].z + boneWeights[i].w;
+            glm::vec4 skinned = sum > 0.0f ? glm::vec4{0.0f} : position;
+            for (int j = 0; j < 4; ++j) {
+                skinned += boneWeights[i][j] * (transforms[boneIDs[i][j]] * position);
+            }
+            REQUIRE(contains(bounds, glm::vec3(skinned)));
+        }
+    }
+}
+
+TEST_CASE( "SkinnedBounds: Transformed boxes enclose their corners", "[skinned_bounds]") {
+    srand(4);
+    AABB box = { glm::vec3{-1.0f, 0.5f, -2.0f}, glm::vec3{2.0f, 1.0f, 3.0f} };
+    for (int i = 0; i < 100; ++i) {
+        glm::mat4 transform = randomTransform();
+        AABB bounds = SkinnedBounds::transformBounds(box, transform);
+        glm::vec3 lower = glm::vec3{ std::numeric_limits<float>::max() };
+        glm::vec3 upper = -lower;
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 point = { corner & 1 ? box.upperBound.x : box.lowerBound.x,
+                                corner & 2 ? box.upperBound.y : box.lowerBound.y,
+                                corner & 4 ? box.upperBound.z : box.lowerBound.z };
+            glm::vec3 transformed = glm::vec3(transform * glm::vec4{point, 1.0f});
+            lower = glm::min(lower, transformed);
+            upper = glm::max(upper, transformed);
+        }
+        // the box around the transformed corners is tight
+        REQUIRE(glm::length(bounds.lowerBound - lower) < 0.001f);
+        REQUIRE(glm::length(bounds.upperBound - upper) < 0.001f);
+    }
+}
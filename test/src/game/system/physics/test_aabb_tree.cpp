@@ -0,0 +1,180 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/physics/aabb_tree.h"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    float random(float min, float max) {
+        return min + (max - min) * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
+    }
+
+    struct MovingBoxes {
+        DynamicAABBTree tree;
+        prt::vector<ColliderTag> tags;
+        prt::vector<AABB> aabbs;
+        prt::vector<glm::vec3> velocities;
+        prt::vector<int32_t> treeIndices;
+
+        explicit MovingBoxes(size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                glm::vec3 position = { random(-100.0f, 100.0f), random(0.0f, 10.0f), random(-100.0f, 100.0f) };
+                tags.push_back(ColliderTag{ColliderIndex(i), COLLIDER_SHAPE_CAPSULE, COLLIDER_TYPE_COLLIDE});
+                aabbs.push_back(AABB{position, position + glm::vec3{1.0f, 2.0f, 1.0f}});
+                velocities.push_back(glm::vec3{ random(-0.2f, 0.2f), 0.0f, random(-0.2f, 0.2f) });
+            }
+            treeIndices.resize(n);
+            tree.insert(tags.data(), aabbs.data(), n, treeIndices.data());
+        }
+
+        void step() {
+            for (size_t i = 0; i < aabbs.size(); ++i) {
+                glm::vec3 position = aabbs[i].lowerBound + velocities[i];
+                // bounce off the edges of the area
+                for (int axis : { 0, 2 }) {
+                    if (position[axis] < -100.0f || position[axis] > 100.0f) {
+                        velocities[i][axis] = -velocities[i][axis];
+                    }
+                }
+                aabbs[i] = AABB{position, position + glm::vec3{1.0f, 2.0f, 1.0f}};
+            }
+            tree.update(treeIndices.data(), aabbs.data(), aabbs.size());
+        }
+
+        float freshCost() const {
+            DynamicAABBTree fresh;
+            prt::vector<int32_t> indices;
+            indices.resize(aabbs.size());
+            fresh.insert(tags.data(), aabbs.data(), aabbs.size(), indices.data());
+            return fresh.cost();
+        }
+
+        // every box is found by a query for its own aabb
+        bool consistent() {
+            prt::vector<ColliderTag> result;
+            for (size_t i = 0; i < aabbs.size(); ++i) {
+                result.resize(0);
+                tree.query(ColliderTag{}, aabbs[i], result);
+                bool found = false;
+                for (ColliderTag const & tag : result) {
+                    found = found || tag == tags[i];
+                }
+                if (!found) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+TEST_CASE( "DynamicAABBTree: Queries find every intersection", "[aabb_tree]") {
+    srand(1);
+    MovingBoxes boxes(500);
+    for (int i = 0; i < 100; ++i) {
+        boxes.step();
+    }
+
+    prt::vector<ColliderTag> result;
+    for (int i = 0; i < 200; ++i) {
+        glm::vec3 position = { random(-100.0f, 100.0f), random(0.0f, 10.0f), random(-100.0f, 100.0f) };
+        AABB query = { position, position + glm::vec3{ random(0.0f, 20.0f), 2.0f, random(0.0f, 20.0f) } };
+
+        result.resize(0);
+        boxes.tree.query(ColliderTag{}, query, result);
+        for (size_t j = 0; j < boxes.aabbs.size(); ++j) {
+            if (AABB::intersect(boxes.aabbs[j], query)) {
+                bool found = false;
+                for (ColliderTag const & tag : result) {
+                    found = found || tag == boxes.tags[j];
+                }
+                REQUIRE(found);
+            }
+        }
+    }
+}
+
+TEST_CASE( "DynamicAABBTree: Optimize keeps tree indices", "[aabb_tree]") {
+    srand(2);
+    MovingBoxes boxes(500);
+    for (int i = 0; i < 100; ++i) {
+        boxes.step();
+    }
+
+    float cost = boxes.tree.cost();
+    prt::vector<int32_t> treeIndices = boxes.treeIndices;
+    boxes.tree.optimize(100);
+    REQUIRE(boxes.tree.cost() <= cost);
+
+    // leaves are still where the indices say they are
+    for (size_t i = 0; i < boxes.tags.size(); ++i) {
+        REQUIRE(boxes.treeIndices[i] == treeIndices[i]);
+    }
+    for (size_t i = 0; i < boxes.tags.size(); ++i) {
+        boxes.tags[i].index += 1000;
+    }
+    boxes.tree.updateTags(boxes.treeIndices.data(), boxes.tags.data(), boxes.tags.size());
+    REQUIRE(boxes.consistent());
+
+    // removal after optimizing
+    boxes.tree.remove(boxes.treeIndices.data(), 250);
+    boxes.tree.optimize(100);
+    prt::vector<ColliderTag> result;
+    boxes.tree.query(ColliderTag{}, AABB{glm::vec3{-200.0f}, glm::vec3{200.0f}}, result);
+    REQUIRE(result.size() == 250);
+}
+
+TEST_CASE( "DynamicAABBTree: Cost stays flat as leaves move", "[aabb_tree]") {
+    srand(3);
+    MovingBoxes boxes(1000);
+    for (int i = 0; i < 2000; ++i) {
+        boxes.step();
+        boxes.tree.optimize(10);
+    }
+    REQUIRE(boxes.consistent());
+    REQUIRE(boxes.tree.cost() < 1.25f * boxes.freshCost());
+}
+
+TEST_CASE( "DynamicAABBTree: Leaves are fattened along their displacement", "[aabb_tree]") {
+    DynamicAABBTree tree;
+    ColliderTag tags[2] = { ColliderTag{0, COLLIDER_SHAPE_MESH, COLLIDER_TYPE_COLLIDE},
+                            ColliderTag{1, COLLIDER_SHAPE_CAPSULE, COLLIDER_TYPE_COLLIDE} };
+    AABB aabbs[2] = { AABB{glm::vec3{0.0f}, glm::vec3{1.0f}},
+                      AABB{glm::vec3{10.0f}, glm::vec3{11.0f}} };
+    int32_t treeIndices[2];
+    tree.insert(&tags[0], &aabbs[0], 1, &treeIndices[0], 0.0f);
+    tree.insert(&tags[1], &aabbs[1], 1, &treeIndices[1]);
+
+    // static leaves have no margin
+    prt::vector<ColliderTag> result;
+    tree.query(ColliderTag{}, AABB{glm::vec3{1.01f}, glm::vec3{2.0f}}, result);
+    REQUIRE(result.empty());
+
+    // a leaf moving at constant speed is rarely reinserted
+    glm::vec3 displacement = { 0.5f, 0.0f, 0.0f };
+    for (int i = 0; i < 100; ++i) {
+        aabbs[1] = AABB{ aabbs[1].lowerBound + displacement, aabbs[1].upperBound + displacement };
+        tree.update(&treeIndices[1], &aabbs[1], &displacement, 1);
+    }
+    REQUIRE(tree.getReinsertions() <= 100 / 3);
+    REQUIRE(tree.getReinsertions() > 0);
+
+    // and shrunk once it stops
+    tree.resetReinsertions();
+    displacement = glm::vec3{0.0f};
+    tree.update(&treeIndices[1], &aabbs[1], &displacement, 1);
+    tree.update(&treeIndices[1], &aabbs[1], &displacement, 1);
+    REQUIRE(tree.getReinsertions() == 1);
+    result.resize(0);
+    tree.query(ColliderTag{}, AABB{aabbs[1].upperBound + 0.1f, aabbs[1].upperBound + 1.0f}, result);
+    REQUIRE(result.empty());
+
+    // without a displacement every step leaves the fat aabb
+    tree.resetReinsertions();
+    for (int i = 0; i < 100; ++i) {
+        aabbs[1] = AABB{ aabbs[1].lowerBound + 0.5f, aabbs[1].upperBound + 0.5f };
+        tree.update(&treeIndices[1], &aabbs[1], 1);
+    }
+    REQUIRE(tree.getReinsertions() == 100);
+}
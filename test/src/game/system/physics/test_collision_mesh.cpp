@@ -0,0 +1,149 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/physics/collision_mesh.h"
+
+#include <cmath>
+
+namespace {
+    // appends a grid of n x n quads spanning [0, size] in x and z
+    // with unwelded vertices, like meshes split along uv seams
+    template<typename Height>
+    void addGrid(prt::vector<glm::vec3> & vertices, unsigned int n, float size, Height height) {
+        float cell = size / n;
+        auto vertex = [&](unsigned int x, unsigned int z) {
+            return glm::vec3{x * cell, height(x * cell, z * cell), z * cell};
+        };
+        for (unsigned int z = 0; z < n; ++z) {
+            for (unsigned int x = 0; x < n; ++x) {
+                vertices.push_back(vertex(x, z));
+                vertices.push_back(vertex(x, z + 1));
+                vertices.push_back(vertex(x + 1, z + 1));
+                vertices.push_back(vertex(x, z));
+                vertices.push_back(vertex(x + 1, z + 1));
+                vertices.push_back(vertex(x + 1, z));
+            }
+        }
+    }
+
+    float area(prt::vector<glm::vec3> const & vertices) {
+        float sum = 0.0f;
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3) {
+            sum += 0.5f * glm::length(glm::cross(vertices[i + 1] - vertices[i], vertices[i + 2] - vertices[i]));
+        }
+        return sum;
+    }
+
+    CollisionMesh build(prt::vector<glm::vec3> const & vertices, CollisionMeshSettings const & settings) {
+        CollisionMesh mesh;
+        unsigned int size = vertices.size();
+        collision_mesh::build(vertices.data(), &size, 1, settings, mesh);
+        return mesh;
+    }
+}
+
+TEST_CASE( "CollisionMesh: Merge coplanar triangles", "[collision_mesh]") {
+    prt::vector<glm::vec3> vertices;
+    addGrid(vertices, 10, 4.0f, [](float, float) { return 1.0f; });
+
+    CollisionMesh mesh = build(vertices, CollisionMeshSettings{});
+
+    REQUIRE(mesh.meshSizes.size() == 1);
+    REQUIRE(mesh.meshSizes[0] == mesh.vertices.size());
+    REQUIRE(mesh.vertices.size() == 2 * 3);
+    REQUIRE(area(mesh.vertices) == Approx(16.0f));
+    for (glm::vec3 const & v : mesh.vertices) {
+        REQUIRE(v.y == Approx(1.0f));
+        // corners of the grid remain
+        REQUIRE((v.x == Approx(0.0f) || v.x == Approx(4.0f)));
+        REQUIRE((v.z == Approx(0.0f) || v.z == Approx(4.0f)));
+    }
+}
+
+TEST_CASE( "CollisionMesh: Keep closed meshes closed", "[collision_mesh]") {
+    // cube made of subdivided faces
+    prt::vector<glm::vec3> vertices;
+    prt::vector<glm::vec3> face;
+    addGrid(face, 4, 2.0f, [](float, float) { return 0.0f; });
+    glm::mat3 rotations[6] = {
+        glm::mat3(glm::vec3{1, 0, 0}, glm::vec3{0, 1, 0}, glm::vec3{0, 0, 1}),
+        glm::mat3(glm::vec3{1, 0, 0}, glm::vec3{0, -1, 0}, glm::vec3{0, 0, -1}),
+        glm::mat3(glm::vec3{0, 1, 0}, glm::vec3{-1, 0, 0}, glm::vec3{0, 0, 1}),
+        glm::mat3(glm::vec3{0, -1, 0}, glm::vec3{1, 0, 0}, glm::vec3{0, 0, 1}),
+        glm::mat3(glm::vec3{1, 0, 0}, glm::vec3{0, 0, 1}, glm::vec3{0, -1, 0}),
+        glm::mat3(glm::vec3{1, 0, 0}, glm::vec3{0, 0, -1}, glm::vec3{0, 1, 0}),
+    };
+    for (glm::mat3 const & rotation : rotations) {
+        for (glm::vec3 const & v : face) {
+            // top face of the cube centered at the origin, then rotated
+            vertices.push_back(rotation * (v + glm::vec3{-1.0f, 1.0f, -1.0f}));
+        }
+    }
+
+    CollisionMesh mesh = build(vertices, CollisionMeshSettings{});
+
+    REQUIRE(mesh.vertices.size() == 12 * 3);
+    REQUIRE(area(mesh.vertices) == Approx(24.0f));
+    for (glm::vec3 const & v : mesh.vertices) {
+        REQUIRE(glm::abs(v.x) == Approx(1.0f));
+        REQUIRE(glm::abs(v.y) == Approx(1.0f));
+        REQUIRE(glm::abs(v.z) == Approx(1.0f));
+    }
+}
+
+TEST_CASE( "CollisionMesh: Drop degenerate and sliver triangles", "[collision_mesh]") {
+    prt::vector<glm::vec3> vertices = {
+        // regular triangle
+        glm::vec3{0.0f, 0.0f, 0.0f}, glm::vec3{0.0f, 0.0f, 1.0f}, glm::vec3{1.0f, 0.0f, 0.0f},
+        // collapsed to a point after welding
+        glm::vec3{5.0f, 0.0f, 0.0f}, glm::vec3{5.0f, 0.0f, 0.0f}, glm::vec3{5.0f, 0.00000001f, 0.0f},
+        // sliver
+        glm::vec3{0.0f, 2.0f, 0.0f}, glm::vec3{0.0f, 2.0f, 10.0f}, glm::vec3{0.0001f, 2.0f, 5.0f},
+    };
+
+    CollisionMesh mesh = build(vertices, CollisionMeshSettings{});
+
+    REQUIRE(mesh.vertices.size() == 3);
+    REQUIRE(mesh.vertices[0] == vertices[0]);
+    REQUIRE(mesh.vertices[1] == vertices[1]);
+    REQUIRE(mesh.vertices[2] == vertices[2]);
+}
+
+TEST_CASE( "CollisionMesh: Simplify to triangle budget", "[collision_mesh]") {
+    auto height = [](float x, float z) { return 0.5f * std::sin(x) * std::cos(z); };
+    prt::vector<glm::vec3> vertices;
+    addGrid(vertices, 32, 8.0f, height);
+
+    // curved surface has next to nothing to merge without a budget
+    CollisionMesh full = build(vertices, CollisionMeshSettings{});
+    REQUIRE(full.vertices.size() > vertices.size() * 99 / 100);
+
+    CollisionMeshSettings settings;
+    settings.targetTriangles = 200;
+    CollisionMesh mesh = build(vertices, settings);
+
+    REQUIRE(mesh.vertices.size() / 3 <= 200);
+    REQUIRE(mesh.vertices.size() / 3 > 100);
+    REQUIRE(area(mesh.vertices) == Approx(area(vertices)).epsilon(0.05));
+    for (glm::vec3 const & v : mesh.vertices) {
+        REQUIRE(glm::abs(v.y - height(v.x, v.z)) < 0.1f);
+    }
+}
+
+TEST_CASE( "CollisionMesh: Keep meshes apart", "[collision_mesh]") {
+    prt::vector<glm::vec3> vertices;
+    addGrid(vertices, 2, 1.0f, [](float, float) { return 0.0f; });
+    addGrid(vertices, 2, 1.0f, [](float, float) { return 3.0f; });
+    unsigned int sizes[3] = { 2 * 2 * 6, 0, 2 * 2 * 6 };
+
+    CollisionMesh mesh;
+    collision_mesh::build(vertices.data(), sizes, 3, CollisionMeshSettings{}, mesh);
+
+    REQUIRE(mesh.meshSizes.size() == 3);
+    REQUIRE(mesh.meshSizes[0] == 6);
+    REQUIRE(mesh.meshSizes[1] == 0);
+    REQUIRE(mesh.meshSizes[2] == 6);
+    for (size_t i = 0; i < 6; ++i) {
+        REQUIRE(mesh.vertices[i].y == 0.0f);
+        REQUIRE(mesh.vertices[i + 6].y == 3.0f);
+    }
+}
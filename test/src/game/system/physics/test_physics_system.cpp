@@ -0,0 +1,1130 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/physics/physics_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+    // appends an axis-aligned quad of two triangles facing along normal
+    void addQuad(prt::vector<glm::vec3> & vertices,
+                 glm::vec3 const & center,
+                 glm::vec3 const & normal,
+                 float halfSize) {
+        glm::vec3 tangent = glm::abs(normal.y) > 0.5f ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        glm::vec3 p0 = center + (-tangent - bitangent) * halfSize;
+        glm::vec3 p1 = center + ( tangent - bitangent) * halfSize;
+        glm::vec3 p2 = center + ( tangent + bitangent) * halfSize;
+        glm::vec3 p3 = center + (-tangent + bitangent) * halfSize;
+        vertices.push_back(p0);
+        vertices.push_back(p1);
+        vertices.push_back(p2);
+        vertices.push_back(p0);
+        vertices.push_back(p2);
+        vertices.push_back(p3);
+    }
+
+    float terrainHeight(float x, float z) {
+        return 2.0f * std::sin(0.3f * x) * std::cos(0.2f * z) + 0.05f * x;
+    }
+
+    // samples terrainHeight on a grid with its origin at (0, 0, 0)
+    prt::vector<float> terrainHeights(unsigned int size, float cellSize) {
+        prt::vector<float> heights;
+        heights.resize(size * size);
+        for (unsigned int z = 0; z < size; ++z) {
+            for (unsigned int x = 0; x < size; ++x) {
+                heights[z * size + x] = terrainHeight(x * cellSize, z * cellSize);
+            }
+        }
+        return heights;
+    }
+
+    // triangulates terrainHeight like a heightfield, split 
+    // into square chunks of chunkSize cells per mesh
+    void terrainMesh(unsigned int size, float cellSize, unsigned int chunkSize,
+                     prt::vector<glm::vec3> & vertices, prt::vector<unsigned int> & meshSizes) {
+        auto vertex = [&](unsigned int x, unsigned int z) {
+            return glm::vec3{x * cellSize, terrainHeight(x * cellSize, z * cellSize), z * cellSize};
+        };
+        for (unsigned int cz = 0; cz < size - 1; cz += chunkSize) {
+            for (unsigned int cx = 0; cx < size - 1; cx += chunkSize) {
+                size_t start = vertices.size();
+                for (unsigned int z = cz; z < std::min(cz + chunkSize, size - 1); ++z) {
+                    for (unsigned int x = cx; x < std::min(cx + chunkSize, size - 1); ++x) {
+                        vertices.push_back(vertex(x, z));
+                        vertices.push_back(vertex(x, z + 1));
+                        vertices.push_back(vertex(x + 1, z + 1));
+                        vertices.push_back(vertex(x, z));
+                        vertices.push_back(vertex(x + 1, z + 1));
+                        vertices.push_back(vertex(x + 1, z));
+                    }
+                }
+                meshSizes.push_back(vertices.size() - start);
+            }
+        }
+    }
+
+    struct CharacterWorld {
+        PhysicsSystem physicsSystem;
+        prt::vector<CharacterPhysics> physics;
+        prt::vector<Transform> transforms;
+        prt::vector<EntityID> entityIDs;
+
+        void addFloor(float halfSize) {
+            prt::vector<glm::vec3> vertices;
+            addQuad(vertices, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, halfSize);
+            unsigned int size = vertices.size();
+            physicsSystem.addModelCollider(vertices.data(), &size, 1, Transform{});
+        }
+
+        void addCharacter(glm::vec3 const & position) {
+            physics.push_back({});
+            physics.back().colliderTag = physicsSystem.addCapsuleCollider(1.0f, 0.5f, glm::vec3{0.0f, 0.5f, 0.0f});
+            transforms.push_back({});
+            transforms.back().position = position;
+            entityIDs.push_back(entityIDs.size());
+        }
+
+        void step(float deltaTime) {
+            physicsSystem.newFrame();
+            physicsSystem.updateCharacters(deltaTime, physics.data(), transforms.data(), 
+                                           entityIDs.data(), physics.size());
+        }
+    };
+}
+
+TEST_CASE( "PhysicsSystem: Fast character does not tunnel through thin wall", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+
+    // wall of zero thickness at x = 5, facing the character
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{5.0f, 0.0f, 0.0f}, glm::vec3{-1.0f, 0.0f, 0.0f}, 10.0f);
+    unsigned int size = vertices.size();
+    world.physicsSystem.addModelCollider(vertices.data(), &size, 1, Transform{});
+
+    world.addCharacter(glm::vec3{0.0f});
+
+    for (int i = 0; i < 10; ++i) {
+        // many times the capsule radius per frame
+        world.physics[0].velocity.x = 20.0f;
+        world.step(1.0f / 60.0f);
+        REQUIRE(world.transforms[0].position.x < 5.0f - 0.5f);
+    }
+    REQUIRE(world.transforms[0].position.x > 5.0f - 0.5f - 0.01f);
+}
+
+TEST_CASE( "PhysicsSystem: Fast character does not tunnel through floor", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f, 10.0f, 0.0f});
+
+    world.physics[0].velocity.y = -50.0f;
+    world.step(1.0f / 60.0f);
+
+    REQUIRE(world.transforms[0].position.y >= 0.0f);
+    REQUIRE(world.physics[0].isGrounded);
+}
+
+TEST_CASE( "PhysicsSystem: Character slides along wall", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{1.0f, 0.0f, 0.0f}, glm::vec3{-1.0f, 0.0f, 0.0f}, 10.0f);
+    unsigned int size = vertices.size();
+    world.physicsSystem.addModelCollider(vertices.data(), &size, 1, Transform{});
+
+    world.addCharacter(glm::vec3{0.0f});
+
+    world.physics[0].velocity = glm::vec3{1.0f, 0.0f, 1.0f};
+    world.step(1.0f / 60.0f);
+
+    REQUIRE(world.transforms[0].position.x < 0.5f);
+    REQUIRE(world.transforms[0].position.z == Approx(1.0f).margin(0.01f));
+}
+
+TEST_CASE( "PhysicsSystem: Idle characters need one query", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+
+    static constexpr size_t n = 100;
+    for (size_t i = 0; i < n; ++i) {
+        world.addCharacter(glm::vec3{float(i % 10) * 2.0f, 0.0f, float(i / 10) * 2.0f});
+    }
+
+    // let the characters settle on the floor
+    for (int i = 0; i < 10; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    world.step(1.0f / 60.0f);
+
+    PhysicsStatistics const & statistics = world.physicsSystem.getStatistics();
+    REQUIRE(statistics.characterQueries == n);
+    REQUIRE(statistics.sweepIterations <= n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(world.physics[i].isGrounded);
+    }
+}
+
+TEST_CASE( "PhysicsSystem: Resting characters fall asleep and wake on input", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+    world.addCharacter(glm::vec3{5.0f, 0.0f, 0.0f});
+
+    for (int i = 0; i < 60; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.physics[0].isAsleep);
+    REQUIRE(world.physics[1].isAsleep);
+    REQUIRE(world.physicsSystem.getStatistics().asleepCharacters == 2);
+    REQUIRE(world.physicsSystem.getStatistics().characterQueries == 0);
+
+    glm::vec3 position = world.transforms[0].position;
+    world.step(1.0f / 60.0f);
+    REQUIRE(world.transforms[0].position == position);
+
+    world.physics[0].movementVector = glm::vec3{0.1f, 0.0f, 0.0f};
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[0].isAsleep);
+    REQUIRE(world.physics[1].isAsleep);
+    REQUIRE(world.physicsSystem.getStatistics().awakeCharacters == 1);
+    REQUIRE(world.physicsSystem.getStatistics().asleepCharacters == 1);
+    REQUIRE(world.transforms[0].position.x > position.x);
+}
+
+TEST_CASE( "PhysicsSystem: Contact wakes sleeping character", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+    world.addCharacter(glm::vec3{2.0f, 0.0f, 0.0f});
+
+    for (int i = 0; i < 60; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.physics[1].isAsleep);
+
+    for (int i = 0; i < 30 && world.physics[1].isAsleep; ++i) {
+        world.physics[0].movementVector = glm::vec3{0.1f, 0.0f, 0.0f};
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(!world.physics[1].isAsleep);
+}
+
+TEST_CASE( "PhysicsSystem: Moving collider wakes sleeping character", "[physics_system]") {
+    CharacterWorld world;
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 10.0f);
+    unsigned int size = vertices.size();
+    ColliderTag platform = world.physicsSystem.addModelCollider(vertices.data(), &size, 1, Transform{});
+
+    world.addCharacter(glm::vec3{0.0f});
+
+    for (int i = 0; i < 60; ++i) {
+        world.physicsSystem.updateModelColliders(&platform, nullptr, 0);
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.physics[0].isAsleep);
+
+    // lower the platform from under the character
+    Transform transform;
+    transform.position.y = -1.0f;
+    world.physicsSystem.updateModelColliders(&platform, &transform, 1);
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[0].isAsleep);
+
+    for (int i = 0; i < 60; ++i) {
+        world.physicsSystem.updateModelColliders(&platform, nullptr, 0);
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.transforms[0].position.y == Approx(-1.0f).margin(0.01f));
+}
+
+TEST_CASE( "PhysicsSystem: Removing collider wakes sleeping character", "[physics_system]") {
+    CharacterWorld world;
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 10.0f);
+    unsigned int size = vertices.size();
+    ColliderTag floor = world.physicsSystem.addModelCollider(vertices.data(), &size, 1, Transform{});
+    float heights[4] = { -2.0f, -2.0f, -2.0f, -2.0f };
+    ColliderTag ground = world.physicsSystem.addHeightfieldCollider(heights, 2, 2, 20.0f, glm::vec3{-10.0f, 0.0f, -10.0f});
+
+    world.addCharacter(glm::vec3{0.0f});
+    for (int i = 0; i < 60; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.physics[0].isAsleep);
+
+    world.physicsSystem.removeCollider(floor);
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[0].isAsleep);
+    for (int i = 0; i < 120; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.transforms[0].position.y == Approx(-2.0f).margin(0.01f));
+    REQUIRE(world.physics[0].isAsleep);
+
+    world.physicsSystem.removeCollider(ground);
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[0].isAsleep);
+}
+
+TEST_CASE( "PhysicsSystem: Moving sleeping character wakes it", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+    world.addCharacter(glm::vec3{5.0f, 0.0f, 0.0f});
+
+    for (int i = 0; i < 60; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.physics[0].isAsleep);
+    REQUIRE(world.physics[1].isAsleep);
+
+    // the transform is set directly, as by a script
+    world.transforms[0].position.y = 2.0f;
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[0].isAsleep);
+    REQUIRE(world.physics[1].isAsleep);
+    REQUIRE(world.transforms[0].position.y < 2.0f);
+
+    // the transform is set along with the collider, as by the editor
+    world.transforms[1].position = glm::vec3{10.0f, 2.0f, 0.0f};
+    world.physicsSystem.updateCapsuleColliders(&world.physics[1].colliderTag, &world.transforms[1], 1);
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[1].isAsleep);
+    REQUIRE(world.transforms[1].position.y < 2.0f);
+
+    for (int i = 0; i < 120; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        REQUIRE(world.transforms[i].position.y == Approx(0.0f).margin(0.01f));
+        REQUIRE(world.physics[i].isAsleep);
+    }
+    REQUIRE(world.transforms[1].position.x == Approx(10.0f));
+}
+
+TEST_CASE( "PhysicsSystem: Sleeping characters keep their contacts", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+
+    CollisionSystem const & collisionSystem = world.physicsSystem.getCollisionSystem();
+    EntityID a = world.entityIDs[0];
+
+    world.step(1.0f / 60.0f);
+    REQUIRE(!collisionSystem.queryCollision(a).empty());
+    for (int i = 0; i < 60; ++i) {
+        world.step(1.0f / 60.0f);
+        REQUIRE(!collisionSystem.queryCollision(a).empty());
+        REQUIRE(collisionSystem.queryCollisionExit(a).empty());
+    }
+    REQUIRE(world.physics[0].isAsleep);
+
+    // waking up does not begin the contact again
+    world.physics[0].movementVector = glm::vec3{0.01f, 0.0f, 0.0f};
+    world.step(1.0f / 60.0f);
+    REQUIRE(!world.physics[0].isAsleep);
+    REQUIRE(!collisionSystem.queryCollision(a).empty());
+    REQUIRE(collisionSystem.queryCollisionEntry(a).empty());
+}
+
+TEST_CASE( "PhysicsSystem: Removing model collider keeps other colliders intact", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+
+    // three floors stacked at different heights
+    prt::vector<ColliderTag> tags;
+    for (int i = 0; i < 3; ++i) {
+        prt::vector<glm::vec3> vertices;
+        addQuad(vertices, glm::vec3{10.0f * i, 0.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+        addQuad(vertices, glm::vec3{10.0f * i, 1.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+        unsigned int sizes[2] = { 6, 6 };
+        tags.push_back(physicsSystem.addModelCollider(vertices.data(), sizes, 2, Transform{}));
+    }
+
+    physicsSystem.removeCollider(tags[1]);
+
+    glm::vec3 down{0.0f, -1.0f, 0.0f};
+    glm::vec3 hit;
+    REQUIRE(physicsSystem.raycast(glm::vec3{0.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+    REQUIRE(hit.y == Approx(1.0f));
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{10.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+    REQUIRE(physicsSystem.raycast(glm::vec3{20.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+    REQUIRE(hit.y == Approx(1.0f));
+
+    // moving the remaining models still moves all of their meshes
+    Transform transforms[2];
+    transforms[0].position.y = 2.0f;
+    transforms[1].position.y = 4.0f;
+    ColliderTag remaining[2] = { tags[0], tags[2] };
+    physicsSystem.updateModelColliders(remaining, transforms, 2);
+    REQUIRE(physicsSystem.raycast(glm::vec3{0.0f, 10.0f, 0.0f}, down, 20.0f, hit));
+    REQUIRE(hit.y == Approx(3.0f));
+    REQUIRE(physicsSystem.raycast(glm::vec3{20.0f, 10.0f, 0.0f}, down, 20.0f, hit));
+    REQUIRE(hit.y == Approx(5.0f));
+
+    // the freed slot is reused
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{10.0f, -1.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+    unsigned int size = vertices.size();
+    ColliderTag tag = physicsSystem.addModelCollider(vertices.data(), &size, 1, Transform{});
+    REQUIRE(tag.index == tags[1].index);
+    REQUIRE(physicsSystem.raycast(glm::vec3{10.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+    REQUIRE(hit.y == Approx(-1.0f));
+}
+
+TEST_CASE( "PhysicsSystem: Collapsed meshes leave the tree valid", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+    PhysicsSystem reference;
+
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+    addQuad(vertices, glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+
+    // the middle mesh was simplified away
+    unsigned int sizes[3] = { 6, 0, 6 };
+    ColliderTag tag = physicsSystem.addModelCollider(vertices.data(), sizes, 3, Transform{});
+    unsigned int collapsed = 0;
+    ColliderTag empty = physicsSystem.addModelCollider(vertices.data(), &collapsed, 1, Transform{});
+    unsigned int referenceSizes[2] = { 6, 6 };
+    reference.addModelCollider(vertices.data(), referenceSizes, 2, Transform{});
+
+    REQUIRE(std::isfinite(physicsSystem.getTreeCost()));
+    REQUIRE(physicsSystem.getTreeCost() == Approx(reference.getTreeCost()));
+
+    glm::vec3 down{0.0f, -1.0f, 0.0f};
+    glm::vec3 hit;
+    REQUIRE(physicsSystem.raycast(glm::vec3{0.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+    REQUIRE(hit.y == Approx(1.0f));
+
+    Transform transforms[2];
+    transforms[0].position.y = 2.0f;
+    ColliderTag tags[2] = { tag, empty };
+    physicsSystem.updateModelColliders(tags, transforms, 2);
+    REQUIRE(std::isfinite(physicsSystem.getTreeCost()));
+    REQUIRE(physicsSystem.raycast(glm::vec3{0.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+    REQUIRE(hit.y == Approx(3.0f));
+
+    physicsSystem.removeCollider(empty);
+    physicsSystem.removeCollider(tag);
+    REQUIRE(physicsSystem.getTreeCost() == 0.0f);
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{0.0f, 5.0f, 0.0f}, down, 10.0f, hit));
+}
+
+TEST_CASE( "PhysicsSystem: Raycasts return the closest of overlapping colliders", "[physics_system]") {
+    // a slope rising from y = 0 at x = -2 to y = 4 at x = 2,
+    // its aabb is entered first but hit second at x = 0
+    prt::vector<glm::vec3> slope = { { -2.0f, 0.0f, -2.0f }, { -2.0f, 0.0f, 2.0f }, { 2.0f, 4.0f, -2.0f },
+                                     { -2.0f, 0.0f,  2.0f }, {  2.0f, 4.0f, 2.0f }, { 2.0f, 4.0f, -2.0f } };
+    prt::vector<glm::vec3> ledge;
+    addQuad(ledge, glm::vec3{0.0f, 2.5f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 0.5f);
+    prt::vector<glm::vec3> floor;
+    addQuad(floor, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 10.0f);
+    float ground[4] = { -0.5f, -0.5f, -0.5f, -0.5f };
+
+    glm::vec3 const down{0.0f, -1.0f, 0.0f};
+    // origins of the rays and the heights they hit
+    glm::vec3 const origins[4] = { { 0.0f, 10.0f, 0.0f }, { 1.0f, 10.0f, 0.0f }, 
+                                   { -1.0f, 10.0f, 0.0f }, { 5.0f, 10.0f, 0.0f } };
+    float const heights[4] = { 2.5f, 3.0f, 1.0f, 0.0f };
+
+    // add the colliders in every order
+    int order[4] = { 0, 1, 2, 3 };
+    do {
+        PhysicsSystem physicsSystem;
+        for (int collider : order) {
+            switch (collider) {
+                case 0: {
+                    unsigned int size = slope.size();
+                    physicsSystem.addModelCollider(slope.data(), &size, 1, Transform{});
+                    break;
+                }
+                case 1: {
+                    unsigned int size = ledge.size();
+                    physicsSystem.addModelCollider(ledge.data(), &size, 1, Transform{});
+                    break;
+                }
+                case 2: {
+                    unsigned int size = floor.size();
+                    physicsSystem.addModelCollider(floor.data(), &size, 1, Transform{});
+                    break;
+                }
+                default:
+                    physicsSystem.addHeightfieldCollider(ground, 2, 2, 20.0f, glm::vec3{-10.0f, 0.0f, -10.0f});
+            }
+        }
+
+        for (size_t i = 0; i < 4; ++i) {
+            glm::vec3 hit;
+            REQUIRE(physicsSystem.raycast(origins[i], down, 20.0f, hit));
+            REQUIRE(hit.y == Approx(heights[i]).margin(0.001f));
+        }
+    } while (std::next_permutation(order, order + 4));
+}
+
+TEST_CASE( "PhysicsSystem: Raycast any hit", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 10.0f);
+    addQuad(vertices, glm::vec3{0.0f, 5.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+    unsigned int sizes[2] = { 6, 6 };
+    physicsSystem.addModelCollider(vertices.data(), sizes, 2, Transform{});
+    float ground[4] = { -5.0f, -5.0f, -5.0f, -5.0f };
+    physicsSystem.addHeightfieldCollider(ground, 2, 2, 40.0f, glm::vec3{-20.0f, 0.0f, -20.0f});
+
+    glm::vec3 const down{0.0f, -1.0f, 0.0f};
+    // hits at distance 5, 10 and 15
+    REQUIRE(physicsSystem.raycastAny(glm::vec3{0.0f, 10.0f, 0.0f}, down, 20.0f));
+    REQUIRE(physicsSystem.raycastAny(glm::vec3{5.0f, 10.0f, 0.0f}, down, 20.0f));
+    REQUIRE(physicsSystem.raycastAny(glm::vec3{15.0f, 10.0f, 0.0f}, down, 20.0f));
+
+    // hits beyond the max distance do not count
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{0.0f, 10.0f, 0.0f}, down, 4.9f));
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{5.0f, 10.0f, 0.0f}, down, 9.9f));
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{15.0f, 10.0f, 0.0f}, down, 14.9f));
+    REQUIRE(physicsSystem.raycastAny(glm::vec3{15.0f, 10.0f, 0.0f}, down, 15.1f));
+
+    // misses
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{0.0f, 10.0f, 0.0f}, -down, 20.0f));
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{30.0f, 10.0f, 0.0f}, down, 20.0f));
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{0.0f, 10.0f, 0.0f}, glm::vec3{1.0f, 0.0f, 0.0f}, 20.0f));
+
+    // agrees with raycast
+    glm::vec3 hit;
+    REQUIRE(physicsSystem.raycast(glm::vec3{0.0f, 10.0f, 0.0f}, down, 20.0f, hit));
+    REQUIRE(hit.y == Approx(5.0f));
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{0.0f, 10.0f, 0.0f}, down, 4.9f, hit));
+}
+
+TEST_CASE( "PhysicsSystem: Repeated add and remove of model colliders", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+
+    constexpr int n = 16;
+    ColliderTag tags[n];
+    bool alive[n];
+    auto add = [&](int i) {
+        prt::vector<glm::vec3> vertices;
+        // varying number of meshes per model
+        prt::vector<unsigned int> sizes;
+        for (int j = 0; j <= i % 3; ++j) {
+            addQuad(vertices, glm::vec3{4.0f * i, float(j), 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 1.0f);
+            sizes.push_back(6);
+        }
+        tags[i] = physicsSystem.addModelCollider(vertices.data(), sizes.data(), sizes.size(), Transform{});
+        alive[i] = true;
+    };
+    for (int i = 0; i < n; ++i) {
+        add(i);
+    }
+
+    glm::vec3 hit;
+    for (int round = 0; round < 8; ++round) {
+        for (int i = round % 3; i < n; i += 3) {
+            if (alive[i]) {
+                physicsSystem.removeCollider(tags[i]);
+                alive[i] = false;
+            } else {
+                add(i);
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            bool isHit = physicsSystem.raycast(glm::vec3{4.0f * i, 5.0f, 0.0f}, 
+                                               glm::vec3{0.0f, -1.0f, 0.0f}, 10.0f, hit);
+            REQUIRE(isHit == alive[i]);
+            if (isHit) {
+                REQUIRE(hit.y == Approx(float(i % 3)));
+            }
+        }
+    }
+}
+
+TEST_CASE( "PhysicsSystem: More than 65535 mesh colliders", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+
+    // one small triangle per mesh on a grid
+    constexpr unsigned int side = 260;
+    prt::vector<glm::vec3> vertices;
+    prt::vector<unsigned int> sizes;
+    for (unsigned int x = 0; x < side; ++x) {
+        for (unsigned int z = 0; z < side; ++z) {
+            glm::vec3 corner{float(x), 0.0f, float(z)};
+            vertices.push_back(corner);
+            vertices.push_back(corner + glm::vec3{0.0f, 0.0f, 0.5f});
+            vertices.push_back(corner + glm::vec3{0.5f, 0.0f, 0.0f});
+            sizes.push_back(3);
+        }
+    }
+    REQUIRE(sizes.size() > 65535);
+    physicsSystem.addModelCollider(vertices.data(), sizes.data(), sizes.size(), Transform{});
+
+    glm::vec3 hit;
+    REQUIRE(physicsSystem.raycast(glm::vec3{side - 1 + 0.1f, 1.0f, side - 1 + 0.1f}, 
+                                  glm::vec3{0.0f, -1.0f, 0.0f}, 2.0f, hit));
+    REQUIRE(hit.x == Approx(side - 1 + 0.1f));
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{side - 1 + 0.9f, 1.0f, side - 1 + 0.9f}, 
+                                        glm::vec3{0.0f, -1.0f, 0.0f}, 2.0f, hit));
+}
+
+TEST_CASE( "PhysicsSystem: Removing capsule collider", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+    world.addCharacter(glm::vec3{5.0f, 0.0f, 0.0f});
+
+    ColliderTag removed = world.physics[0].colliderTag;
+    world.physicsSystem.removeCollider(removed);
+    world.physics.remove(0, 1);
+    world.transforms.remove(0, 1);
+    world.entityIDs.remove(0, 1);
+
+    // a new capsule reuses the slot 
+    world.addCharacter(glm::vec3{0.0f, 0.0f, 5.0f});
+    REQUIRE(world.physics.back().colliderTag.index == removed.index);
+
+    for (int i = 0; i < 10; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.transforms[0].position.x == Approx(5.0f));
+    REQUIRE(world.transforms[1].position.z == Approx(5.0f));
+}
+
+TEST_CASE( "PhysicsSystem: Collision entry and exit events", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+    world.addCharacter(glm::vec3{3.0f, 0.0f, 0.0f});
+
+    CollisionSystem const & collisionSystem = world.physicsSystem.getCollisionSystem();
+    EntityID a = world.entityIDs[0];
+    EntityID b = world.entityIDs[1];
+
+    auto contains = [](CollisionSpan span, EntityID other) {
+        for (CollisionEntry const & entry : span) {
+            if (entry.result.other == other) return true;
+        }
+        return false;
+    };
+
+    // walk a into b
+    int frame = 0;
+    while (!contains(collisionSystem.queryCollision(a), b)) {
+        REQUIRE(frame < 200);
+        world.physics[0].velocity.x = 0.05f;
+        world.step(1.0f / 60.0f);
+        ++frame;
+    }
+    REQUIRE(contains(collisionSystem.queryCollisionEntry(a), b));
+    REQUIRE(contains(collisionSystem.queryCollisionEntry(b), a));
+    REQUIRE(collisionSystem.queryCollisionExit(a).empty());
+
+    // entries are sorted and unique per pair
+    CollisionSpan span = collisionSystem.queryCollision(a);
+    for (CollisionEntry const * it = span.begin(); it + 1 < span.end(); ++it) {
+        REQUIRE(it->entity == a);
+        REQUIRE(it->result.other < (it + 1)->result.other);
+    }
+
+    // keep pushing, the contact persists without a new entry
+    world.physics[0].velocity.x = 0.05f;
+    world.step(1.0f / 60.0f);
+    REQUIRE(contains(collisionSystem.queryCollision(a), b));
+    REQUIRE_FALSE(contains(collisionSystem.queryCollisionEntry(a), b));
+
+    // walk away
+    for (int i = 0; i < 10; ++i) {
+        world.physics[0].velocity.x = -0.1f;
+        world.step(1.0f / 60.0f);
+        if (contains(collisionSystem.queryCollisionExit(a), b)) {
+            REQUIRE(contains(collisionSystem.queryCollisionExit(b), a));
+            REQUIRE_FALSE(contains(collisionSystem.queryCollision(a), b));
+            return;
+        }
+    }
+    FAIL("Collision never ended");
+}
+
+TEST_CASE( "PhysicsSystem: Trigger enter and exit events", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+
+    Transform transform{};
+    transform.position = glm::vec3{3.0f, 0.0f, 0.0f};
+    ColliderTag box = world.physicsSystem.addBoxTrigger(glm::vec3{0.5f}, glm::vec3{0.0f, 0.5f, 0.0f}, transform);
+    transform.position = glm::vec3{6.0f, 0.0f, 0.0f};
+    ColliderTag sphere = world.physicsSystem.addSphereTrigger(0.5f, glm::vec3{0.0f, 0.5f, 0.0f}, transform);
+    transform.position = glm::vec3{9.0f, 0.0f, 0.0f};
+    ColliderTag capsule = world.physicsSystem.addCapsuleTrigger(1.0f, 0.5f, glm::vec3{0.0f}, transform);
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{12.0f, 0.5f, 0.0f}, glm::vec3{-1.0f, 0.0f, 0.0f}, 0.5f);
+    ColliderTag mesh = world.physicsSystem.addMeshTrigger(vertices.data(), vertices.size(), Transform{});
+
+    ColliderTag expected[4] = { box, sphere, capsule, mesh };
+    unsigned int entered = 0;
+    unsigned int exited = 0;
+    for (int i = 0; i < 300 && exited < 4; ++i) {
+        world.physics[0].velocity.x = 0.05f;
+        world.step(1.0f / 60.0f);
+
+        PhysicsSystem const & physicsSystem = world.physicsSystem;
+        for (TriggerOverlap const & overlap : physicsSystem.getTriggerEnterEvents()) {
+            REQUIRE(entered < 4);
+            REQUIRE(overlap.trigger == expected[entered]);
+            REQUIRE(overlap.entity == world.entityIDs[0]);
+            ++entered;
+        }
+        for (TriggerOverlap const & overlap : physicsSystem.getTriggerExitEvents()) {
+            REQUIRE(exited < entered);
+            REQUIRE(overlap.trigger == expected[exited]);
+            ++exited;
+        }
+        REQUIRE(physicsSystem.getTriggerOverlaps().size() == entered - exited);
+    }
+    REQUIRE(entered == 4);
+    REQUIRE(exited == 4);
+    // triggers do not block the character
+    REQUIRE(world.transforms[0].position.x > 12.0f);
+}
+
+TEST_CASE( "PhysicsSystem: Moving and removing triggers", "[physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+    world.addCharacter(glm::vec3{0.0f});
+
+    Transform transform{};
+    transform.position = glm::vec3{0.0f, 0.0f, 5.0f};
+    ColliderTag tag = world.physicsSystem.addSphereTrigger(1.0f, glm::vec3{0.0f}, transform);
+
+    world.step(1.0f / 60.0f);
+    REQUIRE(world.physicsSystem.getTriggerOverlaps().empty());
+
+    // trigger moved onto a sleeping character
+    for (int i = 0; i < 40; ++i) {
+        world.step(1.0f / 60.0f);
+    }
+    REQUIRE(world.physics[0].isAsleep);
+
+    transform.position = glm::vec3{0.0f, 1.0f, 1.2f};
+    world.physicsSystem.updateTriggers(&tag, &transform, 1);
+    world.step(1.0f / 60.0f);
+    REQUIRE(world.physicsSystem.getTriggerEnterEvents().size() == 1);
+    REQUIRE(world.physicsSystem.getTriggerOverlaps().size() == 1);
+    world.step(1.0f / 60.0f);
+    REQUIRE(world.physicsSystem.getTriggerEnterEvents().empty());
+    REQUIRE(world.physicsSystem.getTriggerOverlaps().size() == 1);
+
+    world.physicsSystem.removeCollider(tag);
+    world.step(1.0f / 60.0f);
+    REQUIRE(world.physicsSystem.getTriggerOverlaps().empty());
+    REQUIRE(world.physicsSystem.getTriggerExitEvents().empty());
+
+    // rotated box trigger overlapping the capsule's side
+    transform.position = glm::vec3{1.2f, 0.5f, 0.0f};
+    transform.rotation = glm::angleAxis(glm::radians(45.0f), glm::vec3{0.0f, 1.0f, 0.0f});
+    world.physicsSystem.addBoxTrigger(glm::vec3{0.5f}, glm::vec3{0.0f}, transform);
+    world.step(1.0f / 60.0f);
+    REQUIRE(world.physicsSystem.getTriggerEnterEvents().size() == 1);
+}
+
+TEST_CASE( "PhysicsSystem: Heightfield raycasts match mesh raycasts", "[physics_system]") {
+    constexpr unsigned int size = 33;
+    constexpr float cellSize = 0.5f;
+
+    PhysicsSystem heightfieldSystem;
+    prt::vector<float> heights = terrainHeights(size, cellSize);
+    heightfieldSystem.addHeightfieldCollider(heights.data(), size, size, cellSize, glm::vec3{0.0f});
+
+    PhysicsSystem meshSystem;
+    prt::vector<glm::vec3> vertices;
+    prt::vector<unsigned int> meshSizes;
+    terrainMesh(size, cellSize, 8, vertices, meshSizes);
+    meshSystem.addModelCollider(vertices.data(), meshSizes.data(), meshSizes.size(), Transform{});
+
+    PhysicsSystem bakedSystem;
+    bakedSystem.addHeightfieldCollider(vertices.data(), vertices.size(), cellSize, Transform{});
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> position(-2.0f, (size - 1) * cellSize + 2.0f);
+    std::uniform_real_distribution<float> height(3.0f, 6.0f);
+    std::uniform_real_distribution<float> horizontal(-1.0f, 1.0f);
+    unsigned int hits = 0;
+    for (int i = 0; i < 500; ++i) {
+        glm::vec3 origin{position(generator), height(generator), position(generator)};
+        // steep and shallow rays, the latter cross many cells
+        glm::vec3 direction = glm::normalize(glm::vec3{horizontal(generator), 
+                                                       i % 2 ? -1.0f : -0.1f, 
+                                                       horizontal(generator)});
+        glm::vec3 meshHit;
+        glm::vec3 heightfieldHit;
+        glm::vec3 bakedHit;
+        bool meshIntersect = meshSystem.raycast(origin, direction, 100.0f, meshHit);
+        bool heightfieldIntersect = heightfieldSystem.raycast(origin, direction, 100.0f, heightfieldHit);
+        bool bakedIntersect = bakedSystem.raycast(origin, direction, 100.0f, bakedHit);
+        REQUIRE(heightfieldIntersect == meshIntersect);
+        REQUIRE(bakedIntersect == meshIntersect);
+        REQUIRE(heightfieldSystem.raycastAny(origin, direction, 100.0f) == meshIntersect);
+        if (meshIntersect) {
+            ++hits;
+            // heights are quantized
+            REQUIRE(glm::distance(heightfieldHit, meshHit) < 0.01f);
+            REQUIRE(glm::distance(bakedHit, meshHit) < 0.01f);
+        }
+    }
+    REQUIRE(hits > 100);
+}
+
+TEST_CASE( "PhysicsSystem: Sphere and capsule casts", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+    prt::vector<glm::vec3> vertices;
+    addQuad(vertices, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f}, 10.0f);
+    // wall at x = 5, facing the origin
+    addQuad(vertices, glm::vec3{5.0f, 0.0f, 0.0f}, glm::vec3{-1.0f, 0.0f, 0.0f}, 10.0f);
+    unsigned int sizes[2] = { 6, 6 };
+    physicsSystem.addModelCollider(vertices.data(), sizes, 2, Transform{});
+
+    glm::vec3 const down{0.0f, -1.0f, 0.0f};
+    glm::vec3 const right{1.0f, 0.0f, 0.0f};
+    ShapeCastResult result;
+
+    REQUIRE(physicsSystem.sphereCast(glm::vec3{0.0f, 5.0f, 0.0f}, 0.5f, down, 10.0f, result));
+    REQUIRE(result.hit);
+    REQUIRE(result.distance == Approx(4.5f).margin(0.001f));
+    REQUIRE(result.normal.y == Approx(1.0f).margin(0.001f));
+    REQUIRE(result.point.y == Approx(0.0f).margin(0.001f));
+    REQUIRE(result.tag.shape == COLLIDER_SHAPE_MESH);
+
+    // the wall is closer than the floor
+    REQUIRE(physicsSystem.capsuleCast(glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec3{0.0f, 2.0f, 0.0f}, 0.5f,
+                                      glm::normalize(glm::vec3{1.0f, -0.1f, 0.0f}), 10.0f, result));
+    REQUIRE(result.normal.x == Approx(-1.0f).margin(0.001f));
+    REQUIRE(result.point.x == Approx(5.0f).margin(0.001f));
+    REQUIRE(result.distance == Approx(4.5f / glm::normalize(glm::vec3{1.0f, -0.1f, 0.0f}).x).margin(0.001f));
+
+    // clean misses, also when sliding along the floor
+    REQUIRE_FALSE(physicsSystem.sphereCast(glm::vec3{0.0f, 5.0f, 0.0f}, 0.5f, -down, 10.0f, result));
+    REQUIRE_FALSE(result.hit);
+    REQUIRE_FALSE(physicsSystem.sphereCast(glm::vec3{20.0f, 5.0f, 0.0f}, 0.5f, down, 10.0f, result));
+    REQUIRE_FALSE(physicsSystem.capsuleCast(glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec3{0.0f, 2.0f, 0.0f}, 0.5f,
+                                            glm::vec3{0.0f, 0.0f, 1.0f}, 5.0f, result));
+
+    // hits beyond the max distance are rejected
+    REQUIRE_FALSE(physicsSystem.sphereCast(glm::vec3{0.0f, 5.0f, 0.0f}, 0.5f, down, 4.4f, result));
+    REQUIRE_FALSE(physicsSystem.capsuleCast(glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec3{0.0f, 2.0f, 0.0f}, 0.5f,
+                                            right, 4.4f, result));
+    REQUIRE(physicsSystem.capsuleCast(glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec3{0.0f, 2.0f, 0.0f}, 0.5f,
+                                      right, 4.6f, result));
+    REQUIRE(result.distance == Approx(4.5f).margin(0.001f));
+
+    // casts that start overlapping hit at once, unless moving away
+    REQUIRE(physicsSystem.sphereCast(glm::vec3{0.0f, 0.25f, 0.0f}, 0.5f, down, 10.0f, result));
+    REQUIRE(result.distance == 0.0f);
+    REQUIRE(result.normal.y == Approx(1.0f).margin(0.001f));
+    REQUIRE(physicsSystem.capsuleCast(glm::vec3{4.75f, 1.0f, 0.0f}, glm::vec3{4.75f, 2.0f, 0.0f}, 0.5f,
+                                      right, 10.0f, result));
+    REQUIRE(result.distance == 0.0f);
+    REQUIRE_FALSE(physicsSystem.sphereCast(glm::vec3{0.0f, 0.25f, 0.0f}, 0.5f, -down, 10.0f, result));
+}
+
+TEST_CASE( "PhysicsSystem: Batched casts match single casts", "[physics_system]") {
+    constexpr unsigned int size = 33;
+    constexpr float cellSize = 0.5f;
+
+    PhysicsSystem physicsSystem;
+    prt::vector<glm::vec3> vertices;
+    prt::vector<unsigned int> meshSizes;
+    terrainMesh(size, cellSize, 8, vertices, meshSizes);
+    physicsSystem.addModelCollider(vertices.data(), meshSizes.data(), meshSizes.size(), Transform{});
+
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<float> position(-2.0f, (size - 1) * cellSize + 2.0f);
+    std::uniform_real_distribution<float> height(3.0f, 6.0f);
+    std::uniform_real_distribution<float> horizontal(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> distance(1.0f, 10.0f);
+
+    constexpr size_t n = 200;
+    prt::vector<SphereCastQuery> sphereQueries;
+    prt::vector<CapsuleCastQuery> capsuleQueries;
+    for (size_t i = 0; i < n; ++i) {
+        glm::vec3 origin{position(generator), height(generator), position(generator)};
+        glm::vec3 direction = glm::normalize(glm::vec3{horizontal(generator), -1.0f, horizontal(generator)});
+        float maxDistance = distance(generator);
+        sphereQueries.push_back({ origin, 0.5f, direction, maxDistance });
+        capsuleQueries.push_back({ origin, origin + glm::vec3{0.0f, 1.0f, 0.0f}, 0.5f, direction, maxDistance });
+    }
+
+    prt::vector<ShapeCastResult> sphereResults;
+    prt::vector<ShapeCastResult> capsuleResults;
+    sphereResults.resize(n);
+    capsuleResults.resize(n);
+    physicsSystem.sphereCast(sphereQueries.data(), sphereResults.data(), n);
+    physicsSystem.capsuleCast(capsuleQueries.data(), capsuleResults.data(), n);
+
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    for (size_t i = 0; i < n; ++i) {
+        SphereCastQuery const & sq = sphereQueries[i];
+        ShapeCastResult sphere;
+        REQUIRE(physicsSystem.sphereCast(sq.origin, sq.radius, sq.direction, sq.maxDistance, sphere) == sphereResults[i].hit);
+        CapsuleCastQuery const & cq = capsuleQueries[i];
+        ShapeCastResult capsule;
+        REQUIRE(physicsSystem.capsuleCast(cq.a, cq.b, cq.radius, cq.direction, cq.maxDistance, capsule) == capsuleResults[i].hit);
+
+        if (sphere.hit) {
+            ++hits;
+            REQUIRE(sphere.distance == sphereResults[i].distance);
+            REQUIRE(sphere.distance <= sq.maxDistance);
+            REQUIRE(sphere.normal == sphereResults[i].normal);
+        } else {
+            ++misses;
+        }
+        if (capsule.hit) {
+            REQUIRE(capsule.distance == capsuleResults[i].distance);
+            REQUIRE(capsule.normal == capsuleResults[i].normal);
+            // the capsule reaches the terrain no later than its bottom sphere
+            REQUIRE((!sphere.hit || capsule.distance <= sphere.distance + 0.001f));
+        }
+    }
+    REQUIRE(hits > 20);
+    REQUIRE(misses > 20);
+}
+
+TEST_CASE( "PhysicsSystem: Heightfield casts match mesh casts", "[physics_system]") {
+    constexpr unsigned int size = 33;
+    constexpr float cellSize = 0.5f;
+
+    PhysicsSystem heightfieldSystem;
+    prt::vector<float> heights = terrainHeights(size, cellSize);
+    heightfieldSystem.addHeightfieldCollider(heights.data(), size, size, cellSize, glm::vec3{0.0f});
+
+    PhysicsSystem meshSystem;
+    prt::vector<glm::vec3> vertices;
+    prt::vector<unsigned int> meshSizes;
+    terrainMesh(size, cellSize, 8, vertices, meshSizes);
+    meshSystem.addModelCollider(vertices.data(), meshSizes.data(), meshSizes.size(), Transform{});
+
+    std::mt19937 generator(13);
+    std::uniform_real_distribution<float> position(-2.0f, (size - 1) * cellSize + 2.0f);
+    std::uniform_real_distribution<float> height(3.0f, 6.0f);
+    std::uniform_real_distribution<float> horizontal(-1.0f, 1.0f);
+    unsigned int hits = 0;
+    for (int i = 0; i < 300; ++i) {
+        glm::vec3 a{position(generator), height(generator), position(generator)};
+        glm::vec3 b = a + glm::vec3{0.0f, 1.0f, 0.0f};
+        glm::vec3 direction = glm::normalize(glm::vec3{horizontal(generator), 
+                                                       i % 2 ? -1.0f : -0.2f, 
+                                                       horizontal(generator)});
+        ShapeCastResult meshResult;
+        ShapeCastResult heightfieldResult;
+        bool meshIntersect = meshSystem.capsuleCast(a, b, 0.3f, direction, 20.0f, meshResult);
+        bool heightfieldIntersect = heightfieldSystem.capsuleCast(a, b, 0.3f, direction, 20.0f, heightfieldResult);
+        REQUIRE(heightfieldIntersect == meshIntersect);
+        if (meshIntersect) {
+            ++hits;
+            REQUIRE(heightfieldResult.tag.shape == COLLIDER_SHAPE_HEIGHTFIELD);
+            // heights are quantized
+            REQUIRE(heightfieldResult.distance == Approx(meshResult.distance).margin(0.01f));
+            REQUIRE(glm::distance(heightfieldResult.point, meshResult.point) < 0.02f);
+        }
+    }
+    REQUIRE(hits > 100);
+
+    // flat ground at y = 1
+    PhysicsSystem physicsSystem;
+    float flat[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    physicsSystem.addHeightfieldCollider(flat, 2, 2, 20.0f, glm::vec3{-10.0f, 0.0f, -10.0f});
+    glm::vec3 const down{0.0f, -1.0f, 0.0f};
+    ShapeCastResult result;
+    REQUIRE(physicsSystem.sphereCast(glm::vec3{0.0f, 5.0f, 0.0f}, 0.5f, down, 10.0f, result));
+    REQUIRE(result.distance == Approx(3.5f).margin(0.001f));
+    REQUIRE(result.normal.y == Approx(1.0f).margin(0.001f));
+    REQUIRE_FALSE(physicsSystem.sphereCast(glm::vec3{0.0f, 5.0f, 0.0f}, 0.5f, down, 3.4f, result));
+    REQUIRE_FALSE(physicsSystem.sphereCast(glm::vec3{20.0f, 5.0f, 0.0f}, 0.5f, down, 10.0f, result));
+    REQUIRE(physicsSystem.sphereCast(glm::vec3{0.0f, 1.25f, 0.0f}, 0.5f, down, 10.0f, result));
+    REQUIRE(result.distance == 0.0f);
+}
+
+TEST_CASE( "PhysicsSystem: Heightfield holes", "[physics_system]") {
+    PhysicsSystem physicsSystem;
+    float const hole = std::numeric_limits<float>::quiet_NaN();
+    float heights[9] = { 0.0f, 0.0f, 0.0f,
+                         0.0f, hole, 0.0f,
+                         0.0f, 0.0f, 0.0f };
+    physicsSystem.addHeightfieldCollider(heights, 3, 3, 1.0f, glm::vec3{0.0f});
+
+    glm::vec3 down{0.0f, -1.0f, 0.0f};
+    glm::vec3 hit;
+    // every cell touches the hole
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{0.5f, 1.0f, 0.5f}, down, 2.0f, hit));
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{1.5f, 1.0f, 1.5f}, down, 2.0f, hit));
+
+    float flat[9] = { 0.0f, 0.0f, 0.0f,
+                      0.0f, 1.0f, 0.0f,
+                      0.0f, 0.0f, 0.0f };
+    PhysicsSystem other;
+    other.addHeightfieldCollider(flat, 3, 3, 1.0f, glm::vec3{10.0f, 0.0f, 0.0f});
+    REQUIRE(other.raycast(glm::vec3{11.0f, 2.0f, 1.0f}, down, 3.0f, hit));
+    REQUIRE(hit.y == Approx(1.0f));
+    REQUIRE_FALSE(other.raycast(glm::vec3{1.0f, 2.0f, 1.0f}, down, 3.0f, hit));
+}
+
+TEST_CASE( "PhysicsSystem: Heightfield raycasts stop at their max distance", "[physics_system]") {
+    constexpr unsigned int size = 33;
+    prt::vector<float> heights;
+    heights.resize(size * size);
+    for (float & height : heights) {
+        height = 1.0f;
+    }
+    // lowers the bounds so that rays below the surface enter them
+    heights[0] = 0.0f;
+    PhysicsSystem physicsSystem;
+    physicsSystem.addHeightfieldCollider(heights.data(), size, size, 1.0f, glm::vec3{0.0f});
+
+    // the ray runs below the surface and misses, only
+    // the three cells that it crosses are tested
+    glm::vec3 hit;
+    uint32_t tests = physicsSystem.getStatistics().raycastTriangleTests;
+    REQUIRE_FALSE(physicsSystem.raycast(glm::vec3{2.5f, 0.5f, 16.5f}, glm::vec3{1.0f, 0.0f, 0.0f}, 2.0f, hit));
+    REQUIRE(physicsSystem.getStatistics().raycastTriangleTests - tests <= 6);
+
+    tests = physicsSystem.getStatistics().raycastTriangleTests;
+    REQUIRE_FALSE(physicsSystem.raycastAny(glm::vec3{16.5f, 0.5f, 2.5f}, glm::normalize(glm::vec3{1.0f, 0.0f, 1.0f}), 1.0f));
+    REQUIRE(physicsSystem.getStatistics().raycastTriangleTests - tests <= 6);
+}
+
+TEST_CASE( "PhysicsSystem: Characters walk on heightfield like on mesh", "[physics_system]") {
+    constexpr unsigned int size = 65;
+    constexpr float cellSize = 0.5f;
+
+    CharacterWorld heightfieldWorld;
+    prt::vector<float> heights = terrainHeights(size, cellSize);
+    heightfieldWorld.physicsSystem.addHeightfieldCollider(heights.data(), size, size, cellSize, glm::vec3{0.0f});
+
+    CharacterWorld meshWorld;
+    prt::vector<glm::vec3> vertices;
+    prt::vector<unsigned int> meshSizes;
+    terrainMesh(size, cellSize, 8, vertices, meshSizes);
+    meshWorld.physicsSystem.addModelCollider(vertices.data(), meshSizes.data(), meshSizes.size(), Transform{});
+
+    glm::vec3 start{2.0f, terrainHeight(2.0f, 10.0f) + 1.0f, 10.0f};
+    heightfieldWorld.addCharacter(start);
+    meshWorld.addCharacter(start);
+
+    for (int i = 0; i < 300; ++i) {
+        heightfieldWorld.physics[0].velocity.x = 0.05f;
+        meshWorld.physics[0].velocity.x = 0.05f;
+        heightfieldWorld.step(1.0f / 60.0f);
+        meshWorld.step(1.0f / 60.0f);
+        glm::vec3 position = heightfieldWorld.transforms[0].position;
+        // the capsule's bottom sphere rests on, but never sinks into the ground
+        REQUIRE(position.y + 0.5f > terrainHeight(position.x, position.z));
+    }
+    REQUIRE(heightfieldWorld.transforms[0].position.x > start.x + 5.0f);
+    REQUIRE(glm::distance(heightfieldWorld.transforms[0].position, meshWorld.transforms[0].position) < 0.05f);
+}
+
+TEST_CASE( "PhysicsSystem: Benchmark heightfield against mesh terrain", "[.][benchmark][physics_system]") {
+    constexpr unsigned int size = 257;
+    constexpr float cellSize = 1.0f;
+    static constexpr size_t n = 100;
+    static constexpr int nFrames = 300;
+
+    for (int useHeightfield = 0; useHeightfield < 2; ++useHeightfield) {
+        CharacterWorld world;
+        size_t bytes;
+        if (useHeightfield) {
+            prt::vector<float> heights = terrainHeights(size, cellSize);
+            world.physicsSystem.addHeightfieldCollider(heights.data(), size, size, cellSize, glm::vec3{0.0f});
+            bytes = size * size * sizeof(uint16_t);
+        } else {
+            prt::vector<glm::vec3> vertices;
+            prt::vector<unsigned int> meshSizes;
+            terrainMesh(size, cellSize, 16, vertices, meshSizes);
+            world.physicsSystem.addModelCollider(vertices.data(), meshSizes.data(), meshSizes.size(), Transform{});
+            // raw vertices and transformed cache
+            bytes = 2 * vertices.size() * sizeof(glm::vec3);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            float x = 20.0f + float(i % 10) * 20.0f;
+            float z = 20.0f + float(i / 10) * 20.0f;
+            world.addCharacter(glm::vec3{x, terrainHeight(x, z) + 0.5f, z});
+        }
+
+        uint64_t triangleTests = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < nFrames; ++frame) {
+            for (size_t i = 0; i < n; ++i) {
+                world.physics[i].movementVector = glm::vec3{0.1f, 0.0f, 0.05f};
+            }
+            world.step(1.0f / 60.0f);
+            triangleTests += world.physicsSystem.getStatistics().triangleTests;
+        }
+        auto end = std::chrono::steady_clock::now();
+        float characterMs = std::chrono::duration<float, std::milli>(end - start).count() / nFrames;
+
+        std::mt19937 generator(3);
+        std::uniform_real_distribution<float> position(0.0f, (size - 1) * cellSize);
+        constexpr int nRays = 10000;
+        glm::vec3 hit;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nRays; ++i) {
+            glm::vec3 origin{position(generator), 10.0f, position(generator)};
+            world.physicsSystem.raycast(origin, glm::normalize(glm::vec3{1.0f, -0.2f, 0.5f}), 100.0f, hit);
+        }
+        end = std::chrono::steady_clock::now();
+        float rayUs = std::chrono::duration<float, std::micro>(end - start).count() / nRays;
+
+        WARN((useHeightfield ? "heightfield" : "mesh") << ": " 
+             << bytes / 1024 << " KiB, "
+             << float(triangleTests) / nFrames << " triangle tests/frame, "
+             << characterMs << " ms/frame, "
+             << rayUs << " us/raycast");
+    }
+}
+
+TEST_CASE( "PhysicsSystem: Benchmark character queries per frame", "[.][benchmark][physics_system]") {
+    CharacterWorld world;
+    world.addFloor(100.0f);
+
+    static constexpr size_t n = 100;
+    static constexpr int nFrames = 600;
+    for (size_t i = 0; i < n; ++i) {
+        world.addCharacter(glm::vec3{float(i % 10) * 2.0f, 0.0f, float(i / 10) * 2.0f});
+    }
+
+    for (int walking = 0; walking < 2; ++walking) {
+        uint64_t queries = 0;
+        uint64_t iterations = 0;
+        uint64_t triangleTests = 0;
+        uint64_t asleep = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < nFrames; ++frame) {
+            for (size_t i = 0; i < n; ++i) {
+                world.physics[i].movementVector = walking ? glm::vec3{0.1f, 0.0f, 0.0f} : glm::vec3{0.0f};
+            }
+            world.step(1.0f / 60.0f);
+
+            PhysicsStatistics const & statistics = world.physicsSystem.getStatistics();
+            queries += statistics.characterQueries;
+            iterations += statistics.sweepIterations;
+            triangleTests += statistics.triangleTests;
+            asleep += statistics.asleepCharacters;
+        }
+        auto end = std::chrono::steady_clock::now();
+        float ms = std::chrono::duration<float, std::milli>(end - start).count();
+
+        // the fixed-substep integrator issued 4 queries per character and frame
+        WARN((walking ? "walking" : "idle") << ": " 
+             << float(queries) / nFrames << " queries/frame (substepping: " << 4 * n << "), "
+             << float(iterations) / nFrames << " sweep iterations/frame, "
+             << float(triangleTests) / nFrames << " triangle tests/frame, "
+             << float(asleep) / nFrames << " asleep/frame, "
+             << ms / nFrames << " ms/frame");
+        REQUIRE(queries <= n * nFrames);
+    }
+}
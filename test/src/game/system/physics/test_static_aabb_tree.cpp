@@ -0,0 +1,211 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/game/system/physics/static_aabb_tree.h"
+#include "src/game/system/physics/aabb_tree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    float random(float min, float max) {
+        return min + (max - min) * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
+    }
+
+    // level-like scene, many small boxes spread over a large area
+    void randomBoxes(size_t n, prt::vector<ColliderTag> & tags, prt::vector<AABB> & aabbs) {
+        for (size_t i = 0; i < n; ++i) {
+            glm::vec3 position = { random(-500.0f, 500.0f), random(-5.0f, 20.0f), random(-500.0f, 500.0f) };
+            glm::vec3 size = { random(0.1f, 4.0f), random(0.1f, 4.0f), random(0.1f, 4.0f) };
+            tags.push_back(ColliderTag{ColliderIndex(i), COLLIDER_SHAPE_MESH, COLLIDER_TYPE_COLLIDE});
+            aabbs.push_back(AABB{position, position + size});
+        }
+    }
+
+    void sortIndices(prt::vector<ColliderTag> const & tags, prt::vector<ColliderIndex> & indices) {
+        indices.resize(0);
+        for (ColliderTag const & tag : tags) {
+            indices.push_back(tag.index);
+        }
+        std::sort(indices.data(), indices.data() + indices.size());
+    }
+}
+
+TEST_CASE( "StaticAABBTree: Queries never miss an intersection", "[static_aabb_tree]") {
+    srand(1);
+    prt::vector<ColliderTag> tags;
+    prt::vector<AABB> aabbs;
+    randomBoxes(2000, tags, aabbs);
+
+    StaticAABBTree tree;
+    tree.build(tags.data(), aabbs.data(), tags.size());
+    REQUIRE(tree.size() == 2000);
+
+    prt::vector<ColliderTag> result;
+    prt::vector<ColliderIndex> found;
+    for (int i = 0; i < 200; ++i) {
+        glm::vec3 position = { random(-520.0f, 520.0f), random(-10.0f, 25.0f), random(-520.0f, 520.0f) };
+        AABB query = { position, position + glm::vec3{ random(0.0f, 30.0f), random(0.0f, 5.0f), random(0.0f, 30.0f) } };
+
+        result.resize(0);
+        tree.query(ColliderTag{}, query, result);
+        sortIndices(result, found);
+
+        for (size_t j = 0; j < aabbs.size(); ++j) {
+            bool hit = std::binary_search(found.data(), found.data() + found.size(), ColliderIndex(j));
+            if (AABB::intersect(aabbs[j], query)) {
+                REQUIRE(hit);
+            } else if (hit) {
+                // false positives only within a quantization step
+                AABB grown = { query.lowerBound - 0.05f, query.upperBound + 0.05f };
+                REQUIRE(AABB::intersect(aabbs[j], grown));
+            }
+        }
+    }
+}
+
+TEST_CASE( "StaticAABBTree: Raycasts visit leaves front to back", "[static_aabb_tree]") {
+    srand(2);
+    prt::vector<ColliderTag> tags;
+    prt::vector<AABB> aabbs;
+    randomBoxes(2000, tags, aabbs);
+
+    StaticAABBTree tree;
+    tree.build(tags.data(), aabbs.data(), tags.size());
+
+    prt::vector<ColliderIndex> visited;
+    prt::vector<ColliderTag> result;
+    prt::vector<ColliderIndex> found;
+    for (int i = 0; i < 200; ++i) {
+        glm::vec3 origin = { random(-500.0f, 500.0f), random(-5.0f, 20.0f), random(-500.0f, 500.0f) };
+        glm::vec3 direction = glm::normalize(glm::vec3{ random(-1.0f, 1.0f), random(-0.2f, 0.2f), random(-1.0f, 1.0f) });
+        float maxDistance = 200.0f;
+
+        visited.resize(0);
+        float lastEntry = 0.0f;
+        tree.raycast(origin, direction, maxDistance, [&](ColliderTag tag, float distance) {
+            float tEntry;
+            AABB const & aabb = aabbs[tag.index];
+            if (AABB::intersectRay(aabb, origin, direction, distance, tEntry)) {
+                // front to back up to the precision of the quantized bounds
+                REQUIRE(tEntry >= lastEntry - 0.1f);
+                lastEntry = std::max(lastEntry, tEntry);
+            }
+            visited.push_back(tag.index);
+            return distance;
+        });
+        std::sort(visited.data(), visited.data() + visited.size());
+
+        result.resize(0);
+        tree.queryRaycast(origin, direction, maxDistance, result);
+        sortIndices(result, found);
+        REQUIRE(found.size() == visited.size());
+
+        for (size_t j = 0; j < aabbs.size(); ++j) {
+            if (AABB::intersectRay(aabbs[j], origin, direction, maxDistance)) {
+                REQUIRE(std::binary_search(visited.data(), visited.data() + visited.size(), ColliderIndex(j)));
+                REQUIRE(std::binary_search(found.data(), found.data() + found.size(), ColliderIndex(j)));
+            }
+        }
+    }
+}
+
+TEST_CASE( "StaticAABBTree: Degenerate input", "[static_aabb_tree]") {
+    StaticAABBTree tree;
+    prt::vector<ColliderTag> result;
+    tree.query(ColliderTag{}, AABB{glm::vec3{-1.0f}, glm::vec3{1.0f}}, result);
+    REQUIRE(result.empty());
+
+    // identical boxes in a flat level
+    prt::vector<ColliderTag> tags;
+    prt::vector<AABB> aabbs;
+    for (ColliderIndex i = 0; i < 100; ++i) {
+        tags.push_back(ColliderTag{i, COLLIDER_SHAPE_MESH, COLLIDER_TYPE_COLLIDE});
+        aabbs.push_back(AABB{glm::vec3{1.0f, 0.0f, 1.0f}, glm::vec3{2.0f, 0.0f, 2.0f}});
+    }
+    tree.build(tags.data(), aabbs.data(), tags.size());
+
+    tree.query(ColliderTag{}, AABB{glm::vec3{1.5f, 0.0f, 1.5f}, glm::vec3{1.5f, 0.0f, 1.5f}}, result);
+    REQUIRE(result.size() == 100);
+
+    result.resize(0);
+    tree.query(ColliderTag{}, AABB{glm::vec3{3.0f, 0.0f, 3.0f}, glm::vec3{4.0f, 1.0f, 4.0f}}, result);
+    REQUIRE(result.empty());
+
+    result.resize(0);
+    tree.queryRaycast(glm::vec3{1.5f, 1.0f, 1.5f}, glm::vec3{0.0f, -1.0f, 0.0f}, 2.0f, result);
+    REQUIRE(result.size() == 100);
+}
+
+TEST_CASE( "StaticAABBTree: Benchmark against dynamic tree", "[.][benchmark][static_aabb_tree]") {
+    srand(3);
+    prt::vector<ColliderTag> tags;
+    prt::vector<AABB> aabbs;
+    randomBoxes(100000, tags, aabbs);
+
+    DynamicAABBTree dynamicTree;
+    prt::vector<int32_t> treeIndices;
+    treeIndices.resize(tags.size());
+    dynamicTree.insert(tags.data(), aabbs.data(), tags.size(), treeIndices.data());
+
+    auto start = std::chrono::steady_clock::now();
+    StaticAABBTree staticTree;
+    staticTree.build(tags.data(), aabbs.data(), tags.size());
+    double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    prt::vector<AABB> queries;
+    for (int i = 0; i < 100000; ++i) {
+        glm::vec3 position = { random(-500.0f, 500.0f), random(-5.0f, 20.0f), random(-500.0f, 500.0f) };
+        queries.push_back(AABB{position, position + glm::vec3{1.0f, 2.0f, 1.0f}});
+    }
+
+    prt::vector<ColliderIndex> meshIndices;
+    prt::vector<ColliderIndex> capsuleIndices;
+    prt::vector<ColliderIndex> heightfieldIndices;
+    size_t dynamicHits = 0;
+    start = std::chrono::steady_clock::now();
+    for (AABB const & query : queries) {
+        meshIndices.resize(0);
+        dynamicTree.query(ColliderTag{}, query, meshIndices, capsuleIndices, heightfieldIndices, COLLIDER_TYPE_COLLIDE);
+        dynamicHits += meshIndices.size();
+    }
+    double dynamicTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    size_t staticHits = 0;
+    start = std::chrono::steady_clock::now();
+    for (AABB const & query : queries) {
+        meshIndices.resize(0);
+        staticTree.query(ColliderTag{}, query, meshIndices, capsuleIndices, heightfieldIndices, COLLIDER_TYPE_COLLIDE);
+        staticHits += meshIndices.size();
+    }
+    double staticTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    size_t dynamicRayHits = 0;
+    start = std::chrono::steady_clock::now();
+    for (AABB const & query : queries) {
+        dynamicTree.raycast(query.lowerBound, glm::vec3{0.6f, -0.64f, 0.48f}, 50.0f, [&](ColliderTag, float distance) {
+            ++dynamicRayHits;
+            return distance;
+        });
+    }
+    double dynamicRayTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    size_t staticRayHits = 0;
+    start = std::chrono::steady_clock::now();
+    for (AABB const & query : queries) {
+        staticTree.raycast(query.lowerBound, glm::vec3{0.6f, -0.64f, 0.48f}, 50.0f, [&](ColliderTag, float distance) {
+            ++staticRayHits;
+            return distance;
+        });
+    }
+    double staticRayTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    WARN("dynamic tree: " << dynamicTree.memoryUsage() / 1024 << " KiB, "
+         << dynamicTime / queries.size() << " us per query (" << dynamicHits << " hits), "
+         << dynamicRayTime / queries.size() << " us per raycast (" << dynamicRayHits << " leaves)");
+    WARN("static tree: " << staticTree.memoryUsage() / 1024 << " KiB, built in " << buildTime << " ms, "
+         << staticTime / queries.size() << " us per query (" << staticHits << " hits), "
+         << staticRayTime / queries.size() << " us per raycast (" << staticRayHits << " leaves)");
+
+    REQUIRE(staticTree.memoryUsage() < dynamicTree.memoryUsage());
+}
@@ -0,0 +1,51 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/system/thread/worker_pool.h"
+
+#include <atomic>
+
+TEST_CASE( "WorkerPool: Every thread of a run calls the job once", "[worker_pool]") {
+    WorkerPool pool;
+    pool.resize(3);
+    REQUIRE(pool.size() == 3);
+
+    std::atomic<uint32_t> calls[WorkerPool::maxWorkers + 1];
+    for (int run = 0; run < 100; ++run) {
+        size_t numThreads = 1 + run % 5;
+        for (std::atomic<uint32_t> & count : calls) {
+            count = 0;
+        }
+        std::function<void(size_t)> job = [&](size_t thread) {
+            ++calls[thread];
+        };
+        pool.run(job, numThreads);
+
+        // runs are limited to the workers and the caller
+        size_t expected = std::min(numThreads, size_t(4));
+        for (size_t i = 0; i <= WorkerPool::maxWorkers; ++i) {
+            REQUIRE(calls[i] == (i < expected ? 1u : 0u));
+        }
+    }
+}
+
+TEST_CASE( "WorkerPool: Resizing between runs", "[worker_pool]") {
+    WorkerPool pool;
+    std::atomic<uint32_t> sum{0};
+    std::function<void(size_t)> job = [&](size_t thread) {
+        sum += uint32_t(thread) + 1;
+    };
+
+    // without workers the caller runs the job alone
+    pool.run(job, 4);
+    REQUIRE(sum == 1);
+
+    pool.resize(2);
+    sum = 0;
+    pool.run(job, 3);
+    REQUIRE(sum == 1 + 2 + 3);
+
+    pool.resize(1);
+    sum = 0;
+    pool.run(job, 3);
+    REQUIRE(sum == 1 + 2);
+}
@@ -0,0 +1,78 @@
+#include "test/src/prt_test.h"
+#include <catch2/catch.hpp>
+#include "src/util/physics_util.h"
+
+namespace {
+    // triangle in the plane y = 0, facing up
+    glm::vec3 const p0{-10.0f, 0.0f, -10.0f};
+    glm::vec3 const p1{-10.0f, 0.0f,  10.0f};
+    glm::vec3 const p2{ 10.0f, 0.0f, -10.0f};
+}
+
+TEST_CASE( "physics_util: Sweep sphere against triangle", "[physics_util]") {
+    glm::vec3 const center{-2.0f, 5.0f, -2.0f};
+    glm::vec3 const down{0.0f, -10.0f, 0.0f};
+    float t;
+    glm::vec3 normal;
+    glm::vec3 point;
+
+    REQUIRE(physics_util::sweepCapsuleTriangle(center, center, 1.0f, down, p0, p1, p2, t, normal, point));
+    REQUIRE(t == Approx(0.4f).margin(0.001f));
+    REQUIRE(normal.y == Approx(1.0f).margin(0.001f));
+    REQUIRE(point.x == Approx(-2.0f).margin(0.001f));
+    REQUIRE(point.y == Approx(0.0f).margin(0.001f));
+    REQUIRE(point.z == Approx(-2.0f).margin(0.001f));
+
+    // the sphere passes beside the triangle
+    glm::vec3 const beside{5.0f, 5.0f, 5.0f};
+    REQUIRE_FALSE(physics_util::sweepCapsuleTriangle(beside, beside, 1.0f, down, p0, p1, p2, t, normal, point));
+
+    // the sphere stops short of the triangle
+    REQUIRE_FALSE(physics_util::sweepCapsuleTriangle(center, center, 1.0f, 0.35f * down, p0, p1, p2, t, normal, point));
+
+    // back faces do not block
+    glm::vec3 const below{-2.0f, -5.0f, -2.0f};
+    REQUIRE_FALSE(physics_util::sweepCapsuleTriangle(below, below, 1.0f, -down, p0, p1, p2, t, normal, point));
+}
+
+TEST_CASE( "physics_util: Sweep capsule against triangle edge", "[physics_util]") {
+    // a vertical capsule beside the hypotenuse x + z = 0 moves towards it
+    glm::vec3 const a{3.0f, -1.0f, 3.0f};
+    glm::vec3 const b{3.0f, 1.0f, 3.0f};
+    glm::vec3 const displacement = glm::vec3{-10.0f, -0.1f, -10.0f};
+    float t;
+    glm::vec3 normal;
+    glm::vec3 point;
+
+    REQUIRE(physics_util::sweepCapsuleTriangle(a, b, 0.5f, displacement, p0, p1, p2, t, normal, point));
+    // the axis ends up at a distance of the radius from the edge
+    glm::vec3 axis = a + t * displacement;
+    float distanceToEdge = (axis.x + axis.z) / glm::sqrt(2.0f);
+    REQUIRE(distanceToEdge == Approx(0.5f).margin(0.001f));
+    REQUIRE(point.x + point.z == Approx(0.0f).margin(0.001f));
+    REQUIRE(normal.x == Approx(glm::sqrt(0.5f)).margin(0.001f));
+    REQUIRE(normal.z == Approx(glm::sqrt(0.5f)).margin(0.001f));
+}
+
+TEST_CASE( "physics_util: Sweep starting in overlap", "[physics_util]") {
+    glm::vec3 const a{0.0f, 0.5f, 0.0f};
+    glm::vec3 const b{0.0f, 1.5f, 0.0f};
+    float t;
+    glm::vec3 normal;
+    glm::vec3 point;
+
+    // penetrating capsules moving further in hit at once
+    REQUIRE(physics_util::sweepCapsuleTriangle(a, b, 1.0f, glm::vec3{0.0f, -1.0f, 0.0f}, p0, p1, p2, t, normal, point));
+    REQUIRE(t == 0.0f);
+    REQUIRE(normal.y == Approx(1.0f).margin(0.001f));
+    REQUIRE(physics_util::sweepCapsuleTriangle(a, b, 1.0f, glm::vec3{1.0f, -0.5f, 0.0f}, p0, p1, p2, t, normal, point));
+    REQUIRE(t == 0.0f);
+
+    // even when the segment crosses the triangle
+    glm::vec3 const c{0.0f, -0.5f, 0.0f};
+    REQUIRE(physics_util::sweepCapsuleTriangle(c, b, 0.1f, glm::vec3{0.0f, -1.0f, 0.0f}, p0, p1, p2, t, normal, point));
+    REQUIRE(t == 0.0f);
+
+    // but may move out of the triangle
+    REQUIRE_FALSE(physics_util::sweepCapsuleTriangle(a, b, 1.0f, glm::vec3{0.0f, 1.0f, 0.0f}, p0, p1, p2, t, normal, point));
+}